@@ -11,6 +11,8 @@ gcc -o ../cinegestion.exe ^
     src/menu.c ^
     src/utils/logger.c ^
     src/utils/memory.c ^
+    src/utils/result_set.c ^
+    src/utils/timer_wheel.c ^
     src/models/usuario.c ^
     src/models/pelicula.c ^
     src/models/sala.c ^
@@ -18,10 +20,16 @@ gcc -o ../cinegestion.exe ^
     src/models/sesion.c ^
     src/models/billete.c ^
     src/models/venta.c ^
+    src/models/ocupacion.c ^
+    src/models/horario.c ^
+    src/models/titulos.c ^
+    src/models/generos.c ^
+    src/models/retencion.c ^
     src/test_data.c ^
     lib/sqlite3.c ^
     -I. ^
-    -Ilib
+    -Ilib ^
+    -lpthread
 
 cd ..
 
@@ -43,6 +51,11 @@ if %ERRORLEVEL% EQU 0 (
         echo [database] >> hito2\config\config.ini
         echo db_path=data/cine.db >> hito2\config\config.ini
         echo db_backup_path=data/backup/cine_backup.db >> hito2\config\config.ini
+        echo journal_mode=WAL >> hito2\config\config.ini
+        echo synchronous=NORMAL >> hito2\config\config.ini
+        echo cache_size=-8000 >> hito2\config\config.ini
+        echo mmap_size=268435456 >> hito2\config\config.ini
+        echo temp_store=MEMORY >> hito2\config\config.ini
         echo. >> hito2\config\config.ini
         echo [logs] >> hito2\config\config.ini
         echo log_path=logs/system.log >> hito2\config\config.ini
@@ -51,6 +64,11 @@ if %ERRORLEVEL% EQU 0 (
         echo [ui] >> hito2\config\config.ini
         echo max_menu_items=10 >> hito2\config\config.ini
         echo clear_screen=true >> hito2\config\config.ini
+        echo. >> hito2\config\config.ini
+        echo [server] >> hito2\config\config.ini
+        echo port=8080 >> hito2\config\config.ini
+        echo worker_threads=8 >> hito2\config\config.ini
+        echo group_commit_ms=2 >> hito2\config\config.ini
     )
     
     if not exist hito2\config\admin.ini (
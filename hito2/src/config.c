@@ -1,8 +1,10 @@
 #include "config.h"
+#include "database.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdarg.h>
 
 // Variables estáticas globales para almacenar las configuraciones
 static Config g_config;
@@ -67,10 +69,19 @@ bool load_config(const char* config_path, Config* config) {
     strcpy(config->version, "1.0");
     strcpy(config->db_path, "data/cine.db");
     strcpy(config->db_backup_path, "data/backup/cine_backup.db");
+    strcpy(config->db_journal_mode, "WAL");
+    strcpy(config->db_synchronous, "NORMAL");
+    config->db_cache_size = -8000;
+    config->db_mmap_size = 268435456;
+    strcpy(config->db_temp_store, "MEMORY");
     strcpy(config->log_path, "logs/system.log");
     strcpy(config->log_level, "INFO");
+    strcpy(config->log_overflow, "DROP");
     config->max_menu_items = 10;
     config->clear_screen = true;
+    config->server_port = 8080;
+    config->worker_threads = 8;
+    config->group_commit_ms = 2;
     
     while (fgets(line, sizeof(line), file)) {
         // Eliminar espacios y saltos de línea
@@ -103,6 +114,16 @@ bool load_config(const char* config_path, Config* config) {
                 strncpy(config->db_path, value, sizeof(config->db_path) - 1);
             } else if (get_value(line, "db_backup_path", value, sizeof(value))) {
                 strncpy(config->db_backup_path, value, sizeof(config->db_backup_path) - 1);
+            } else if (get_value(line, "journal_mode", value, sizeof(value))) {
+                strncpy(config->db_journal_mode, value, sizeof(config->db_journal_mode) - 1);
+            } else if (get_value(line, "synchronous", value, sizeof(value))) {
+                strncpy(config->db_synchronous, value, sizeof(config->db_synchronous) - 1);
+            } else if (get_value(line, "cache_size", value, sizeof(value))) {
+                config->db_cache_size = atoi(value);
+            } else if (get_value(line, "mmap_size", value, sizeof(value))) {
+                config->db_mmap_size = atoll(value);
+            } else if (get_value(line, "temp_store", value, sizeof(value))) {
+                strncpy(config->db_temp_store, value, sizeof(config->db_temp_store) - 1);
             }
         } else if (strcmp(section, "logs") == 0) {
             char value[100];
@@ -110,6 +131,8 @@ bool load_config(const char* config_path, Config* config) {
                 strncpy(config->log_path, value, sizeof(config->log_path) - 1);
             } else if (get_value(line, "log_level", value, sizeof(value))) {
                 strncpy(config->log_level, value, sizeof(config->log_level) - 1);
+            } else if (get_value(line, "log_overflow", value, sizeof(value))) {
+                strncpy(config->log_overflow, value, sizeof(config->log_overflow) - 1);
             }
         } else if (strcmp(section, "ui") == 0) {
             char value[100];
@@ -122,6 +145,15 @@ bool load_config(const char* config_path, Config* config) {
                     config->clear_screen = false;
                 }
             }
+        } else if (strcmp(section, "server") == 0) {
+            char value[100];
+            if (get_value(line, "port", value, sizeof(value))) {
+                config->server_port = atoi(value);
+            } else if (get_value(line, "worker_threads", value, sizeof(value))) {
+                config->worker_threads = atoi(value);
+            } else if (get_value(line, "group_commit_ms", value, sizeof(value))) {
+                config->group_commit_ms = atoi(value);
+            }
         }
     }
     
@@ -211,10 +243,19 @@ Config* get_config() {
             strcpy(config.version, "1.0");
             strcpy(config.db_path, "data/cine.db");
             strcpy(config.db_backup_path, "data/backup/cine_backup.db");
+            strcpy(config.db_journal_mode, "WAL");
+            strcpy(config.db_synchronous, "NORMAL");
+            config.db_cache_size = -8000;
+            config.db_mmap_size = 268435456;
+            strcpy(config.db_temp_store, "MEMORY");
             strcpy(config.log_path, "logs/system.log");
             strcpy(config.log_level, "INFO");
+            strcpy(config.log_overflow, "DROP");
             config.max_menu_items = 10;
             config.clear_screen = true;
+            config.server_port = 8080;
+            config.worker_threads = 8;
+            config.group_commit_ms = 2;
             
             // Guardar valores por defecto en la estructura global
             g_config_loaded = true;
@@ -247,6 +288,23 @@ AdminConfig* get_admin_config() {
     return &g_admin_config;
 }
 
+// Comprobar que value es uno de los valores de la lista (terminada en NULL)
+static bool config_valor_permitido(const char* value, ...) {
+    va_list valores;
+    va_start(valores, value);
+    
+    const char* permitido;
+    while ((permitido = va_arg(valores, const char*)) != NULL) {
+        if (strcmp(value, permitido) == 0) {
+            va_end(valores);
+            return true;
+        }
+    }
+    
+    va_end(valores);
+    return false;
+}
+
 // Validar la configuración del sistema
 bool validate_config(Config* config) {
     // Validar que los campos obligatorios no estén vacíos
@@ -267,8 +325,27 @@ bool validate_config(Config* config) {
         return false;
     }
     
+    if (!config_valor_permitido(config->log_overflow, "DROP", "BLOCK", NULL)) {
+        return false;
+    }
+    
+    // Validar el perfil de SQLite (los valores se copian en sentencias PRAGMA)
+    if (!config_valor_permitido(config->db_journal_mode,
+                                "DELETE", "TRUNCATE", "PERSIST", "MEMORY", "WAL", "OFF", NULL) ||
+        !config_valor_permitido(config->db_synchronous,
+                                "OFF", "NORMAL", "FULL", "EXTRA", NULL) ||
+        !config_valor_permitido(config->db_temp_store,
+                                "DEFAULT", "FILE", "MEMORY", NULL) ||
+        config->db_mmap_size < 0) {
+        return false;
+    }
+    
     // Validar valores numéricos
-    if (config->max_menu_items <= 0) {
+    if (config->max_menu_items <= 0 ||
+        config->server_port <= 0 ||
+        config->worker_threads <= 0 ||
+        config->worker_threads > DB_MAX_READERS ||
+        config->group_commit_ms < 0) {
         return false;
     }
     
@@ -300,10 +377,19 @@ void print_config(Config* config) {
     printf("Version: %s\n", config->version);
     printf("DB Path: %s\n", config->db_path);
     printf("DB Backup Path: %s\n", config->db_backup_path);
+    printf("DB Journal Mode: %s\n", config->db_journal_mode);
+    printf("DB Synchronous: %s\n", config->db_synchronous);
+    printf("DB Cache Size: %d\n", config->db_cache_size);
+    printf("DB Mmap Size: %lld\n", config->db_mmap_size);
+    printf("DB Temp Store: %s\n", config->db_temp_store);
     printf("Log Path: %s\n", config->log_path);
     printf("Log Level: %s\n", config->log_level);
+    printf("Log Overflow: %s\n", config->log_overflow);
     printf("Max Menu Items: %d\n", config->max_menu_items);
     printf("Clear Screen: %s\n", config->clear_screen ? "true" : "false");
+    printf("Server Port: %d\n", config->server_port);
+    printf("Worker Threads: %d\n", config->worker_threads);
+    printf("Group Commit: %d ms\n", config->group_commit_ms);
     printf("==============================\n");
 }
 
@@ -334,17 +420,29 @@ bool save_config(const char* config_path, Config* config) {
     // Escribir sección de base de datos
     fprintf(file, "[database]\n");
     fprintf(file, "db_path=%s\n", config->db_path);
-    fprintf(file, "db_backup_path=%s\n\n", config->db_backup_path);
+    fprintf(file, "db_backup_path=%s\n", config->db_backup_path);
+    fprintf(file, "journal_mode=%s\n", config->db_journal_mode);
+    fprintf(file, "synchronous=%s\n", config->db_synchronous);
+    fprintf(file, "cache_size=%d\n", config->db_cache_size);
+    fprintf(file, "mmap_size=%lld\n", config->db_mmap_size);
+    fprintf(file, "temp_store=%s\n\n", config->db_temp_store);
     
     // Escribir sección de logs
     fprintf(file, "[logs]\n");
     fprintf(file, "log_path=%s\n", config->log_path);
-    fprintf(file, "log_level=%s\n\n", config->log_level);
+    fprintf(file, "log_level=%s\n", config->log_level);
+    fprintf(file, "log_overflow=%s\n\n", config->log_overflow);
     
     // Escribir sección de UI
     fprintf(file, "[ui]\n");
     fprintf(file, "max_menu_items=%d\n", config->max_menu_items);
-    fprintf(file, "clear_screen=%s\n", config->clear_screen ? "true" : "false");
+    fprintf(file, "clear_screen=%s\n\n", config->clear_screen ? "true" : "false");
+    
+    // Escribir sección del servidor
+    fprintf(file, "[server]\n");
+    fprintf(file, "port=%d\n", config->server_port);
+    fprintf(file, "worker_threads=%d\n", config->worker_threads);
+    fprintf(file, "group_commit_ms=%d\n", config->group_commit_ms);
     
     fclose(file);
     return true;
@@ -13,13 +13,26 @@ typedef struct {
     char db_path[100];
     char db_backup_path[100];
     
+    // Perfil de rendimiento de SQLite (se aplica con PRAGMA al abrir)
+    char db_journal_mode[10];       // DELETE, TRUNCATE, PERSIST, MEMORY, WAL, OFF (el servidor exige WAL)
+    char db_synchronous[10];        // OFF, NORMAL, FULL, EXTRA
+    int db_cache_size;              // Páginas, o KiB si es negativo
+    long long db_mmap_size;         // Bytes de E/S mapeada en memoria (0 = desactivada)
+    char db_temp_store[10];         // DEFAULT, FILE, MEMORY
+    
     // Logs
     char log_path[100];
     char log_level[10];
+    char log_overflow[10];          // DROP o BLOCK: qué hacer con el búfer de log lleno
     
     // UI
     int max_menu_items;
     bool clear_screen;
+    
+    // Server
+    int server_port;
+    int worker_threads;     // Como mucho DB_MAX_READERS (una conexión de lectura por hilo)
+    int group_commit_ms;    // Ventana para agrupar ventas en una transacción
 } Config;
 
 // Estructura para almacenar configuración del administrador
@@ -3,9 +3,89 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
+#include <errno.h>
+#include <time.h>
 
 // Instancia global de la base de datos
-static Database g_database = {NULL, NULL, false};
+static Database g_database = {{NULL, {NULL}, 0}, NULL, false};
+
+// Ruta del fichero, para abrir las conexiones de lectura
+static char g_db_path[512];
+
+// Conexión que usa el hilo actual (NULL: la principal)
+static _Thread_local DbConnection* t_connection = NULL;
+
+// Milisegundos que una conexión espera a que se libere un bloqueo
+#define DB_BUSY_TIMEOUT_MS 5000
+
+// Conexiones de lectura abiertas, para cerrarlas en db_close
+static DbConnection* g_readers[DB_MAX_READERS];
+static int g_num_readers = 0;
+static pthread_mutex_t g_readers_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Operación encolada para el hilo escritor. Vive en la pila del hilo que la
+// envía, que espera hasta que done se pone a true
+typedef struct DbWriteTask {
+    bool (*operation)(void* arg);
+    void (*undo)(void* arg);
+    void* arg;
+    bool grouped;           // Puede compartir transacción con otras tareas
+    bool result;
+    bool done;
+    struct DbWriteTask* next;
+} DbWriteTask;
+
+// Cola del hilo escritor
+static pthread_t g_writer_thread;
+static bool g_writer_running = false;
+static bool g_writer_stopping = false;
+static DbWriteTask* g_write_head = NULL;
+static DbWriteTask* g_write_tail = NULL;
+static pthread_mutex_t g_write_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_write_pending = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t g_write_done = PTHREAD_COND_INITIALIZER;
+
+// Máximo de operaciones agrupadas en una misma transacción
+#define DB_MAX_GROUP 64
+
+// Milisegundos que el escritor espera a que lleguen más operaciones
+// agrupables antes de confirmar el grupo (se lee de la configuración)
+static int g_group_commit_ms = 0;
+
+// Máximo de columnas de un mapa de filas
+#define DB_MAX_COLUMNAS 32
+
+// Migraciones del esquema. La versión aplicada se guarda en PRAGMA
+// user_version y la entrada i lleva la base de datos de la versión i a la i + 1.
+// Las migraciones ya publicadas no se modifican; los cambios van en una nueva
+static const char* const g_migrations[] = {
+    // 1: índices para las búsquedas de los modelos. Billete(Sesion_ID) no
+    // hace falta: lo cubre el índice de UNIQUE(Sesion_ID, Asiento_ID)
+    "CREATE INDEX IF NOT EXISTS idx_sesion_sala_inicio ON Sesion(Sala_ID, HoraInicio);"
+    "CREATE INDEX IF NOT EXISTS idx_sesion_pelicula ON Sesion(Pelicula_ID, HoraInicio);"
+    "CREATE INDEX IF NOT EXISTS idx_sesion_inicio ON Sesion(HoraInicio);"
+    "CREATE INDEX IF NOT EXISTS idx_venta_usuario ON Venta(Usuario_ID, Fecha);"
+    "CREATE INDEX IF NOT EXISTS idx_venta_billetes_billete ON Venta_Billetes(Billete_ID);",
+    
+    // 2: horas de las sesiones como enteros (segundos desde la época, sin
+    // zona horaria) en lugar de texto, con los índices rehechos sobre ellas
+    "ALTER TABLE Sesion ADD COLUMN Inicio INTEGER NOT NULL DEFAULT 0;"
+    "ALTER TABLE Sesion ADD COLUMN Fin INTEGER NOT NULL DEFAULT 0;"
+    "UPDATE Sesion SET "
+    "Inicio = COALESCE(CAST(strftime('%s', HoraInicio) AS INTEGER), 0), "
+    "Fin = COALESCE(CAST(strftime('%s', HoraFin) AS INTEGER), 0);"
+    "DROP INDEX IF EXISTS idx_sesion_sala_inicio;"
+    "DROP INDEX IF EXISTS idx_sesion_pelicula;"
+    "DROP INDEX IF EXISTS idx_sesion_inicio;"
+    "ALTER TABLE Sesion DROP COLUMN HoraInicio;"
+    "ALTER TABLE Sesion DROP COLUMN HoraFin;"
+    "CREATE INDEX idx_sesion_sala_inicio ON Sesion(Sala_ID, Inicio);"
+    "CREATE INDEX idx_sesion_pelicula ON Sesion(Pelicula_ID, Inicio);"
+    "CREATE INDEX idx_sesion_inicio ON Sesion(Inicio);",
+};
+
+#define DB_NUM_MIGRATIONS ((int)(sizeof(g_migrations) / sizeof(g_migrations[0])))
 
 // Inicializar la base de datos
 bool db_init(const char* db_path) {
@@ -25,30 +105,94 @@ bool db_init(const char* db_path) {
     return true;
 }
 
+// Aplicar a una conexión el perfil de rendimiento de config.ini. Las
+// conexiones de lectura solo usan las opciones que afectan a las consultas
+static void db_apply_profile(sqlite3* db, bool writer) {
+    Config* config = get_config();
+    if (!config || !validate_config(config)) {
+        fprintf(stderr, "Aviso: Perfil de SQLite no válido; se usan los valores por defecto.\n");
+        return;
+    }
+    
+    char sql[256];
+    if (writer) {
+        snprintf(sql, sizeof(sql),
+                 "PRAGMA journal_mode=%s; PRAGMA synchronous=%s;",
+                 config->db_journal_mode, config->db_synchronous);
+        if (sqlite3_exec(db, sql, NULL, NULL, NULL) != SQLITE_OK) {
+            fprintf(stderr, "Aviso: No se pudo aplicar el perfil de SQLite: %s\n", sqlite3_errmsg(db));
+        }
+    }
+    
+    snprintf(sql, sizeof(sql),
+             "PRAGMA cache_size=%d; PRAGMA mmap_size=%lld; PRAGMA temp_store=%s;",
+             config->db_cache_size, config->db_mmap_size, config->db_temp_store);
+    if (sqlite3_exec(db, sql, NULL, NULL, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Aviso: No se pudo aplicar el perfil de SQLite: %s\n", sqlite3_errmsg(db));
+    }
+}
+
 // Abrir la conexión a la base de datos
 bool db_open(const char* db_path) {
     if (g_database.connected) {
         return true; // Ya está conectado
     }
     
-    int rc = sqlite3_open(db_path, &g_database.db);
+    int rc = sqlite3_open(db_path, &g_database.connection.db);
     if (rc != SQLITE_OK) {
-        fprintf(stderr, "Error al abrir la base de datos: %s\n", sqlite3_errmsg(g_database.db));
-        sqlite3_close(g_database.db);
-        g_database.db = NULL;
+        fprintf(stderr, "Error al abrir la base de datos: %s\n", sqlite3_errmsg(g_database.connection.db));
+        sqlite3_close(g_database.connection.db);
+        g_database.connection.db = NULL;
         return false;
     }
     
+    sqlite3_busy_timeout(g_database.connection.db, DB_BUSY_TIMEOUT_MS);
+    snprintf(g_db_path, sizeof(g_db_path), "%s", db_path);
+    
+    db_apply_profile(g_database.connection.db, true);
+    
     g_database.connected = true;
     return true;
 }
 
+// Liberar las sentencias preparadas de una conexión y cerrarla
+static void db_connection_close(DbConnection* connection) {
+    for (int i = 0; i < STMT_TOTAL; i++) {
+        if (connection->statements[i]) {
+            sqlite3_finalize(connection->statements[i]);
+            connection->statements[i] = NULL;
+        }
+    }
+    
+    if (connection->db) {
+        sqlite3_close(connection->db);
+        connection->db = NULL;
+    }
+    
+    connection->transaction_depth = 0;
+}
+
+// Conexión del hilo actual
+static DbConnection* db_current() {
+    return t_connection ? t_connection : &g_database.connection;
+}
+
 // Cerrar la conexión a la base de datos
 void db_close() {
-    if (g_database.db) {
-        sqlite3_close(g_database.db);
-        g_database.db = NULL;
+    db_pool_stop();
+    
+    // Las conexiones de lectura que no se cerraron al terminar sus hilos
+    pthread_mutex_lock(&g_readers_mutex);
+    for (int i = 0; i < g_num_readers; i++) {
+        db_connection_close(g_readers[i]);
+        free(g_readers[i]);
+        g_readers[i] = NULL;
     }
+    g_num_readers = 0;
+    pthread_mutex_unlock(&g_readers_mutex);
+    
+    t_connection = NULL;
+    db_connection_close(&g_database.connection);
     
     if (g_database.error_message) {
         sqlite3_free(g_database.error_message);
@@ -60,13 +204,13 @@ void db_close() {
 
 // Ejecutar una consulta SQL sin resultados
 bool db_execute(const char* sql) {
-    if (!g_database.connected || !g_database.db) {
+    if (!g_database.connected || !g_database.connection.db) {
         fprintf(stderr, "Error: No hay conexión a la base de datos.\n");
         return false;
     }
     
     char* error_message = NULL;
-    int rc = sqlite3_exec(g_database.db, sql, NULL, NULL, &error_message);
+    int rc = sqlite3_exec(db_current()->db, sql, NULL, NULL, &error_message);
     
     if (rc != SQLITE_OK) {
         fprintf(stderr, "Error SQL: %s\n", error_message);
@@ -77,6 +221,50 @@ bool db_execute(const char* sql) {
     return true;
 }
 
+// Aplicar las migraciones del esquema que aún no tenga la base de datos
+static bool db_migrate() {
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(g_database.connection.db, "PRAGMA user_version;", -1, &stmt, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Error al leer la versión del esquema: %s\n", sqlite3_errmsg(g_database.connection.db));
+        return false;
+    }
+    
+    int version = 0;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        version = sqlite3_column_int(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    
+    if (version >= DB_NUM_MIGRATIONS) {
+        return true;
+    }
+    
+    for (; version < DB_NUM_MIGRATIONS; version++) {
+        // Cada migración y su número de versión se confirman juntos
+        char sql_version[64];
+        snprintf(sql_version, sizeof(sql_version), "PRAGMA user_version = %d;", version + 1);
+        
+        if (!db_begin_transaction()) {
+            return false;
+        }
+        
+        if (!db_execute(g_migrations[version]) || !db_execute(sql_version)) {
+            fprintf(stderr, "Error: No se pudo migrar el esquema a la versión %d.\n", version + 1);
+            db_rollback_transaction();
+            return false;
+        }
+        
+        if (!db_commit_transaction()) {
+            db_rollback_transaction();
+            return false;
+        }
+    }
+    
+    // Actualizar las estadísticas para que el planificador use los índices nuevos
+    db_execute("PRAGMA optimize;");
+    return true;
+}
+
 // Crear las tablas de la base de datos si no existen
 bool db_create_tables() {
     // Tabla Usuarios
@@ -174,15 +362,19 @@ bool db_create_tables() {
         return false;
     }
     
+    if (!db_migrate()) {
+        return false;
+    }
+    
     // Verificar si existe el usuario administrador por defecto
     const char* sql_check_admin = 
         "SELECT COUNT(*) FROM Usuarios WHERE TipoUsuario = 'Administrador';";
     
     sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(g_database.db, sql_check_admin, -1, &stmt, NULL);
+    int rc = sqlite3_prepare_v2(g_database.connection.db, sql_check_admin, -1, &stmt, NULL);
     
     if (rc != SQLITE_OK) {
-        fprintf(stderr, "Error al preparar la consulta: %s\n", sqlite3_errmsg(g_database.db));
+        fprintf(stderr, "Error al preparar la consulta: %s\n", sqlite3_errmsg(g_database.connection.db));
         return false;
     }
     
@@ -217,7 +409,7 @@ bool db_create_tables() {
 
 // Realizar backup de la base de datos
 bool db_backup(const char* backup_path) {
-    if (!g_database.connected || !g_database.db) {
+    if (!g_database.connected || !g_database.connection.db) {
         fprintf(stderr, "Error: No hay conexión a la base de datos.\n");
         return false;
     }
@@ -231,7 +423,7 @@ bool db_backup(const char* backup_path) {
         return false;
     }
     
-    sqlite3_backup *backup = sqlite3_backup_init(backup_db, "main", g_database.db, "main");
+    sqlite3_backup *backup = sqlite3_backup_init(backup_db, "main", g_database.connection.db, "main");
     
     if (backup) {
         sqlite3_backup_step(backup, -1);
@@ -251,7 +443,7 @@ bool db_backup(const char* backup_path) {
 
 // Restaurar la base de datos desde un backup
 bool db_restore(const char* backup_path) {
-    if (!g_database.connected || !g_database.db) {
+    if (!g_database.connected || !g_database.connection.db) {
         fprintf(stderr, "Error: No hay conexión a la base de datos.\n");
         return false;
     }
@@ -265,18 +457,18 @@ bool db_restore(const char* backup_path) {
         return false;
     }
     
-    sqlite3_backup *backup = sqlite3_backup_init(g_database.db, "main", backup_db, "main");
+    sqlite3_backup *backup = sqlite3_backup_init(g_database.connection.db, "main", backup_db, "main");
     
     if (backup) {
         sqlite3_backup_step(backup, -1);
         sqlite3_backup_finish(backup);
     }
     
-    rc = sqlite3_errcode(g_database.db);
+    rc = sqlite3_errcode(g_database.connection.db);
     sqlite3_close(backup_db);
     
     if (rc != SQLITE_OK) {
-        fprintf(stderr, "Error en la restauración: %s\n", sqlite3_errmsg(g_database.db));
+        fprintf(stderr, "Error en la restauración: %s\n", sqlite3_errmsg(g_database.connection.db));
         return false;
     }
     
@@ -290,13 +482,13 @@ Database* get_database() {
 
 // Ejecutar una consulta SQL con callback para procesar resultados
 bool db_query(const char* sql, int (*callback)(void*, int, char**, char**), void* data) {
-    if (!g_database.connected || !g_database.db) {
+    if (!g_database.connected || !g_database.connection.db) {
         fprintf(stderr, "Error: No hay conexión a la base de datos.\n");
         return false;
     }
     
     char* error_message = NULL;
-    int rc = sqlite3_exec(g_database.db, sql, callback, data, &error_message);
+    int rc = sqlite3_exec(db_current()->db, sql, callback, data, &error_message);
     
     if (rc != SQLITE_OK) {
         fprintf(stderr, "Error SQL: %s\n", error_message);
@@ -307,37 +499,644 @@ bool db_query(const char* sql, int (*callback)(void*, int, char**, char**), void
     return true;
 }
 
-// Iniciar una transacción
+// Obtener una sentencia preparada de la caché
+sqlite3_stmt* db_statement(StatementId id, const char* sql) {
+    if (!g_database.connected || !g_database.connection.db) {
+        fprintf(stderr, "Error: No hay conexión a la base de datos.\n");
+        return NULL;
+    }
+    
+    if (id < 0 || id >= STMT_TOTAL) {
+        fprintf(stderr, "Error: Identificador de consulta inválido: %d\n", id);
+        return NULL;
+    }
+    
+    DbConnection* connection = db_current();
+    sqlite3_stmt* stmt = connection->statements[id];
+    
+    if (!stmt) {
+        int rc = sqlite3_prepare_v3(connection->db, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt, NULL);
+        
+        if (rc != SQLITE_OK) {
+            fprintf(stderr, "Error al preparar la consulta: %s\n", sqlite3_errmsg(connection->db));
+            return NULL;
+        }
+        
+        connection->statements[id] = stmt;
+    } else {
+        // Descartar el estado de la ejecución anterior
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+    }
+    
+    return stmt;
+}
+
+// Comprobar el resultado de un enlace de parámetro
+static bool db_bind_result(sqlite3_stmt* stmt, int rc, int index) {
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Error al enlazar el parámetro %d: %s\n", index, sqlite3_errmsg(sqlite3_db_handle(stmt)));
+        return false;
+    }
+    
+    return true;
+}
+
+// Enlazar un entero
+bool db_bind_int(sqlite3_stmt* stmt, int index, int value) {
+    if (!stmt) {
+        return false;
+    }
+    
+    return db_bind_result(stmt, sqlite3_bind_int(stmt, index, value), index);
+}
+
+// Enlazar un entero de 64 bits
+bool db_bind_int64(sqlite3_stmt* stmt, int index, int64_t value) {
+    if (!stmt) {
+        return false;
+    }
+    
+    return db_bind_result(stmt, sqlite3_bind_int64(stmt, index, (sqlite3_int64)value), index);
+}
+
+// Enlazar un número real
+bool db_bind_double(sqlite3_stmt* stmt, int index, double value) {
+    if (!stmt) {
+        return false;
+    }
+    
+    return db_bind_result(stmt, sqlite3_bind_double(stmt, index, value), index);
+}
+
+// Enlazar una cadena (SQLite guarda su propia copia)
+bool db_bind_text(sqlite3_stmt* stmt, int index, const char* value) {
+    if (!stmt) {
+        return false;
+    }
+    
+    return db_bind_result(stmt, sqlite3_bind_text(stmt, index, value ? value : "", -1, SQLITE_TRANSIENT), index);
+}
+
+// Ejecutar una sentencia sin resultados
+bool db_statement_execute(sqlite3_stmt* stmt) {
+    if (!stmt) {
+        return false;
+    }
+    
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        // Se ignoran las filas
+    }
+    
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Error SQL: %s\n", sqlite3_errmsg(sqlite3_db_handle(stmt)));
+        sqlite3_reset(stmt);
+        return false;
+    }
+    
+    sqlite3_reset(stmt);
+    return true;
+}
+
+// Buscar el índice de cada columna del mapa en el resultado (-1 si no está)
+static bool db_resolve_columns(sqlite3_stmt* stmt, const DbRowMap* map, int* indexes) {
+    if (map->num_columns > DB_MAX_COLUMNAS) {
+        fprintf(stderr, "Error: El mapa de filas tiene demasiadas columnas (%d)\n", map->num_columns);
+        return false;
+    }
+    
+    int num_columnas = sqlite3_column_count(stmt);
+    
+    for (int i = 0; i < map->num_columns; i++) {
+        indexes[i] = -1;
+        
+        for (int j = 0; j < num_columnas; j++) {
+            if (strcmp(sqlite3_column_name(stmt, j), map->columns[i].name) == 0) {
+                indexes[i] = j;
+                break;
+            }
+        }
+    }
+    
+    return true;
+}
+
+// Copiar la fila actual de la sentencia en la estructura
+static void db_copy_row(sqlite3_stmt* stmt, const DbRowMap* map, const int* indexes, void* row) {
+    for (int i = 0; i < map->num_columns; i++) {
+        if (indexes[i] < 0) {
+            continue;
+        }
+        
+        const DbColumn* column = &map->columns[i];
+        char* field = (char*)row + column->offset;
+        
+        switch (column->type) {
+            case DB_COLUMN_INT:
+                *(int*)field = sqlite3_column_int(stmt, indexes[i]);
+                break;
+            case DB_COLUMN_INT64:
+                *(int64_t*)field = (int64_t)sqlite3_column_int64(stmt, indexes[i]);
+                break;
+            case DB_COLUMN_DOUBLE:
+                *(double*)field = sqlite3_column_double(stmt, indexes[i]);
+                break;
+            case DB_COLUMN_TEXT: {
+                const char* text = (const char*)sqlite3_column_text(stmt, indexes[i]);
+                size_t length = text ? (size_t)sqlite3_column_bytes(stmt, indexes[i]) : 0;
+                
+                if (length >= column->size) {
+                    length = column->size - 1;
+                }
+                
+                if (length > 0) {
+                    memcpy(field, text, length);
+                }
+                field[length] = '\0';
+                break;
+            }
+            case DB_COLUMN_ENUM: {
+                const char* text = (const char*)sqlite3_column_text(stmt, indexes[i]);
+                *(int*)field = column->to_enum(text ? text : "");
+                break;
+            }
+        }
+    }
+}
+
+// Leer la primera fila del resultado
+bool db_statement_read(sqlite3_stmt* stmt, const DbRowMap* map, void* row) {
+    if (!stmt) {
+        return false;
+    }
+    
+    int indexes[DB_MAX_COLUMNAS];
+    if (!db_resolve_columns(stmt, map, indexes)) {
+        return false;
+    }
+    
+    int rc = sqlite3_step(stmt);
+    
+    if (rc == SQLITE_ROW) {
+        db_copy_row(stmt, map, indexes, row);
+    } else if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Error SQL: %s\n", sqlite3_errmsg(sqlite3_db_handle(stmt)));
+        sqlite3_reset(stmt);
+        return false;
+    }
+    
+    sqlite3_reset(stmt);
+    return true;
+}
+
+// Leer todas las filas del resultado
+bool db_statement_read_all(sqlite3_stmt* stmt, const DbRowMap* map, ResultSet* result) {
+    if (!stmt) {
+        return false;
+    }
+    
+    int indexes[DB_MAX_COLUMNAS];
+    if (!db_resolve_columns(stmt, map, indexes)) {
+        return false;
+    }
+    
+    bool exito = true;
+    int rc;
+    
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        void* row = result_set_add_row(result);
+        if (!row) {
+            exito = false;
+            break;
+        }
+        
+        db_copy_row(stmt, map, indexes, row);
+    }
+    
+    if (exito && rc != SQLITE_DONE) {
+        fprintf(stderr, "Error SQL: %s\n", sqlite3_errmsg(sqlite3_db_handle(stmt)));
+        exito = false;
+    }
+    
+    sqlite3_reset(stmt);
+    return exito;
+}
+
+// Ejecutar una sentencia que devuelve un único entero
+bool db_statement_int(sqlite3_stmt* stmt, int* value) {
+    if (!stmt) {
+        return false;
+    }
+    
+    int rc = sqlite3_step(stmt);
+    
+    if (rc == SQLITE_ROW) {
+        *value = sqlite3_column_int(stmt, 0);
+    } else if (rc == SQLITE_DONE) {
+        *value = 0;
+    } else {
+        fprintf(stderr, "Error SQL: %s\n", sqlite3_errmsg(sqlite3_db_handle(stmt)));
+        sqlite3_reset(stmt);
+        return false;
+    }
+    
+    sqlite3_reset(stmt);
+    return true;
+}
+
+// Sacar la primera tarea de la cola (con g_write_mutex tomado)
+static DbWriteTask* db_write_pop() {
+    DbWriteTask* task = g_write_head;
+    g_write_head = task->next;
+    if (!g_write_head) {
+        g_write_tail = NULL;
+    }
+    return task;
+}
+
+// Completar group[0] con las tareas agrupables que ya estén en la cola o que
+// lleguen antes de que acabe la ventana (con g_write_mutex tomado). Se para
+// al encontrar una tarea que no se puede agrupar, para no adelantarla
+static int db_write_collect_group(DbWriteTask** group) {
+    int count = 1;
+    bool window_closed = g_group_commit_ms <= 0;
+    
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += (long)g_group_commit_ms * 1000000L;
+    deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+    deadline.tv_nsec %= 1000000000L;
+    
+    while (count < DB_MAX_GROUP) {
+        if (g_write_head && g_write_head->grouped) {
+            group[count++] = db_write_pop();
+        } else if (g_write_head || g_writer_stopping || window_closed) {
+            break;
+        } else if (pthread_cond_timedwait(&g_write_pending, &g_write_mutex, &deadline) == ETIMEDOUT) {
+            // Última pasada para recoger lo que haya llegado justo al final
+            window_closed = true;
+        }
+    }
+    
+    return count;
+}
+
+// Ejecutar un grupo de operaciones en una sola transacción. Cada operación va
+// en su propio SAVEPOINT para que un fallo solo deshaga sus cambios
+static void db_write_run_group(DbWriteTask** group, int count) {
+    DbConnection* connection = db_current();
+    
+    if (count == 1 || !db_begin_transaction()) {
+        // Sin grupo, cada operación abre y confirma su propia transacción
+        for (int i = 0; i < count; i++) {
+            group[i]->result = group[i]->operation(group[i]->arg);
+        }
+        return;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        DbWriteTask* task = group[i];
+        
+        if (!db_begin_transaction()) {
+            task->result = false;
+            continue;
+        }
+        
+        int depth = connection->transaction_depth;
+        bool result = task->operation(task->arg);
+        
+        // Cerrar lo que la operación haya dejado abierto por error
+        while (connection->transaction_depth > depth) {
+            db_rollback_transaction();
+        }
+        
+        if (result && !db_commit_transaction()) {
+            result = false;
+        }
+        if (!result) {
+            db_rollback_transaction();
+        }
+        
+        task->result = result;
+    }
+    
+    if (db_commit_transaction()) {
+        return;
+    }
+    
+    fprintf(stderr, "Error: No se pudo confirmar el grupo de %d operaciones.\n", count);
+    db_rollback_transaction();
+    
+    for (int i = 0; i < count; i++) {
+        if (group[i]->result && group[i]->undo) {
+            group[i]->undo(group[i]->arg);
+        }
+        group[i]->result = false;
+    }
+}
+
+// Bucle del hilo escritor: ejecuta las operaciones en orden de llegada,
+// agrupando en una transacción las que lo permiten
+static void* db_writer_loop(void* arg) {
+    (void)arg;
+    
+    // El hilo escritor usa la conexión principal
+    t_connection = &g_database.connection;
+    
+    DbWriteTask* group[DB_MAX_GROUP];
+    
+    pthread_mutex_lock(&g_write_mutex);
+    
+    while (true) {
+        while (!g_write_head && !g_writer_stopping) {
+            pthread_cond_wait(&g_write_pending, &g_write_mutex);
+        }
+        
+        if (!g_write_head) {
+            break;
+        }
+        
+        group[0] = db_write_pop();
+        int count = 1;
+        if (group[0]->grouped) {
+            count = db_write_collect_group(group);
+        }
+        
+        pthread_mutex_unlock(&g_write_mutex);
+        if (group[0]->grouped) {
+            db_write_run_group(group, count);
+        } else {
+            group[0]->result = group[0]->operation(group[0]->arg);
+        }
+        pthread_mutex_lock(&g_write_mutex);
+        
+        for (int i = 0; i < count; i++) {
+            group[i]->done = true;
+        }
+        pthread_cond_broadcast(&g_write_done);
+    }
+    
+    pthread_mutex_unlock(&g_write_mutex);
+    return NULL;
+}
+
+// Arrancar el pool de conexiones
+bool db_pool_start() {
+    if (!g_database.connected || !g_database.connection.db) {
+        fprintf(stderr, "Error: No hay conexión a la base de datos.\n");
+        return false;
+    }
+    
+    if (g_writer_running) {
+        return true;
+    }
+    
+    // En WAL los lectores no bloquean al escritor ni al revés. Un
+    // journal_mode distinto en config.ini no se sustituye sin avisar: el pool
+    // no arranca
+    Config* config = get_config();
+    if (config && validate_config(config) && strcmp(config->db_journal_mode, "WAL") != 0) {
+        fprintf(stderr, "Error: El pool de conexiones necesita journal_mode=WAL (config.ini indica %s).\n",
+                config->db_journal_mode);
+        return false;
+    }
+    
+    if (!db_execute("PRAGMA journal_mode=WAL;")) {
+        fprintf(stderr, "Error: No se pudo activar el modo WAL.\n");
+        return false;
+    }
+    
+    g_group_commit_ms = config ? config->group_commit_ms : 0;
+    
+    g_writer_stopping = false;
+    if (pthread_create(&g_writer_thread, NULL, db_writer_loop, NULL) != 0) {
+        fprintf(stderr, "Error: No se pudo crear el hilo escritor.\n");
+        return false;
+    }
+    
+    g_writer_running = true;
+    return true;
+}
+
+// Detener el hilo escritor tras vaciar su cola
+void db_pool_stop() {
+    if (!g_writer_running) {
+        return;
+    }
+    
+    pthread_mutex_lock(&g_write_mutex);
+    g_writer_stopping = true;
+    pthread_cond_signal(&g_write_pending);
+    pthread_mutex_unlock(&g_write_mutex);
+    
+    pthread_join(g_writer_thread, NULL);
+    g_writer_running = false;
+}
+
+// Asociar una conexión de lectura al hilo actual
+bool db_reader_attach() {
+    if (t_connection) {
+        return true;
+    }
+    
+    if (!g_database.connected) {
+        fprintf(stderr, "Error: No hay conexión a la base de datos.\n");
+        return false;
+    }
+    
+    DbConnection* reader = (DbConnection*)calloc(1, sizeof(DbConnection));
+    if (!reader) {
+        fprintf(stderr, "Error: No hay memoria para la conexión de lectura.\n");
+        return false;
+    }
+    
+    // Cada conexión de lectura la usa un único hilo, así que no necesita el
+    // mutex interno de SQLite
+    int rc = sqlite3_open_v2(g_db_path, &reader->db,
+                             SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, NULL);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Error al abrir la conexión de lectura: %s\n", sqlite3_errmsg(reader->db));
+        sqlite3_close(reader->db);
+        free(reader);
+        return false;
+    }
+    
+    sqlite3_busy_timeout(reader->db, DB_BUSY_TIMEOUT_MS);
+    db_apply_profile(reader->db, false);
+    
+    pthread_mutex_lock(&g_readers_mutex);
+    if (g_num_readers >= DB_MAX_READERS) {
+        pthread_mutex_unlock(&g_readers_mutex);
+        fprintf(stderr, "Error: Se alcanzó el máximo de conexiones de lectura (%d).\n", DB_MAX_READERS);
+        db_connection_close(reader);
+        free(reader);
+        return false;
+    }
+    g_readers[g_num_readers++] = reader;
+    pthread_mutex_unlock(&g_readers_mutex);
+    
+    t_connection = reader;
+    return true;
+}
+
+// Cerrar la conexión de lectura del hilo actual
+void db_reader_detach() {
+    DbConnection* reader = t_connection;
+    if (!reader || reader == &g_database.connection) {
+        return;
+    }
+    
+    pthread_mutex_lock(&g_readers_mutex);
+    for (int i = 0; i < g_num_readers; i++) {
+        if (g_readers[i] == reader) {
+            g_readers[i] = g_readers[--g_num_readers];
+            g_readers[g_num_readers] = NULL;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_readers_mutex);
+    
+    db_connection_close(reader);
+    free(reader);
+    t_connection = NULL;
+}
+
+// Encolar una tarea para el hilo escritor y esperar a que termine
+static bool db_write_task(DbWriteTask* task) {
+    if (g_writer_running && pthread_equal(pthread_self(), g_writer_thread)) {
+        return task->operation(task->arg);
+    }
+    
+    if (!g_writer_running) {
+        // Sin pool se escribe desde este hilo, pero siempre con la conexión principal
+        DbConnection* previous = t_connection;
+        t_connection = &g_database.connection;
+        bool result = task->operation(task->arg);
+        t_connection = previous;
+        return result;
+    }
+    
+    pthread_mutex_lock(&g_write_mutex);
+    
+    if (g_writer_stopping) {
+        pthread_mutex_unlock(&g_write_mutex);
+        fprintf(stderr, "Error: El hilo escritor se está deteniendo.\n");
+        return false;
+    }
+    
+    if (g_write_tail) {
+        g_write_tail->next = task;
+    } else {
+        g_write_head = task;
+    }
+    g_write_tail = task;
+    pthread_cond_signal(&g_write_pending);
+    
+    while (!task->done) {
+        pthread_cond_wait(&g_write_done, &g_write_mutex);
+    }
+    
+    pthread_mutex_unlock(&g_write_mutex);
+    return task->result;
+}
+
+// Ejecutar una operación de escritura en el hilo escritor
+bool db_write(bool (*operation)(void* arg), void* arg) {
+    DbWriteTask task = {operation, NULL, arg, false, false, false, NULL};
+    return db_write_task(&task);
+}
+
+// Ejecutar una operación de escritura que puede compartir transacción
+bool db_write_grouped(bool (*operation)(void* arg), void (*undo)(void* arg), void* arg) {
+    DbWriteTask task = {operation, undo, arg, true, false, false, NULL};
+    return db_write_task(&task);
+}
+
+// Iniciar una transacción, o un SAVEPOINT si ya hay una abierta
 bool db_begin_transaction() {
-    return db_execute("BEGIN TRANSACTION;");
+    DbConnection* connection = db_current();
+    bool result;
+    
+    if (connection->transaction_depth == 0) {
+        result = db_execute("BEGIN TRANSACTION;");
+    } else {
+        char sql[64];
+        snprintf(sql, sizeof(sql), "SAVEPOINT nivel_%d;", connection->transaction_depth);
+        result = db_execute(sql);
+    }
+    
+    if (result) {
+        connection->transaction_depth++;
+    }
+    return result;
 }
 
-// Confirmar una transacción
+// Confirmar la transacción o el SAVEPOINT más interno. Si falla sigue
+// abierto, para que quien llama lo revierta
 bool db_commit_transaction() {
-    return db_execute("COMMIT;");
+    DbConnection* connection = db_current();
+    bool result;
+    
+    if (connection->transaction_depth <= 0) {
+        fprintf(stderr, "Error: No hay ninguna transacción abierta.\n");
+        return false;
+    }
+    
+    if (connection->transaction_depth == 1) {
+        result = db_execute("COMMIT;");
+    } else {
+        char sql[64];
+        snprintf(sql, sizeof(sql), "RELEASE nivel_%d;", connection->transaction_depth - 1);
+        result = db_execute(sql);
+    }
+    
+    if (result) {
+        connection->transaction_depth--;
+    }
+    return result;
 }
 
-// Revertir una transacción
+// Revertir la transacción o el SAVEPOINT más interno
 bool db_rollback_transaction() {
-    return db_execute("ROLLBACK;");
+    DbConnection* connection = db_current();
+    bool result;
+    
+    if (connection->transaction_depth <= 0) {
+        fprintf(stderr, "Error: No hay ninguna transacción abierta.\n");
+        return false;
+    }
+    
+    if (connection->transaction_depth == 1) {
+        result = db_execute("ROLLBACK;");
+    } else {
+        // ROLLBACK TO deshace los cambios pero deja el SAVEPOINT abierto
+        char sql[96];
+        snprintf(sql, sizeof(sql), "ROLLBACK TO nivel_%d; RELEASE nivel_%d;",
+                 connection->transaction_depth - 1, connection->transaction_depth - 1);
+        result = db_execute(sql);
+    }
+    
+    connection->transaction_depth--;
+    return result;
 }
 
 // Último ID insertado
 int db_last_insert_id() {
-    if (!g_database.connected || !g_database.db) {
+    if (!g_database.connected || !g_database.connection.db) {
         fprintf(stderr, "Error: No hay conexión a la base de datos.\n");
         return -1;
     }
     
-    return sqlite3_last_insert_rowid(g_database.db);
+    return sqlite3_last_insert_rowid(db_current()->db);
 }
 
 // Obtener número de cambios en la última operación
 int db_changes() {
-    if (!g_database.connected || !g_database.db) {
+    if (!g_database.connected || !g_database.connection.db) {
         fprintf(stderr, "Error: No hay conexión a la base de datos.\n");
         return -1;
     }
     
-    return sqlite3_changes(g_database.db);
+    return sqlite3_changes(db_current()->db);
 }
\ No newline at end of file
@@ -2,11 +2,121 @@
 #define DATABASE_H
 
 #include "lib/sqlite3.h"
+#include "utils/result_set.h"
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Identificadores de las consultas que se preparan una vez y se reutilizan
+typedef enum {
+    // Usuarios
+    STMT_USUARIO_CREAR,
+    STMT_USUARIO_OBTENER_POR_ID,
+    STMT_USUARIO_OBTENER_POR_CORREO,
+    STMT_USUARIO_ACTUALIZAR,
+    STMT_USUARIO_ELIMINAR,
+    STMT_USUARIO_LISTAR,
+    STMT_USUARIO_CAMBIAR_CONTRASENA,
+    
+    // Películas
+    STMT_PELICULA_CREAR,
+    STMT_PELICULA_OBTENER_POR_ID,
+    STMT_PELICULA_ACTUALIZAR,
+    STMT_PELICULA_ELIMINAR,
+    STMT_PELICULA_LISTAR,
+    
+    // Salas y asientos
+    STMT_SALA_CREAR,
+    STMT_SALA_OBTENER_POR_ID,
+    STMT_SALA_ACTUALIZAR,
+    STMT_SALA_ELIMINAR,
+    STMT_SALA_LISTAR,
+    STMT_SALA_CONTAR_ASIENTOS_LIBRES,
+    STMT_ASIENTO_CREAR,
+    STMT_ASIENTO_OBTENER_POR_ID,
+    STMT_ASIENTO_ACTUALIZAR_ESTADO,
+    STMT_ASIENTO_ACTUALIZAR_ESTADO_LOTE,
+    STMT_ASIENTO_LISTAR_POR_SALA,
+    
+    // Sesiones
+    STMT_SESION_CREAR,
+    STMT_SESION_OBTENER_POR_ID,
+    STMT_SESION_ACTUALIZAR,
+    STMT_SESION_ELIMINAR,
+    STMT_SESION_LISTAR,
+    STMT_SESION_BUSCAR_POR_PELICULA,
+    STMT_SESION_BUSCAR_POR_SALA,
+    STMT_SESION_BUSCAR_POR_FECHA,
+    STMT_SESION_BUSCAR_POR_RANGO,
+    STMT_SESION_BUSCAR_POR_RANGO_SALA,
+    STMT_SESION_BUSCAR_POR_RANGO_PELICULA,
+    
+    // Billetes y ventas
+    STMT_BILLETE_CREAR,
+    STMT_BILLETE_CREAR_LOTE,
+    STMT_BILLETE_OBTENER_POR_ID,
+    STMT_BILLETE_ACTUALIZAR,
+    STMT_BILLETE_ELIMINAR,
+    STMT_BILLETE_LISTAR_POR_SESION,
+    STMT_BILLETE_LISTAR_POR_VENTA,
+    STMT_VENTA_CREAR,
+    STMT_VENTA_OBTENER_POR_ID,
+    STMT_VENTA_ELIMINAR,
+    STMT_VENTA_LISTAR_POR_USUARIO,
+    STMT_VENTA_BILLETE_ASOCIAR,
+    STMT_VENTA_BILLETE_ELIMINAR,
+    
+    STMT_TOTAL
+} StatementId;
+
+// Tipo con el que se copia una columna en un campo de la estructura
+typedef enum {
+    DB_COLUMN_INT,
+    DB_COLUMN_INT64,    // int64_t (p. ej. horas en segundos desde la época)
+    DB_COLUMN_DOUBLE,
+    DB_COLUMN_TEXT,     // char[] de tamaño size, siempre terminado en '\0'
+    DB_COLUMN_ENUM      // Texto convertido a entero con to_enum
+} DbColumnType;
+
+// Correspondencia entre una columna del resultado y un campo de un modelo
+typedef struct {
+    const char* name;
+    DbColumnType type;
+    size_t offset;
+    size_t size;
+    int (*to_enum)(const char* text);
+} DbColumn;
+
+// Columnas que se leen de cada fila
+typedef struct {
+    const DbColumn* columns;
+    int num_columns;
+} DbRowMap;
+
+#define DB_INT_COLUMN(name, type, field) \
+    { name, DB_COLUMN_INT, offsetof(type, field), 0, NULL }
+#define DB_INT64_COLUMN(name, type, field) \
+    { name, DB_COLUMN_INT64, offsetof(type, field), 0, NULL }
+#define DB_DOUBLE_COLUMN(name, type, field) \
+    { name, DB_COLUMN_DOUBLE, offsetof(type, field), 0, NULL }
+#define DB_TEXT_COLUMN(name, type, field) \
+    { name, DB_COLUMN_TEXT, offsetof(type, field), sizeof(((type*)0)->field), NULL }
+#define DB_ENUM_COLUMN(name, type, field, to_enum) \
+    { name, DB_COLUMN_ENUM, offsetof(type, field), sizeof(((type*)0)->field), to_enum }
+#define DB_ROW_MAP(columns) \
+    { columns, (int)(sizeof(columns) / sizeof((columns)[0])) }
+
+// Conexión SQLite con su propia caché de sentencias preparadas.
+// Cada conexión la usa un solo hilo a la vez
+typedef struct {
+    sqlite3 *db;
+    sqlite3_stmt *statements[STMT_TOTAL];
+    int transaction_depth;      // Transacciones abiertas (las internas son SAVEPOINT)
+} DbConnection;
 
 // Estructura para manejar la conexión a la base de datos
 typedef struct {
-    sqlite3 *db;
+    DbConnection connection;    // Conexión principal; la única que escribe
     char *error_message;
     bool connected;
 } Database;
@@ -14,7 +124,8 @@ typedef struct {
 // Inicializar la base de datos
 bool db_init(const char* db_path);
 
-// Abrir la conexión a la base de datos
+// Abrir la conexión a la base de datos con el perfil de rendimiento
+// (journal_mode, synchronous, cache_size, mmap_size, temp_store) de config.ini
 bool db_open(const char* db_path);
 
 // Cerrar la conexión a la base de datos
@@ -23,7 +134,8 @@ void db_close();
 // Ejecutar una consulta SQL sin resultados (CREATE, INSERT, UPDATE, DELETE)
 bool db_execute(const char* sql);
 
-// Crear las tablas de la base de datos si no existen
+// Crear las tablas de la base de datos si no existen y aplicar las
+// migraciones del esquema pendientes
 bool db_create_tables();
 
 // Backup de la base de datos
@@ -38,13 +150,82 @@ Database* get_database();
 // Ejecutar una consulta SQL con callback para procesar resultados
 bool db_query(const char* sql, int (*callback)(void*, int, char**, char**), void* data);
 
-// Iniciar una transacción
+// Obtener la sentencia preparada de una consulta, lista para enlazar sus
+// parámetros. La primera llamada la compila con el SQL indicado; las
+// siguientes reutilizan la misma sentencia. Devuelve NULL si hay error
+sqlite3_stmt* db_statement(StatementId id, const char* sql);
+
+// Filas de las sentencias en lote (INSERT con varias filas en VALUES o
+// WHERE ID IN (...)). Tienen siempre DB_BATCH_ROWS filas para que la sentencia
+// preparada se reutilice: las que sobran en el último lote se quedan sin
+// enlazar (NULL) y la propia sentencia las descarta
+#define DB_BATCH_ROWS 16
+#define DB_REPEAT_4(row) row ", " row ", " row ", " row
+#define DB_BATCH(row) DB_REPEAT_4(row) ", " DB_REPEAT_4(row) ", " DB_REPEAT_4(row) ", " DB_REPEAT_4(row)
+
+// Enlazar parámetros (los índices empiezan en 1)
+bool db_bind_int(sqlite3_stmt* stmt, int index, int value);
+bool db_bind_int64(sqlite3_stmt* stmt, int index, int64_t value);
+bool db_bind_double(sqlite3_stmt* stmt, int index, double value);
+bool db_bind_text(sqlite3_stmt* stmt, int index, const char* value);
+
+// Ejecutar una sentencia sin resultados
+bool db_statement_execute(sqlite3_stmt* stmt);
+
+// Leer la primera fila del resultado en row (que no se modifica si no hay
+// filas). Los índices de las columnas se resuelven una vez por ejecución y
+// los valores se leen con su tipo, sin pasar por texto
+bool db_statement_read(sqlite3_stmt* stmt, const DbRowMap* map, void* row);
+
+// Leer todas las filas del resultado añadiéndolas a result
+bool db_statement_read_all(sqlite3_stmt* stmt, const DbRowMap* map, ResultSet* result);
+
+// Ejecutar una sentencia que devuelve un único entero (p. ej. COUNT(*))
+bool db_statement_int(sqlite3_stmt* stmt, int* value);
+
+// Pool de conexiones para el servidor multihilo. Activa el modo WAL (falla
+// si config.ini pide otro journal_mode) y arranca un hilo escritor que
+// ejecuta, de una en una y con la conexión principal, las operaciones
+// enviadas con db_write. Los hilos que solo leen abren su propia conexión de
+// lectura con db_reader_attach. Sin pool, todas las llamadas usan la
+// conexión principal desde el hilo que llama
+bool db_pool_start();
+
+// Detener el hilo escritor (db_close lo hace automáticamente)
+void db_pool_stop();
+
+// Máximo de conexiones de lectura abiertas a la vez. Cada hilo trabajador
+// del servidor abre una, así que también limita worker_threads
+#define DB_MAX_READERS 64
+
+// Asociar al hilo actual una conexión de solo lectura. Es idempotente, así
+// que se puede llamar antes de cada lectura
+bool db_reader_attach();
+
+// Cerrar la conexión de lectura del hilo actual
+void db_reader_detach();
+
+// Ejecutar una operación de escritura en el hilo escritor y esperar su
+// resultado. Sin pool, o desde el propio hilo escritor, se ejecuta directamente
+bool db_write(bool (*operation)(void* arg), void* arg);
+
+// Como db_write, pero la operación puede compartir transacción con otras
+// operaciones agrupables que lleguen dentro de la ventana group_commit_ms.
+// Cada una se ejecuta en su propio SAVEPOINT, así que si falla solo se
+// deshacen sus cambios. Si lo que falla es el COMMIT del grupo, se llama a
+// undo (si no es NULL) en las operaciones que habían terminado bien, para
+// que deshagan los efectos que dejaron fuera de la base de datos
+bool db_write_grouped(bool (*operation)(void* arg), void (*undo)(void* arg), void* arg);
+
+// Iniciar una transacción. Si ya hay una abierta en la conexión, se abre un
+// SAVEPOINT dentro de ella, así que las operaciones que usan transacciones
+// se pueden llamar unas desde otras
 bool db_begin_transaction();
 
-// Confirmar una transacción
+// Confirmar la transacción (o SAVEPOINT) más interna
 bool db_commit_transaction();
 
-// Revertir una transacción
+// Revertir la transacción (o SAVEPOINT) más interna
 bool db_rollback_transaction();
 
 // Último ID insertado
@@ -6,6 +6,11 @@
 #include "menu.h"
 #include "utils/logger.h"
 #include "utils/memory.h"
+#include "models/ocupacion.h"
+#include "models/horario.h"
+#include "models/titulos.h"
+#include "models/generos.h"
+#include "models/retencion.h"
 #include "test_data.h"  // Incluir el nuevo archivo
 
 int main() {
@@ -37,6 +42,7 @@ int main() {
         fprintf(stderr, "Error: No se pudo inicializar el sistema de logging.\n");
         return EXIT_FAILURE;
     }
+    log_set_overflow(log_overflow_from_string(config.log_overflow));
     
     log_info("===== Iniciando CineGestion =====");
     
@@ -74,6 +80,11 @@ int main() {
     
     // Limpieza y finalización
     log_info("===== Finalizando CineGestion =====");
+    retencion_limpiar();
+    ocupacion_limpiar();
+    horario_limpiar();
+    titulos_limpiar();
+    generos_limpiar();
     db_close();
     log_close();
     memory_cleanup();
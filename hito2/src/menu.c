@@ -10,6 +10,7 @@
 #include "models/billete.h"
 #include "models/asiento.h"
 #include "models/sesion.h" 
+#include "models/ocupacion.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -120,15 +121,19 @@ static void cliente_ver_cartelera() {
                     int asientos_libres = sala_contar_asientos_libres(sala.id);
                     
                     // Formatear hora (quitar los segundos y la fecha completa)
+                    char texto_inicio[20], texto_fin[20];
+                    sesion_convertir_epoch_a_str(sesiones[j].inicio, texto_inicio, sizeof(texto_inicio));
+                    sesion_convertir_epoch_a_str(sesiones[j].fin, texto_fin, sizeof(texto_fin));
+                    
                     char hora_inicio[6], hora_fin[6];
-                    strncpy(hora_inicio, sesiones[j].hora_inicio + 11, 5);
+                    strncpy(hora_inicio, texto_inicio + 11, 5);
                     hora_inicio[5] = '\0';
-                    strncpy(hora_fin, sesiones[j].hora_fin + 11, 5);
+                    strncpy(hora_fin, texto_fin + 11, 5);
                     hora_fin[5] = '\0';
                     
                     // Extraer solo la fecha (YYYY-MM-DD)
                     char fecha[11];
-                    strncpy(fecha, sesiones[j].hora_inicio, 10);
+                    strncpy(fecha, texto_inicio, 10);
                     fecha[10] = '\0';
                     
                     printf("     - Sesión ID: %d | Fecha: %s | Hora: %s-%s | Sala: %d | Asientos libres: %d\n",
@@ -174,9 +179,18 @@ static void cliente_mostrar_asientos(int sesion_id) {
     }
     
     // Determinar el número de filas y columnas para una visualización agradable
-    // Asumiendo una sala rectangular con asientos numerados consecutivamente
-    int filas = (int)sqrt(sala.numero_asientos) + 1;
-    int columnas = (sala.numero_asientos / filas) + 1;
+    // Asumiendo una sala rectangular con asientos numerados consecutivamente.
+    // Es la misma disposición que usa la búsqueda de mejores asientos
+    int filas, columnas;
+    ocupacion_disposicion(num_asientos, &filas, &columnas);
+    
+    // Una sola consulta para la ocupación de toda la sesión
+    MapaOcupacion mapa;
+    if (!ocupacion_obtener_mapa(sesion_id, &mapa)) {
+        menu_mostrar_error("Error al cargar la ocupación de la sesión");
+        asiento_liberar_lista(asientos, num_asientos);
+        return;
+    }
     
     // Imprimimos la pantalla
     printf("\n\n");
@@ -194,7 +208,8 @@ static void cliente_mostrar_asientos(int sesion_id) {
             
             if (asiento_idx < num_asientos) {
                 // Verificar si el asiento está disponible para esta sesión
-                bool disponible = billete_esta_disponible(sesion_id, asientos[asiento_idx].id);
+                bool disponible = asiento_idx >= mapa.num_asientos ||
+                                  !(mapa.mapa[asiento_idx / 8] & (1 << (asiento_idx % 8)));
                 
                 if (disponible) {
                     printf("[%2d] ", asientos[asiento_idx].numero);
@@ -210,6 +225,7 @@ static void cliente_mostrar_asientos(int sesion_id) {
     
     printf("\nLeyenda: [##] Asiento libre, XX Asiento ocupado\n\n");
     
+    ocupacion_liberar_mapa(&mapa);
     asiento_liberar_lista(asientos, num_asientos);
 }
 
@@ -257,12 +273,16 @@ static void cliente_comprar_entradas() {
         sala_obtener_por_id(sesiones[i].sala_id, &sala);
         
         // Formatear fecha y hora para mejor visualización
+        char texto_inicio[20], texto_fin[20];
+        sesion_convertir_epoch_a_str(sesiones[i].inicio, texto_inicio, sizeof(texto_inicio));
+        sesion_convertir_epoch_a_str(sesiones[i].fin, texto_fin, sizeof(texto_fin));
+        
         char fecha[11], hora_inicio[6], hora_fin[6];
-        strncpy(fecha, sesiones[i].hora_inicio, 10);
+        strncpy(fecha, texto_inicio, 10);
         fecha[10] = '\0';
-        strncpy(hora_inicio, sesiones[i].hora_inicio + 11, 5);
+        strncpy(hora_inicio, texto_inicio + 11, 5);
         hora_inicio[5] = '\0';
-        strncpy(hora_fin, sesiones[i].hora_fin + 11, 5);
+        strncpy(hora_fin, texto_fin + 11, 5);
         hora_fin[5] = '\0';
         
         int asientos_libres = sala_contar_asientos_libres(sala.id);
@@ -306,8 +326,36 @@ static void cliente_comprar_entradas() {
         return;
     }
     
+    // Proponer los mejores asientos contiguos que queden libres
+    int primera_entrada = 0;
+    int mejores[10];
+    int fila_mejores;
+    
+    if (ocupacion_mejores_asientos(sesion_id, num_entradas, mejores, &fila_mejores)) {
+        printf("\nMejores asientos juntos disponibles (fila %d):", fila_mejores + 1);
+        for (int i = 0; i < num_entradas; i++) {
+            for (int j = 0; j < num_asientos; j++) {
+                if (asientos[j].id == mejores[i]) {
+                    printf(" %d", asientos[j].numero);
+                    break;
+                }
+            }
+        }
+        printf("\n");
+        
+        if (menu_confirmar("¿Desea estos asientos?")) {
+            for (int i = 0; i < num_entradas; i++) {
+                memset(&billetes[i], 0, sizeof(Billete));
+                billetes[i].sesion_id = sesion_id;
+                billetes[i].asiento_id = mejores[i];
+                billetes[i].precio = billete_calcular_precio_base(sesion_id);
+            }
+            primera_entrada = num_entradas;
+        }
+    }
+    
     // Seleccionar asientos uno por uno
-    for (int i = 0; i < num_entradas; i++) {
+    for (int i = primera_entrada; i < num_entradas; i++) {
         printf("\nEntrada #%d:\n", i + 1);
         int numero_asiento = menu_leer_entero("Ingrese el número de asiento", 1, num_asientos);
         
@@ -527,10 +575,13 @@ static void cliente_mostrar_detalle_venta(int venta_id) {
         }
         
         // Formatear fecha y hora
+        char texto_inicio[20];
+        sesion_convertir_epoch_a_str(sesion.inicio, texto_inicio, sizeof(texto_inicio));
+        
         char fecha[11], hora[6];
-        strncpy(fecha, sesion.hora_inicio, 10);
+        strncpy(fecha, texto_inicio, 10);
         fecha[10] = '\0';
-        strncpy(hora, sesion.hora_inicio + 11, 5);
+        strncpy(hora, texto_inicio + 11, 5);
         hora[5] = '\0';
         
         printf("%-5d %-20s %-20s %-10d %-10d\n", 
@@ -1279,8 +1330,9 @@ static void mostrar_menu_sesiones() {
                             int sesion_id = sesiones[i].id;
                             int pelicula_id = sesiones[i].pelicula_id;
                             int sala_id = sesiones[i].sala_id;
-                            char* hora_inicio = sesiones[i].hora_inicio;
-                            char* hora_fin = sesiones[i].hora_fin;
+                            char hora_inicio[20], hora_fin[20];
+                            sesion_convertir_epoch_a_str(sesiones[i].inicio, hora_inicio, sizeof(hora_inicio));
+                            sesion_convertir_epoch_a_str(sesiones[i].fin, hora_fin, sizeof(hora_fin));
                             
                             // Obtener información de la película
                             Pelicula pelicula;
@@ -1375,8 +1427,8 @@ static void mostrar_menu_sesiones() {
                 menu_leer_texto(fecha, sizeof(fecha), "Fecha de inicio (YYYY-MM-DD)");
                 menu_leer_texto(hora, sizeof(hora), "Hora de inicio (HH:MM)");
                 
-                snprintf(nueva_sesion.hora_inicio, sizeof(nueva_sesion.hora_inicio),
-                        "%s %s:00", fecha, hora);
+                char texto_inicio[20];
+                snprintf(texto_inicio, sizeof(texto_inicio), "%s %s:00", fecha, hora);
                 
                 // Obtener la duración de la película
                 Pelicula pelicula;
@@ -1389,8 +1441,7 @@ static void mostrar_menu_sesiones() {
                 }
                 
                 // Calcular la hora de finalización (hora inicio + duración película + 15 min para limpieza)
-                struct tm tm_inicio;
-                if (!sesion_convertir_str_a_time(nueva_sesion.hora_inicio, &tm_inicio)) {
+                if (!sesion_convertir_str_a_epoch(texto_inicio, &nueva_sesion.inicio)) {
                     menu_mostrar_error("Formato de fecha/hora inválido");
                     pelicula_liberar_lista(peliculas, num_peliculas);
                     sala_liberar_lista(salas, num_salas);
@@ -1398,13 +1449,11 @@ static void mostrar_menu_sesiones() {
                     break;
                 }
                 
-                time_t tiempo_inicio = mktime(&tm_inicio);
-                time_t tiempo_fin = tiempo_inicio + (pelicula.duracion + 15) * 60; // Duración en segundos + 15 min
-                
-                struct tm* tm_fin = localtime(&tiempo_fin);
-                sesion_convertir_time_a_str(tm_fin, nueva_sesion.hora_fin, sizeof(nueva_sesion.hora_fin));
+                nueva_sesion.fin = nueva_sesion.inicio + (pelicula.duracion + 15) * 60; // Duración en segundos + 15 min
                 
-                printf("Hora de finalización calculada: %s\n", nueva_sesion.hora_fin);
+                char texto_fin[20];
+                sesion_convertir_epoch_a_str(nueva_sesion.fin, texto_fin, sizeof(texto_fin));
+                printf("Hora de finalización calculada: %s\n", texto_fin);
                 
                 if (sesion_crear(&nueva_sesion)) {
                     menu_mostrar_exito("Sesión creada correctamente");
@@ -2,77 +2,44 @@
 #include "../database.h"
 #include "../utils/logger.h"
 #include "../utils/memory.h"
+#include "../utils/result_set.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
-// Función auxiliar para callback de SQLite
-static int asiento_callback(void* data, int argc, char** argv, char** column_names) {
-    Asiento* asiento = (Asiento*)data;
-    
-    for (int i = 0; i < argc; i++) {
-        if (strcmp(column_names[i], "ID") == 0) {
-            asiento->id = atoi(argv[i]);
-        } else if (strcmp(column_names[i], "Sala_ID") == 0) {
-            asiento->sala_id = atoi(argv[i]);
-        } else if (strcmp(column_names[i], "Numero") == 0) {
-            asiento->numero = atoi(argv[i]);
-        } else if (strcmp(column_names[i], "Estado") == 0) {
-            asiento->estado = asiento_string_a_estado(argv[i]);
-        }
-    }
-    
-    return 0;
+// Conversión de la columna Estado
+static int asiento_columna_estado(const char* texto) {
+    return asiento_string_a_estado(texto);
 }
 
-// Función callback para listar asientos
-static int asientos_listar_callback(void* data, int argc, char** argv, char** column_names) {
-    struct {
-        Asiento* asientos;
-        int max_asientos;
-        int* num_asientos;
-    }* callback_data = (void*)data;
-    
-    if (*callback_data->num_asientos >= callback_data->max_asientos) {
-        // No hay más espacio para asientos
-        return 1;
-    }
-    
-    Asiento* asiento = &callback_data->asientos[*callback_data->num_asientos];
-    
-    for (int i = 0; i < argc; i++) {
-        if (strcmp(column_names[i], "ID") == 0) {
-            asiento->id = atoi(argv[i]);
-        } else if (strcmp(column_names[i], "Sala_ID") == 0) {
-            asiento->sala_id = atoi(argv[i]);
-        } else if (strcmp(column_names[i], "Numero") == 0) {
-            asiento->numero = atoi(argv[i]);
-        } else if (strcmp(column_names[i], "Estado") == 0) {
-            asiento->estado = asiento_string_a_estado(argv[i]);
-        }
-    }
-    
-    (*callback_data->num_asientos)++;
-    return 0;
-}
+// Columnas de la tabla Asiento
+static const DbColumn asiento_columnas[] = {
+    DB_INT_COLUMN("ID", Asiento, id),
+    DB_INT_COLUMN("Sala_ID", Asiento, sala_id),
+    DB_INT_COLUMN("Numero", Asiento, numero),
+    DB_ENUM_COLUMN("Estado", Asiento, estado, asiento_columna_estado)
+};
+
+static const DbRowMap asiento_fila = DB_ROW_MAP(asiento_columnas);
 
 // Obtener asiento por ID
 bool asiento_obtener_por_id(int id, Asiento* asiento) {
-    char sql[256];
-    snprintf(sql, sizeof(sql), "SELECT * FROM Asiento WHERE ID = %d;", id);
+    sqlite3_stmt* stmt = db_statement(STMT_ASIENTO_OBTENER_POR_ID,
+            "SELECT * FROM Asiento WHERE ID = ?;");
+    db_bind_int(stmt, 1, id);
     
     memset(asiento, 0, sizeof(Asiento));
-    return db_query(sql, asiento_callback, asiento);
+    return db_statement_read(stmt, &asiento_fila, asiento);
 }
 
 // Actualizar estado de un asiento
 bool asiento_actualizar_estado(int id, EstadoAsiento estado) {
-    char sql[256];
-    snprintf(sql, sizeof(sql),
-            "UPDATE Asiento SET Estado = '%s' WHERE ID = %d;",
-            asiento_estado_a_string(estado), id);
+    sqlite3_stmt* stmt = db_statement(STMT_ASIENTO_ACTUALIZAR_ESTADO,
+            "UPDATE Asiento SET Estado = ? WHERE ID = ?;");
+    db_bind_text(stmt, 1, asiento_estado_a_string(estado));
+    db_bind_int(stmt, 2, id);
     
-    if (db_execute(sql)) {
+    if (db_statement_execute(stmt)) {
         log_info("Estado del asiento %d actualizado a %s", id, asiento_estado_a_string(estado));
         return true;
     }
@@ -83,61 +50,24 @@ bool asiento_actualizar_estado(int id, EstadoAsiento estado) {
 
 // Listar asientos por sala
 bool asiento_listar_por_sala(int sala_id, Asiento** asientos, int* num_asientos) {
-    // Primero, contar cuántos asientos hay en la sala
-    char sql_count[256];
-    snprintf(sql_count, sizeof(sql_count), "SELECT COUNT(*) FROM Asiento WHERE Sala_ID = %d;", sala_id);
-    
-    int count = 0;
-    
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(get_database()->db, sql_count, -1, &stmt, NULL);
-    
-    if (rc != SQLITE_OK) {
-        log_error("Error al preparar la consulta: %s", sqlite3_errmsg(get_database()->db));
-        return false;
-    }
-    
-    rc = sqlite3_step(stmt);
-    
-    if (rc == SQLITE_ROW) {
-        count = sqlite3_column_int(stmt, 0);
-    }
-    
-    sqlite3_finalize(stmt);
-    
-    if (count == 0) {
-        *asientos = NULL;
-        *num_asientos = 0;
-        return true;
-    }
-    
-    // Asignar memoria para los asientos
-    *asientos = (Asiento*)MEM_ALLOC(count * sizeof(Asiento));
-    if (!*asientos) {
-        log_error("Error al asignar memoria para la lista de asientos");
-        return false;
-    }
-    
     // Consultar los asientos
-    char sql[256];
-    snprintf(sql, sizeof(sql), "SELECT * FROM Asiento WHERE Sala_ID = %d ORDER BY Numero;", sala_id);
-    
-    struct {
-        Asiento* asientos;
-        int max_asientos;
-        int* num_asientos;
-    } callback_data = {*asientos, count, num_asientos};
+    sqlite3_stmt* stmt = db_statement(STMT_ASIENTO_LISTAR_POR_SALA,
+            "SELECT * FROM Asiento WHERE Sala_ID = ? ORDER BY Numero;");
+    db_bind_int(stmt, 1, sala_id);
     
-    *num_asientos = 0;  // Inicializar el contador
+    ResultSet resultado;
+    result_set_init(&resultado, sizeof(Asiento));
     
-    if (!db_query(sql, asientos_listar_callback, &callback_data)) {
-        MEM_FREE(*asientos);
+    if (!db_statement_read_all(stmt, &asiento_fila, &resultado)) {
+        result_set_free(&resultado);
         *asientos = NULL;
         *num_asientos = 0;
         log_error("Error al consultar la lista de asientos");
         return false;
     }
     
+    *asientos = (Asiento*)result_set_take(&resultado, num_asientos);
+    
     log_info("Se listaron %d asientos para la sala %d", *num_asientos, sala_id);
     return true;
 }
@@ -147,6 +77,26 @@ bool asiento_reservar(int id) {
     return asiento_actualizar_estado(id, ASIENTO_OCUPADO);
 }
 
+// Reservar varios asientos
+bool asiento_reservar_varios(const int* ids, int num_ids) {
+    for (int inicio = 0; inicio < num_ids; inicio += DB_BATCH_ROWS) {
+        sqlite3_stmt* stmt = db_statement(STMT_ASIENTO_ACTUALIZAR_ESTADO_LOTE,
+                "UPDATE Asiento SET Estado = ? WHERE ID IN (" DB_BATCH("?") ");");
+        db_bind_text(stmt, 1, asiento_estado_a_string(ASIENTO_OCUPADO));
+        
+        for (int i = inicio; i < num_ids && i < inicio + DB_BATCH_ROWS; i++) {
+            db_bind_int(stmt, 2 + i - inicio, ids[i]);
+        }
+        
+        if (!db_statement_execute(stmt)) {
+            log_error("Error al reservar %d asientos", num_ids);
+            return false;
+        }
+    }
+    
+    return true;
+}
+
 // Liberar un asiento
 bool asiento_liberar(int id) {
     return asiento_actualizar_estado(id, ASIENTO_LIBRE);
@@ -24,6 +24,8 @@ bool asiento_listar_por_sala(int sala_id, Asiento** asientos, int* num_asientos)
 
 // Funciones adicionales
 bool asiento_reservar(int id);
+// Marcar como ocupados varios asientos con un UPDATE por cada DB_BATCH_ROWS
+bool asiento_reservar_varios(const int* ids, int num_ids);
 bool asiento_liberar(int id);
 bool asiento_esta_disponible(int id);
 
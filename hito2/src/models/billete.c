@@ -1,62 +1,24 @@
 #include "billete.h"
 #include "asiento.h"
 #include "sesion.h"
+#include "ocupacion.h"
 #include "../database.h"
 #include "../utils/logger.h"
 #include "../utils/memory.h"
+#include "../utils/result_set.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
-// Función auxiliar para callback de SQLite
-static int billete_callback(void* data, int argc, char** argv, char** column_names) {
-    Billete* billete = (Billete*)data;
-    
-    for (int i = 0; i < argc; i++) {
-        if (strcmp(column_names[i], "ID") == 0) {
-            billete->id = atoi(argv[i]);
-        } else if (strcmp(column_names[i], "Sesion_ID") == 0) {
-            billete->sesion_id = atoi(argv[i]);
-        } else if (strcmp(column_names[i], "Asiento_ID") == 0) {
-            billete->asiento_id = atoi(argv[i]);
-        } else if (strcmp(column_names[i], "Precio") == 0) {
-            billete->precio = atof(argv[i]);
-        }
-    }
-    
-    return 0;
-}
+// Columnas de la tabla Billete
+static const DbColumn billete_columnas[] = {
+    DB_INT_COLUMN("ID", Billete, id),
+    DB_INT_COLUMN("Sesion_ID", Billete, sesion_id),
+    DB_INT_COLUMN("Asiento_ID", Billete, asiento_id),
+    DB_DOUBLE_COLUMN("Precio", Billete, precio)
+};
 
-// Función callback para listar billetes
-static int billetes_listar_callback(void* data, int argc, char** argv, char** column_names) {
-    struct {
-        Billete* billetes;
-        int max_billetes;
-        int* num_billetes;
-    }* callback_data = (void*)data;
-    
-    if (*callback_data->num_billetes >= callback_data->max_billetes) {
-        // No hay más espacio para billetes
-        return 1;
-    }
-    
-    Billete* billete = &callback_data->billetes[*callback_data->num_billetes];
-    
-    for (int i = 0; i < argc; i++) {
-        if (strcmp(column_names[i], "ID") == 0) {
-            billete->id = atoi(argv[i]);
-        } else if (strcmp(column_names[i], "Sesion_ID") == 0) {
-            billete->sesion_id = atoi(argv[i]);
-        } else if (strcmp(column_names[i], "Asiento_ID") == 0) {
-            billete->asiento_id = atoi(argv[i]);
-        } else if (strcmp(column_names[i], "Precio") == 0) {
-            billete->precio = atof(argv[i]);
-        }
-    }
-    
-    (*callback_data->num_billetes)++;
-    return 0;
-}
+static const DbRowMap billete_fila = DB_ROW_MAP(billete_columnas);
 
 // Crear un nuevo billete
 bool billete_crear(Billete* billete) {
@@ -65,25 +27,37 @@ bool billete_crear(Billete* billete) {
         return false;
     }
     
-    // Comprobar si el asiento está disponible para esta sesión
-    if (!billete_esta_disponible(billete->sesion_id, billete->asiento_id)) {
+    // Reservar el asiento en el inventario de la sesión. Si otra venta lo
+    // reservó antes, esta falla aquí sin llegar a la base de datos
+    if (!ocupacion_reservar_asientos(billete->sesion_id, &billete->asiento_id, 1)) {
         log_error("El asiento no está disponible para esta sesión");
         return false;
     }
     
+    if (!billete_crear_reservado(billete)) {
+        ocupacion_liberar_asientos(billete->sesion_id, &billete->asiento_id, 1);
+        return false;
+    }
+    
+    return true;
+}
+
+// Crear un billete cuyo asiento ya está reservado en el inventario
+bool billete_crear_reservado(Billete* billete) {
     // Iniciar transacción
     if (!db_begin_transaction()) {
         log_error("Error al iniciar transacción para crear billete");
         return false;
     }
     
-    char sql[512];
-    snprintf(sql, sizeof(sql),
+    sqlite3_stmt* stmt = db_statement(STMT_BILLETE_CREAR,
             "INSERT INTO Billete (Sesion_ID, Asiento_ID, Precio) "
-            "VALUES (%d, %d, %.2f);",
-            billete->sesion_id, billete->asiento_id, billete->precio);
+            "VALUES (?, ?, ?);");
+    db_bind_int(stmt, 1, billete->sesion_id);
+    db_bind_int(stmt, 2, billete->asiento_id);
+    db_bind_double(stmt, 3, billete->precio);
     
-    if (!db_execute(sql)) {
+    if (!db_statement_execute(stmt)) {
         log_error("Error al crear billete");
         db_rollback_transaction();
         return false;
@@ -109,13 +83,85 @@ bool billete_crear(Billete* billete) {
     return true;
 }
 
+// Crear varios billetes con los asientos ya reservados
+bool billete_crear_lote(Billete* billetes, int num_billetes) {
+    int siguiente = 0;
+    int total = 0;
+    
+    while (siguiente < num_billetes) {
+        // Billetes nuevos de este lote, por su posición en billetes
+        int lote[DB_BATCH_ROWS];
+        int num_lote = 0;
+        
+        for (; siguiente < num_billetes && num_lote < DB_BATCH_ROWS; siguiente++) {
+            if (billetes[siguiente].id <= 0) {
+                lote[num_lote++] = siguiente;
+            }
+        }
+        
+        if (num_lote == 0) {
+            break;
+        }
+        
+        // RETURNING devuelve los IDs asignados; se emparejan por sesión y
+        // asiento porque SQLite no garantiza el orden de las filas
+        sqlite3_stmt* stmt = db_statement(STMT_BILLETE_CREAR_LOTE,
+                "INSERT INTO Billete (Sesion_ID, Asiento_ID, Precio) "
+                "SELECT column1, column2, column3 FROM (VALUES " DB_BATCH("(?, ?, ?)") ") "
+                "WHERE column1 IS NOT NULL "
+                "RETURNING ID, Sesion_ID, Asiento_ID, Precio;");
+        
+        int asiento_ids[DB_BATCH_ROWS];
+        for (int i = 0; i < num_lote; i++) {
+            Billete* billete = &billetes[lote[i]];
+            db_bind_int(stmt, 3 * i + 1, billete->sesion_id);
+            db_bind_int(stmt, 3 * i + 2, billete->asiento_id);
+            db_bind_double(stmt, 3 * i + 3, billete->precio);
+            asiento_ids[i] = billete->asiento_id;
+        }
+        
+        ResultSet creados;
+        result_set_init(&creados, sizeof(Billete));
+        
+        if (!db_statement_read_all(stmt, &billete_fila, &creados) || creados.count != num_lote) {
+            log_error("Error al crear un lote de %d billetes", num_lote);
+            result_set_free(&creados);
+            return false;
+        }
+        
+        Billete* filas = (Billete*)creados.rows;
+        for (int f = 0; f < creados.count; f++) {
+            for (int i = 0; i < num_lote; i++) {
+                Billete* billete = &billetes[lote[i]];
+                if (billete->sesion_id == filas[f].sesion_id && billete->asiento_id == filas[f].asiento_id) {
+                    billete->id = filas[f].id;
+                    break;
+                }
+            }
+        }
+        
+        result_set_free(&creados);
+        
+        // Marcar los asientos como ocupados
+        if (!asiento_reservar_varios(asiento_ids, num_lote)) {
+            return false;
+        }
+        
+        total += num_lote;
+    }
+    
+    log_info("Creados %d billetes en lote", total);
+    return true;
+}
+
 // Obtener billete por ID
 bool billete_obtener_por_id(int id, Billete* billete) {
-    char sql[256];
-    snprintf(sql, sizeof(sql), "SELECT * FROM Billete WHERE ID = %d;", id);
+    sqlite3_stmt* stmt = db_statement(STMT_BILLETE_OBTENER_POR_ID,
+            "SELECT * FROM Billete WHERE ID = ?;");
+    db_bind_int(stmt, 1, id);
     
     memset(billete, 0, sizeof(Billete));
-    return db_query(sql, billete_callback, billete);
+    return db_statement_read(stmt, &billete_fila, billete);
 }
 
 // Actualizar un billete existente
@@ -132,29 +178,38 @@ bool billete_actualizar(Billete* billete) {
         return false;
     }
     
-    // Si se cambia el asiento, comprobar disponibilidad
-    if (billete_actual.asiento_id != billete->asiento_id) {
-        if (!billete_esta_disponible(billete->sesion_id, billete->asiento_id)) {
-            log_error("El nuevo asiento no está disponible para esta sesión");
-            return false;
-        }
+    // Si se cambia de asiento o de sesión, reservar el nuevo
+    bool cambia_asiento = billete_actual.sesion_id != billete->sesion_id ||
+                          billete_actual.asiento_id != billete->asiento_id;
+    if (cambia_asiento &&
+        !ocupacion_reservar_asientos(billete->sesion_id, &billete->asiento_id, 1)) {
+        log_error("El nuevo asiento no está disponible para esta sesión");
+        return false;
     }
     
     // Iniciar transacción
     if (!db_begin_transaction()) {
         log_error("Error al iniciar transacción para actualizar billete");
+        if (cambia_asiento) {
+            ocupacion_liberar_asientos(billete->sesion_id, &billete->asiento_id, 1);
+        }
         return false;
     }
     
-    char sql[512];
-    snprintf(sql, sizeof(sql),
-            "UPDATE Billete SET Sesion_ID = %d, Asiento_ID = %d, Precio = %.2f "
-            "WHERE ID = %d;",
-            billete->sesion_id, billete->asiento_id, billete->precio, billete->id);
+    sqlite3_stmt* stmt = db_statement(STMT_BILLETE_ACTUALIZAR,
+            "UPDATE Billete SET Sesion_ID = ?, Asiento_ID = ?, Precio = ? "
+            "WHERE ID = ?;");
+    db_bind_int(stmt, 1, billete->sesion_id);
+    db_bind_int(stmt, 2, billete->asiento_id);
+    db_bind_double(stmt, 3, billete->precio);
+    db_bind_int(stmt, 4, billete->id);
     
-    if (!db_execute(sql)) {
+    if (!db_statement_execute(stmt)) {
         log_error("Error al actualizar billete con ID: %d", billete->id);
         db_rollback_transaction();
+        if (cambia_asiento) {
+            ocupacion_liberar_asientos(billete->sesion_id, &billete->asiento_id, 1);
+        }
         return false;
     }
     
@@ -163,12 +218,14 @@ bool billete_actualizar(Billete* billete) {
         if (!asiento_liberar(billete_actual.asiento_id)) {
             log_error("Error al liberar el asiento anterior");
             db_rollback_transaction();
+            ocupacion_liberar_asientos(billete->sesion_id, &billete->asiento_id, 1);
             return false;
         }
         
         if (!asiento_reservar(billete->asiento_id)) {
             log_error("Error al reservar el nuevo asiento");
             db_rollback_transaction();
+            ocupacion_liberar_asientos(billete->sesion_id, &billete->asiento_id, 1);
             return false;
         }
     }
@@ -177,9 +234,16 @@ bool billete_actualizar(Billete* billete) {
     if (!db_commit_transaction()) {
         log_error("Error al confirmar transacción para actualizar billete");
         db_rollback_transaction();
+        if (cambia_asiento) {
+            ocupacion_liberar_asientos(billete->sesion_id, &billete->asiento_id, 1);
+        }
         return false;
     }
     
+    if (cambia_asiento) {
+        ocupacion_marcar_asiento(billete_actual.sesion_id, billete_actual.asiento_id, false);
+    }
+    
     log_info("Billete actualizado con ID: %d", billete->id);
     return true;
 }
@@ -199,10 +263,12 @@ bool billete_eliminar(int id) {
         return false;
     }
     
-    char sql[256];
-    snprintf(sql, sizeof(sql), "DELETE FROM Billete WHERE ID = %d;", id);
+    sqlite3_stmt* stmt = db_statement(STMT_BILLETE_ELIMINAR,
+    
+            "DELETE FROM Billete WHERE ID = ?;");
+    db_bind_int(stmt, 1, id);
     
-    if (!db_execute(sql)) {
+    if (!db_statement_execute(stmt)) {
         log_error("Error al eliminar billete con ID: %d", id);
         db_rollback_transaction();
         return false;
@@ -222,69 +288,56 @@ bool billete_eliminar(int id) {
         return false;
     }
     
+    ocupacion_marcar_asiento(billete.sesion_id, billete.asiento_id, false);
+    
     log_info("Billete eliminado con ID: %d", id);
     return true;
 }
 
 // Listar billetes por sesión
 bool billete_listar_por_sesion(int sesion_id, Billete** billetes, int* num_billetes) {
-    char sql_count[256];
-    snprintf(sql_count, sizeof(sql_count), 
-            "SELECT COUNT(*) FROM Billete WHERE Sesion_ID = %d;", sesion_id);
-    
-    int count = 0;
-    
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(get_database()->db, sql_count, -1, &stmt, NULL);
-    
-    if (rc != SQLITE_OK) {
-        log_error("Error al preparar la consulta: %s", sqlite3_errmsg(get_database()->db));
-        return false;
-    }
-    
-    rc = sqlite3_step(stmt);
-    
-    if (rc == SQLITE_ROW) {
-        count = sqlite3_column_int(stmt, 0);
-    }
+    // Consultar los billetes
+    sqlite3_stmt* stmt = db_statement(STMT_BILLETE_LISTAR_POR_SESION,
+            "SELECT * FROM Billete WHERE Sesion_ID = ?;");
+    db_bind_int(stmt, 1, sesion_id);
     
-    sqlite3_finalize(stmt);
+    ResultSet resultado;
+    result_set_init(&resultado, sizeof(Billete));
     
-    if (count == 0) {
+    if (!db_statement_read_all(stmt, &billete_fila, &resultado)) {
+        result_set_free(&resultado);
         *billetes = NULL;
         *num_billetes = 0;
-        return true;
-    }
-    
-    // Asignar memoria para los billetes
-    *billetes = (Billete*)MEM_ALLOC(count * sizeof(Billete));
-    if (!*billetes) {
-        log_error("Error al asignar memoria para la lista de billetes");
+        log_error("Error al consultar la lista de billetes");
         return false;
     }
     
-    // Consultar los billetes
-    char sql[256];
-    snprintf(sql, sizeof(sql), 
-            "SELECT * FROM Billete WHERE Sesion_ID = %d;", sesion_id);
-    
-    struct {
-        Billete* billetes;
-        int max_billetes;
-        int* num_billetes;
-    } callback_data = {*billetes, count, num_billetes};
+    *billetes = (Billete*)result_set_take(&resultado, num_billetes);
     
-    *num_billetes = 0;  // Inicializar el contador
-    
-    if (!db_query(sql, billetes_listar_callback, &callback_data)) {
-        MEM_FREE(*billetes);
+    log_info("Se listaron %d billetes para la sesión %d", *num_billetes, sesion_id);
+    return true;
+}
+
+// Listar los billetes de una venta
+bool billete_listar_por_venta(int venta_id, Billete** billetes, int* num_billetes) {
+    sqlite3_stmt* stmt = db_statement(STMT_BILLETE_LISTAR_POR_VENTA,
+            "SELECT B.* FROM Billete B "
+            "JOIN Venta_Billetes VB ON VB.Billete_ID = B.ID "
+            "WHERE VB.Venta_ID = ?;");
+    db_bind_int(stmt, 1, venta_id);
+    
+    ResultSet resultado;
+    result_set_init(&resultado, sizeof(Billete));
+    
+    if (!db_statement_read_all(stmt, &billete_fila, &resultado)) {
+        result_set_free(&resultado);
         *billetes = NULL;
         *num_billetes = 0;
-        log_error("Error al consultar la lista de billetes");
+        log_error("Error al consultar los billetes de la venta %d", venta_id);
         return false;
     }
     
-    log_info("Se listaron %d billetes para la sesión %d", *num_billetes, sesion_id);
+    *billetes = (Billete*)result_set_take(&resultado, num_billetes);
     return true;
 }
 
@@ -325,38 +378,16 @@ bool billete_validar(Billete* billete) {
     return true;
 }
 
-// Comprobar si un asiento está disponible para una sesión
+// Comprobar si un asiento está disponible para una sesión. Se responde con el
+// inventario de la sesión: Asiento.Estado es de la sala y no dice nada de
+// una sesión concreta
 bool billete_esta_disponible(int sesion_id, int asiento_id) {
-    // Comprobar que el asiento está libre
-    if (!asiento_esta_disponible(asiento_id)) {
+    bool ocupado = true;
+    if (!ocupacion_asiento_ocupado(sesion_id, asiento_id, &ocupado)) {
         return false;
     }
     
-    // Comprobar que no hay un billete para ese asiento en esa sesión
-    char sql[256];
-    snprintf(sql, sizeof(sql), 
-            "SELECT COUNT(*) FROM Billete WHERE Sesion_ID = %d AND Asiento_ID = %d;", 
-            sesion_id, asiento_id);
-    
-    int count = 0;
-    
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(get_database()->db, sql, -1, &stmt, NULL);
-    
-    if (rc != SQLITE_OK) {
-        log_error("Error al preparar la consulta: %s", sqlite3_errmsg(get_database()->db));
-        return false;
-    }
-    
-    rc = sqlite3_step(stmt);
-    
-    if (rc == SQLITE_ROW) {
-        count = sqlite3_column_int(stmt, 0);
-    }
-    
-    sqlite3_finalize(stmt);
-    
-    return count == 0;
+    return !ocupado;
 }
 
 // Calcular el precio base de un billete para una sesión
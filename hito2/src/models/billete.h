@@ -17,6 +17,18 @@ bool billete_obtener_por_id(int id, Billete* billete);
 bool billete_actualizar(Billete* billete);
 bool billete_eliminar(int id);
 bool billete_listar_por_sesion(int sesion_id, Billete** billetes, int* num_billetes);
+bool billete_listar_por_venta(int venta_id, Billete** billetes, int* num_billetes);
+
+// Crear un billete cuyo asiento ya está reservado en el inventario de la
+// sesión (por ejemplo, por una retención). No vuelve a validar la sesión ni
+// el asiento; si falla, el asiento sigue reservado
+bool billete_crear_reservado(Billete* billete);
+
+// Crear de golpe los billetes sin ID (los que ya tienen ID se omiten), con
+// un INSERT de varias filas por cada DB_BATCH_ROWS billetes. Sus asientos
+// deben estar ya reservados en el inventario y debe llamarse dentro de una
+// transacción: si falla, quien llama la revierte
+bool billete_crear_lote(Billete* billetes, int num_billetes);
 
 // Funciones adicionales
 bool billete_validar(Billete* billete);
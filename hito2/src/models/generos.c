@@ -0,0 +1,402 @@
+#include "generos.h"
+#include "titulos.h"
+#include "../utils/logger.h"
+#include "../utils/memory.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+// Longitud máxima del nombre de un género (la de Pelicula.genero)
+#define GENEROS_MAX_NOMBRE 100
+
+// Géneros que se tienen en cuenta de una película o de una búsqueda
+#define GENEROS_MAX_LISTA 16
+
+// Género del catálogo. Su id es su posición en g_generos
+typedef struct {
+    char nombre[GENEROS_MAX_NOMBRE];    // Normalizado
+    int* peliculas;                     // Ids ordenados
+    int num;
+    int capacidad;
+} Genero;
+
+static bool g_cargado = false;
+
+static Genero* g_generos;
+static int g_num_generos;
+static int g_capacidad_generos;
+
+// Las películas se guardan desde el hilo escritor, pero se buscan desde
+// cualquier hilo
+static pthread_mutex_t g_generos_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Separar una lista de géneros ("Drama, Crimen") en nombres normalizados y
+// sin repetir
+static int generos_separar(const char* texto, char nombres[][GENEROS_MAX_NOMBRE], int max) {
+    int num = 0;
+    const char* p = texto;
+    
+    while (*p && num < max) {
+        const char* fin = strchr(p, ',');
+        size_t longitud = fin ? (size_t)(fin - p) : strlen(p);
+        
+        char parte[GENEROS_MAX_NOMBRE];
+        if (longitud >= sizeof(parte)) {
+            longitud = sizeof(parte) - 1;
+        }
+        memcpy(parte, p, longitud);
+        parte[longitud] = '\0';
+        
+        titulos_normalizar(parte, nombres[num], GENEROS_MAX_NOMBRE);
+        
+        bool repetido = nombres[num][0] == '\0';
+        for (int i = 0; i < num && !repetido; i++) {
+            repetido = strcmp(nombres[i], nombres[num]) == 0;
+        }
+        if (!repetido) {
+            num++;
+        }
+        
+        if (!fin) {
+            break;
+        }
+        p = fin + 1;
+    }
+    
+    return num;
+}
+
+static int generos_buscar_id(const char* nombre) {
+    for (int i = 0; i < g_num_generos; i++) {
+        if (strcmp(g_generos[i].nombre, nombre) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Id de un género, dándolo de alta si es nuevo. Devuelve -1 si no hay memoria
+static int generos_obtener_id(const char* nombre) {
+    int id = generos_buscar_id(nombre);
+    if (id >= 0) {
+        return id;
+    }
+    
+    if (g_num_generos == g_capacidad_generos) {
+        int capacidad = g_capacidad_generos > 0 ? g_capacidad_generos * 2 : 16;
+        Genero* generos = (Genero*)MEM_REALLOC(g_generos, capacidad * sizeof(Genero));
+        if (!generos) {
+            return -1;
+        }
+        
+        g_generos = generos;
+        g_capacidad_generos = capacidad;
+    }
+    
+    Genero* genero = &g_generos[g_num_generos];
+    memset(genero, 0, sizeof(Genero));
+    strncpy(genero->nombre, nombre, GENEROS_MAX_NOMBRE - 1);
+    return g_num_generos++;
+}
+
+// Primera posición de ids con un valor >= id
+static int generos_posicion(const int* ids, int num, int id) {
+    int bajo = 0;
+    int alto = num;
+    
+    while (bajo < alto) {
+        int medio = (bajo + alto) / 2;
+        if (ids[medio] < id) {
+            bajo = medio + 1;
+        } else {
+            alto = medio;
+        }
+    }
+    
+    return bajo;
+}
+
+static bool generos_insertar_pelicula(Genero* genero, int pelicula_id) {
+    // Las películas nuevas tienen el id más alto y van al final
+    int posicion = genero->num;
+    if (posicion > 0 && genero->peliculas[posicion - 1] >= pelicula_id) {
+        posicion = generos_posicion(genero->peliculas, genero->num, pelicula_id);
+        if (posicion < genero->num && genero->peliculas[posicion] == pelicula_id) {
+            return true;
+        }
+    }
+    
+    if (genero->num == genero->capacidad) {
+        int capacidad = genero->capacidad > 0 ? genero->capacidad * 2 : 64;
+        int* peliculas = (int*)MEM_REALLOC(genero->peliculas, capacidad * sizeof(int));
+        if (!peliculas) {
+            return false;
+        }
+        
+        genero->peliculas = peliculas;
+        genero->capacidad = capacidad;
+    }
+    
+    memmove(&genero->peliculas[posicion + 1], &genero->peliculas[posicion],
+            (genero->num - posicion) * sizeof(int));
+    genero->peliculas[posicion] = pelicula_id;
+    genero->num++;
+    return true;
+}
+
+// Quitar una película de todos los géneros (con el mutex tomado)
+static void generos_quitar(int pelicula_id) {
+    for (int i = 0; i < g_num_generos; i++) {
+        Genero* genero = &g_generos[i];
+        int posicion = generos_posicion(genero->peliculas, genero->num, pelicula_id);
+        
+        if (posicion < genero->num && genero->peliculas[posicion] == pelicula_id) {
+            memmove(&genero->peliculas[posicion], &genero->peliculas[posicion + 1],
+                    (genero->num - posicion - 1) * sizeof(int));
+            genero->num--;
+        }
+    }
+}
+
+// Añadir una película a sus géneros (con el mutex tomado)
+static bool generos_anadir(const Pelicula* pelicula) {
+    char nombres[GENEROS_MAX_LISTA][GENEROS_MAX_NOMBRE];
+    int num_nombres = generos_separar(pelicula->genero, nombres, GENEROS_MAX_LISTA);
+    
+    for (int i = 0; i < num_nombres; i++) {
+        int id = generos_obtener_id(nombres[i]);
+        if (id < 0 || !generos_insertar_pelicula(&g_generos[id], pelicula->id)) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+// Liberar el índice (con el mutex tomado)
+static void generos_descartar() {
+    for (int i = 0; i < g_num_generos; i++) {
+        if (g_generos[i].peliculas) {
+            MEM_FREE(g_generos[i].peliculas);
+        }
+    }
+    
+    if (g_generos) {
+        MEM_FREE(g_generos);
+    }
+    
+    g_generos = NULL;
+    g_num_generos = 0;
+    g_capacidad_generos = 0;
+    g_cargado = false;
+}
+
+// Construir el índice a partir de la base de datos
+static bool generos_cargar() {
+    Pelicula* peliculas = NULL;
+    int num_peliculas = 0;
+    if (!pelicula_listar(&peliculas, &num_peliculas)) {
+        log_error("No se pudieron obtener las películas para el índice de géneros");
+        return false;
+    }
+    
+    for (int i = 0; i < num_peliculas; i++) {
+        if (!generos_anadir(&peliculas[i])) {
+            log_error("Error al asignar memoria para el índice de géneros");
+            generos_descartar();
+            pelicula_liberar_lista(peliculas, num_peliculas);
+            return false;
+        }
+    }
+    
+    pelicula_liberar_lista(peliculas, num_peliculas);
+    g_cargado = true;
+    
+    log_info("Índice de géneros cargado (%d películas, %d géneros)", num_peliculas, g_num_generos);
+    return true;
+}
+
+static int generos_comparar_tamano(const void* a, const void* b) {
+    const Genero* x = *(const Genero* const*)a;
+    const Genero* y = *(const Genero* const*)b;
+    return x->num - y->num;
+}
+
+// Películas con todos los géneros: se parte del género con menos películas
+// y se descartan las que no están en los demás
+static int generos_cruzar(const Genero** lista, int num_lista, int* ids) {
+    qsort(lista, num_lista, sizeof(Genero*), generos_comparar_tamano);
+    
+    int num = lista[0]->num;
+    memcpy(ids, lista[0]->peliculas, num * sizeof(int));
+    
+    for (int i = 1; i < num_lista && num > 0; i++) {
+        int quedan = 0;
+        for (int j = 0; j < num; j++) {
+            int posicion = generos_posicion(lista[i]->peliculas, lista[i]->num, ids[j]);
+            if (posicion < lista[i]->num && lista[i]->peliculas[posicion] == ids[j]) {
+                ids[quedan++] = ids[j];
+            }
+        }
+        num = quedan;
+    }
+    
+    return num;
+}
+
+// Películas con alguno de los géneros: mezcla ordenada de las listas, sin
+// repetir. aux tiene el mismo tamaño que ids
+static int generos_unir(const Genero** lista, int num_lista, int* ids, int* aux) {
+    int num = 0;
+    
+    for (int i = 0; i < num_lista; i++) {
+        const int* otra = lista[i]->peliculas;
+        int num_otra = lista[i]->num;
+        int a = 0, b = 0, mezcla = 0;
+        
+        while (a < num || b < num_otra) {
+            if (b == num_otra || (a < num && ids[a] < otra[b])) {
+                aux[mezcla++] = ids[a++];
+            } else if (a == num || otra[b] < ids[a]) {
+                aux[mezcla++] = otra[b++];
+            } else {
+                aux[mezcla++] = ids[a++];
+                b++;
+            }
+        }
+        
+        memcpy(ids, aux, mezcla * sizeof(int));
+        num = mezcla;
+    }
+    
+    return num;
+}
+
+// Buscar películas por combinación de géneros
+bool generos_buscar(const char* const* generos, int num_generos, ModoGeneros modo,
+                    int desde, int limite, Pelicula** peliculas, int* num_peliculas, int* total) {
+    *peliculas = NULL;
+    *num_peliculas = 0;
+    *total = 0;
+    
+    // Cada elemento puede ser a su vez una lista separada por comas
+    char nombres[GENEROS_MAX_LISTA][GENEROS_MAX_NOMBRE];
+    int num_nombres = 0;
+    for (int i = 0; i < num_generos && num_nombres < GENEROS_MAX_LISTA; i++) {
+        num_nombres += generos_separar(generos[i] ? generos[i] : "", nombres + num_nombres,
+                                       GENEROS_MAX_LISTA - num_nombres);
+    }
+    
+    pthread_mutex_lock(&g_generos_mutex);
+    
+    if (!g_cargado && !generos_cargar()) {
+        pthread_mutex_unlock(&g_generos_mutex);
+        return false;
+    }
+    
+    const Genero* lista[GENEROS_MAX_LISTA];
+    int num_lista = 0;
+    int max_ids = 0;
+    
+    for (int i = 0; i < num_nombres; i++) {
+        int id = generos_buscar_id(nombres[i]);
+        if (id < 0) {
+            if (modo == GENEROS_TODOS) {
+                // Ninguna película tiene un género que no existe
+                num_lista = 0;
+                break;
+            }
+            continue;
+        }
+        
+        lista[num_lista++] = &g_generos[id];
+        max_ids += g_generos[id].num;
+    }
+    
+    int* ids = NULL;
+    int num_ids = 0;
+    
+    if (num_lista > 0 && max_ids > 0) {
+        // En la unión hace falta un segundo array para mezclar
+        int reserva = modo == GENEROS_ALGUNO ? max_ids * 2 : max_ids;
+        ids = (int*)MEM_ALLOC(reserva * sizeof(int));
+        if (!ids) {
+            pthread_mutex_unlock(&g_generos_mutex);
+            log_error("Error al asignar memoria para la búsqueda de géneros");
+            return false;
+        }
+        
+        num_ids = modo == GENEROS_TODOS
+                ? generos_cruzar(lista, num_lista, ids)
+                : generos_unir(lista, num_lista, ids, ids + max_ids);
+    }
+    
+    pthread_mutex_unlock(&g_generos_mutex);
+    
+    *total = num_ids;
+    
+    // Solo se leen las películas de la página pedida
+    if (desde < 0) {
+        desde = 0;
+    }
+    int num_pagina = desde < num_ids ? num_ids - desde : 0;
+    if (limite > 0 && num_pagina > limite) {
+        num_pagina = limite;
+    }
+    
+    if (num_pagina > 0) {
+        *peliculas = (Pelicula*)MEM_ALLOC(num_pagina * sizeof(Pelicula));
+        if (!*peliculas) {
+            MEM_FREE(ids);
+            log_error("Error al asignar memoria para la búsqueda de géneros");
+            return false;
+        }
+        
+        for (int i = 0; i < num_pagina; i++) {
+            // Si se ha borrado desde que se consultó el índice, se omite
+            if (pelicula_obtener_por_id(ids[desde + i], &(*peliculas)[*num_peliculas])) {
+                (*num_peliculas)++;
+            }
+        }
+    }
+    
+    if (ids) {
+        MEM_FREE(ids);
+    }
+    
+    return true;
+}
+
+// Añadir o actualizar una película en el índice
+void generos_guardar_pelicula(const Pelicula* pelicula) {
+    pthread_mutex_lock(&g_generos_mutex);
+    
+    if (g_cargado) {
+        generos_quitar(pelicula->id);
+        if (!generos_anadir(pelicula)) {
+            // Sin memoria; se volverá a cargar de la base de datos
+            generos_descartar();
+        }
+    }
+    
+    pthread_mutex_unlock(&g_generos_mutex);
+}
+
+// Quitar una película del índice
+void generos_quitar_pelicula(int pelicula_id) {
+    pthread_mutex_lock(&g_generos_mutex);
+    
+    if (g_cargado) {
+        generos_quitar(pelicula_id);
+    }
+    
+    pthread_mutex_unlock(&g_generos_mutex);
+}
+
+// Descartar el índice
+void generos_limpiar() {
+    pthread_mutex_lock(&g_generos_mutex);
+    generos_descartar();
+    pthread_mutex_unlock(&g_generos_mutex);
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#ifndef GENEROS_H
+#define GENEROS_H
+
+#include <stdbool.h>
+#include "pelicula.h"
+
+// Índice en memoria de los géneros de las películas. El campo genero de una
+// película es una lista separada por comas ("Drama, Crimen"); cada género se
+// normaliza (minúsculas, sin tildes) y recibe un id, y por cada id se guarda
+// la lista ordenada de películas que lo tienen. Las combinaciones de géneros
+// se resuelven cruzando o uniendo esas listas sin recorrer el catálogo.
+// La primera búsqueda lo carga de la base de datos; después se mantiene con
+// las altas, cambios y bajas de películas
+
+// Forma de combinar los géneros de una búsqueda
+typedef enum {
+    GENEROS_TODOS = 0,      // Películas con todos los géneros (AND)
+    GENEROS_ALGUNO = 1      // Películas con alguno de los géneros (OR)
+} ModoGeneros;
+
+// Buscar las películas de una combinación de géneros, ordenadas por id.
+// Devuelve la página que empieza en desde con hasta limite películas
+// (limite <= 0 devuelve el resto) y, en total, cuántas hay en todas las páginas
+bool generos_buscar(const char* const* generos, int num_generos, ModoGeneros modo,
+                    int desde, int limite, Pelicula** peliculas, int* num_peliculas, int* total);
+
+// Mantener el índice al crear o modificar (guardar) y eliminar películas
+void generos_guardar_pelicula(const Pelicula* pelicula);
+void generos_quitar_pelicula(int pelicula_id);
+
+// Descartar el índice
+void generos_limpiar();
+
+#endif // GENEROS_H
\ No newline at end of file
@@ -0,0 +1,405 @@
+#include "horario.h"
+#include "sesion.h"
+#include "../utils/logger.h"
+#include "../utils/memory.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+// Número de listas de la tabla hash de salas (potencia de 2)
+#define HORARIO_NUM_CUBOS 64
+
+// Referencia nula entre nodos del árbol
+#define HORARIO_NULO -1
+
+// Nodo del árbol de intervalos de una sala. Es un AVL ordenado por
+// (inicio, sesion_id) en el que cada nodo guarda además el fin más tardío de
+// su subárbol, lo que permite descartar ramas enteras al buscar solapes
+typedef struct {
+    int64_t inicio;
+    int64_t fin;
+    int64_t fin_maximo;
+    int sesion_id;
+    int altura;
+    int izquierdo;
+    int derecho;            // En los nodos libres, siguiente nodo libre
+} NodoHorario;
+
+// Índice de una sala. Los nodos se guardan en un array que crece según haga
+// falta, así que una sala con miles de sesiones usa una sola reserva
+typedef struct HorarioSala {
+    int sala_id;
+    NodoHorario* nodos;
+    int capacidad;
+    int libre;              // Primer nodo libre del array
+    int raiz;
+    struct HorarioSala* siguiente;
+} HorarioSala;
+
+// Tabla hash de salas con el índice ya cargado
+static HorarioSala* g_cubos[HORARIO_NUM_CUBOS];
+
+// Las sesiones se crean desde el hilo escritor, pero el índice puede
+// consultarse desde cualquier hilo
+static pthread_mutex_t g_horario_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static HorarioSala** horario_cubo(int sala_id) {
+    return &g_cubos[(unsigned int)sala_id & (HORARIO_NUM_CUBOS - 1)];
+}
+
+static HorarioSala* horario_buscar(int sala_id) {
+    HorarioSala* sala = *horario_cubo(sala_id);
+    
+    while (sala && sala->sala_id != sala_id) {
+        sala = sala->siguiente;
+    }
+    
+    return sala;
+}
+
+static void horario_liberar_sala(HorarioSala* sala) {
+    if (sala->nodos) {
+        MEM_FREE(sala->nodos);
+    }
+    MEM_FREE(sala);
+}
+
+static int horario_altura(HorarioSala* sala, int nodo) {
+    return nodo == HORARIO_NULO ? 0 : sala->nodos[nodo].altura;
+}
+
+static int64_t horario_fin_maximo(HorarioSala* sala, int nodo) {
+    return nodo == HORARIO_NULO ? INT64_MIN : sala->nodos[nodo].fin_maximo;
+}
+
+// Recalcular la altura y el fin máximo de un nodo a partir de sus hijos
+static void horario_actualizar(HorarioSala* sala, int nodo) {
+    NodoHorario* n = &sala->nodos[nodo];
+    int altura_izquierda = horario_altura(sala, n->izquierdo);
+    int altura_derecha = horario_altura(sala, n->derecho);
+    int64_t fin_izquierdo = horario_fin_maximo(sala, n->izquierdo);
+    int64_t fin_derecho = horario_fin_maximo(sala, n->derecho);
+    
+    n->altura = 1 + (altura_izquierda > altura_derecha ? altura_izquierda : altura_derecha);
+    n->fin_maximo = n->fin;
+    if (fin_izquierdo > n->fin_maximo) {
+        n->fin_maximo = fin_izquierdo;
+    }
+    if (fin_derecho > n->fin_maximo) {
+        n->fin_maximo = fin_derecho;
+    }
+}
+
+static int horario_rotar_derecha(HorarioSala* sala, int nodo) {
+    int izquierdo = sala->nodos[nodo].izquierdo;
+    sala->nodos[nodo].izquierdo = sala->nodos[izquierdo].derecho;
+    sala->nodos[izquierdo].derecho = nodo;
+    horario_actualizar(sala, nodo);
+    horario_actualizar(sala, izquierdo);
+    return izquierdo;
+}
+
+static int horario_rotar_izquierda(HorarioSala* sala, int nodo) {
+    int derecho = sala->nodos[nodo].derecho;
+    sala->nodos[nodo].derecho = sala->nodos[derecho].izquierdo;
+    sala->nodos[derecho].izquierdo = nodo;
+    horario_actualizar(sala, nodo);
+    horario_actualizar(sala, derecho);
+    return derecho;
+}
+
+// Restaurar el equilibrio AVL de un nodo tras modificar uno de sus hijos
+static int horario_equilibrar(HorarioSala* sala, int nodo) {
+    horario_actualizar(sala, nodo);
+    
+    NodoHorario* n = &sala->nodos[nodo];
+    int balance = horario_altura(sala, n->izquierdo) - horario_altura(sala, n->derecho);
+    
+    if (balance > 1) {
+        NodoHorario* izquierdo = &sala->nodos[n->izquierdo];
+        if (horario_altura(sala, izquierdo->izquierdo) < horario_altura(sala, izquierdo->derecho)) {
+            n->izquierdo = horario_rotar_izquierda(sala, n->izquierdo);
+        }
+        return horario_rotar_derecha(sala, nodo);
+    }
+    
+    if (balance < -1) {
+        NodoHorario* derecho = &sala->nodos[n->derecho];
+        if (horario_altura(sala, derecho->derecho) < horario_altura(sala, derecho->izquierdo)) {
+            n->derecho = horario_rotar_derecha(sala, n->derecho);
+        }
+        return horario_rotar_izquierda(sala, nodo);
+    }
+    
+    return nodo;
+}
+
+// Orden de los nodos: por inicio y, a igual inicio, por ID de sesión
+static int horario_comparar(int64_t inicio, int sesion_id, const NodoHorario* n) {
+    if (inicio != n->inicio) {
+        return inicio < n->inicio ? -1 : 1;
+    }
+    if (sesion_id != n->sesion_id) {
+        return sesion_id < n->sesion_id ? -1 : 1;
+    }
+    return 0;
+}
+
+// Reservar un nodo del array de la sala; devuelve HORARIO_NULO si no hay memoria
+static int horario_nuevo_nodo(HorarioSala* sala) {
+    if (sala->libre == HORARIO_NULO) {
+        int capacidad = sala->capacidad > 0 ? sala->capacidad * 2 : 16;
+        NodoHorario* nodos = (NodoHorario*)MEM_REALLOC(sala->nodos, capacidad * sizeof(NodoHorario));
+        if (!nodos) {
+            return HORARIO_NULO;
+        }
+        
+        // Encadenar los nodos nuevos en la lista de libres
+        for (int i = sala->capacidad; i < capacidad; i++) {
+            nodos[i].derecho = i + 1 < capacidad ? i + 1 : HORARIO_NULO;
+        }
+        
+        sala->libre = sala->capacidad;
+        sala->nodos = nodos;
+        sala->capacidad = capacidad;
+    }
+    
+    int nodo = sala->libre;
+    sala->libre = sala->nodos[nodo].derecho;
+    return nodo;
+}
+
+static void horario_liberar_nodo(HorarioSala* sala, int nodo) {
+    sala->nodos[nodo].derecho = sala->libre;
+    sala->libre = nodo;
+}
+
+static int horario_insertar(HorarioSala* sala, int raiz, int nuevo) {
+    if (raiz == HORARIO_NULO) {
+        return nuevo;
+    }
+    
+    NodoHorario* n = &sala->nodos[nuevo];
+    if (horario_comparar(n->inicio, n->sesion_id, &sala->nodos[raiz]) < 0) {
+        int izquierdo = horario_insertar(sala, sala->nodos[raiz].izquierdo, nuevo);
+        sala->nodos[raiz].izquierdo = izquierdo;
+    } else {
+        int derecho = horario_insertar(sala, sala->nodos[raiz].derecho, nuevo);
+        sala->nodos[raiz].derecho = derecho;
+    }
+    
+    return horario_equilibrar(sala, raiz);
+}
+
+// Separar el nodo mínimo de un subárbol
+static int horario_quitar_minimo(HorarioSala* sala, int raiz, int* minimo) {
+    if (sala->nodos[raiz].izquierdo == HORARIO_NULO) {
+        *minimo = raiz;
+        return sala->nodos[raiz].derecho;
+    }
+    
+    int izquierdo = horario_quitar_minimo(sala, sala->nodos[raiz].izquierdo, minimo);
+    sala->nodos[raiz].izquierdo = izquierdo;
+    return horario_equilibrar(sala, raiz);
+}
+
+static int horario_borrar(HorarioSala* sala, int raiz, int64_t inicio, int sesion_id) {
+    if (raiz == HORARIO_NULO) {
+        return HORARIO_NULO;
+    }
+    
+    int comparacion = horario_comparar(inicio, sesion_id, &sala->nodos[raiz]);
+    
+    if (comparacion < 0) {
+        int izquierdo = horario_borrar(sala, sala->nodos[raiz].izquierdo, inicio, sesion_id);
+        sala->nodos[raiz].izquierdo = izquierdo;
+    } else if (comparacion > 0) {
+        int derecho = horario_borrar(sala, sala->nodos[raiz].derecho, inicio, sesion_id);
+        sala->nodos[raiz].derecho = derecho;
+    } else {
+        // El sucesor ocupa el lugar del nodo borrado
+        int izquierdo = sala->nodos[raiz].izquierdo;
+        int derecho = sala->nodos[raiz].derecho;
+        horario_liberar_nodo(sala, raiz);
+        
+        if (derecho == HORARIO_NULO) {
+            return izquierdo;
+        }
+        
+        int sucesor;
+        derecho = horario_quitar_minimo(sala, derecho, &sucesor);
+        sala->nodos[sucesor].izquierdo = izquierdo;
+        sala->nodos[sucesor].derecho = derecho;
+        return horario_equilibrar(sala, sucesor);
+    }
+    
+    return horario_equilibrar(sala, raiz);
+}
+
+// Buscar un intervalo que se solape con [inicio, fin). Se descartan los
+// subárboles cuyo fin máximo no llega a inicio y, como el árbol está ordenado
+// por inicio, todo lo que empieza en fin o después
+static bool horario_buscar_solape(HorarioSala* sala, int nodo, int64_t inicio, int64_t fin, int excluir) {
+    while (nodo != HORARIO_NULO && sala->nodos[nodo].fin_maximo > inicio) {
+        NodoHorario* n = &sala->nodos[nodo];
+        
+        if (horario_buscar_solape(sala, n->izquierdo, inicio, fin, excluir)) {
+            return true;
+        }
+        
+        if (n->inicio >= fin) {
+            return false;
+        }
+        
+        if (n->fin > inicio && n->sesion_id != excluir) {
+            return true;
+        }
+        
+        nodo = n->derecho;
+    }
+    
+    return false;
+}
+
+// Añadir una sesión al árbol de una sala ya cargada
+static bool horario_anadir(HorarioSala* sala, int sesion_id, int64_t inicio, int64_t fin) {
+    int nodo = horario_nuevo_nodo(sala);
+    if (nodo == HORARIO_NULO) {
+        return false;
+    }
+    
+    NodoHorario* n = &sala->nodos[nodo];
+    n->inicio = inicio;
+    n->fin = fin;
+    n->fin_maximo = fin;
+    n->sesion_id = sesion_id;
+    n->altura = 1;
+    n->izquierdo = HORARIO_NULO;
+    n->derecho = HORARIO_NULO;
+    
+    sala->raiz = horario_insertar(sala, sala->raiz, nodo);
+    return true;
+}
+
+// Construir el índice de una sala a partir de la base de datos
+static HorarioSala* horario_cargar(int sala_id) {
+    Sesion* sesiones = NULL;
+    int num_sesiones = 0;
+    if (!sesion_buscar_por_sala(sala_id, &sesiones, &num_sesiones)) {
+        log_error("No se pudieron obtener las sesiones de la sala %d", sala_id);
+        return NULL;
+    }
+    
+    HorarioSala* sala = (HorarioSala*)MEM_ALLOC(sizeof(HorarioSala));
+    if (!sala) {
+        log_error("Error al asignar memoria para el horario de la sala %d", sala_id);
+        sesion_liberar_lista(sesiones, num_sesiones);
+        return NULL;
+    }
+    
+    memset(sala, 0, sizeof(HorarioSala));
+    sala->sala_id = sala_id;
+    sala->libre = HORARIO_NULO;
+    sala->raiz = HORARIO_NULO;
+    
+    for (int i = 0; i < num_sesiones; i++) {
+        if (!horario_anadir(sala, sesiones[i].id, sesiones[i].inicio, sesiones[i].fin)) {
+            log_error("Error al asignar memoria para el horario de la sala %d", sala_id);
+            horario_liberar_sala(sala);
+            sesion_liberar_lista(sesiones, num_sesiones);
+            return NULL;
+        }
+    }
+    
+    sesion_liberar_lista(sesiones, num_sesiones);
+    
+    // Añadir a la tabla
+    HorarioSala** cubo = horario_cubo(sala_id);
+    sala->siguiente = *cubo;
+    *cubo = sala;
+    
+    log_info("Horario cargado para la sala %d (%d sesiones)", sala_id, num_sesiones);
+    return sala;
+}
+
+// Quitar de la tabla el índice de una sala (con el mutex tomado)
+static void horario_descartar(int sala_id) {
+    HorarioSala** actual = horario_cubo(sala_id);
+    
+    while (*actual) {
+        if ((*actual)->sala_id == sala_id) {
+            HorarioSala* eliminada = *actual;
+            *actual = eliminada->siguiente;
+            horario_liberar_sala(eliminada);
+            return;
+        }
+        actual = &(*actual)->siguiente;
+    }
+}
+
+// Comprobar si alguna sesión de la sala se solapa con [inicio, fin)
+bool horario_hay_solape(int sala_id, int64_t inicio, int64_t fin, int excluir_sesion_id, bool* solapa) {
+    pthread_mutex_lock(&g_horario_mutex);
+    
+    HorarioSala* sala = horario_buscar(sala_id);
+    if (!sala) {
+        sala = horario_cargar(sala_id);
+        if (!sala) {
+            pthread_mutex_unlock(&g_horario_mutex);
+            return false;
+        }
+    }
+    
+    *solapa = horario_buscar_solape(sala, sala->raiz, inicio, fin, excluir_sesion_id);
+    
+    pthread_mutex_unlock(&g_horario_mutex);
+    return true;
+}
+
+// Añadir una sesión al índice de su sala
+void horario_anadir_sesion(int sala_id, int sesion_id, int64_t inicio, int64_t fin) {
+    pthread_mutex_lock(&g_horario_mutex);
+    
+    HorarioSala* sala = horario_buscar(sala_id);
+    if (sala && !horario_anadir(sala, sesion_id, inicio, fin)) {
+        // Sin memoria para el nodo; se volverá a cargar de la base de datos
+        horario_descartar(sala_id);
+    }
+    
+    pthread_mutex_unlock(&g_horario_mutex);
+}
+
+// Quitar una sesión del índice de su sala
+void horario_quitar_sesion(int sala_id, int sesion_id, int64_t inicio) {
+    pthread_mutex_lock(&g_horario_mutex);
+    
+    HorarioSala* sala = horario_buscar(sala_id);
+    if (sala) {
+        sala->raiz = horario_borrar(sala, sala->raiz, inicio, sesion_id);
+    }
+    
+    pthread_mutex_unlock(&g_horario_mutex);
+}
+
+// Descartar el índice de una sala
+void horario_invalidar_sala(int sala_id) {
+    pthread_mutex_lock(&g_horario_mutex);
+    horario_descartar(sala_id);
+    pthread_mutex_unlock(&g_horario_mutex);
+}
+
+// Descartar todos los índices
+void horario_limpiar() {
+    pthread_mutex_lock(&g_horario_mutex);
+    
+    for (int i = 0; i < HORARIO_NUM_CUBOS; i++) {
+        while (g_cubos[i]) {
+            HorarioSala* eliminada = g_cubos[i];
+            g_cubos[i] = eliminada->siguiente;
+            horario_liberar_sala(eliminada);
+        }
+    }
+    
+    pthread_mutex_unlock(&g_horario_mutex);
+}
\ No newline at end of file
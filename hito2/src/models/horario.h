@@ -0,0 +1,27 @@
+#ifndef HORARIO_H
+#define HORARIO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Índice en memoria de las sesiones programadas en cada sala, para comprobar
+// solapes sin recorrer la tabla Sesion. Cada sala tiene un árbol de
+// intervalos [inicio, fin) con las horas en segundos desde la época.
+// La primera consulta de cada sala lo carga de la base de datos; después se
+// mantiene con las altas, cambios y bajas de sesiones
+
+// Comprobar si alguna sesión de la sala (salvo excluir_sesion_id) se solapa
+// con [inicio, fin). Devuelve false si no se pudo cargar el índice de la sala
+bool horario_hay_solape(int sala_id, int64_t inicio, int64_t fin, int excluir_sesion_id, bool* solapa);
+
+// Mantener el índice al crear, mover o eliminar una sesión
+void horario_anadir_sesion(int sala_id, int sesion_id, int64_t inicio, int64_t fin);
+void horario_quitar_sesion(int sala_id, int sesion_id, int64_t inicio);
+
+// Descartar el índice de una sala para que se vuelva a cargar
+void horario_invalidar_sala(int sala_id);
+
+// Descartar todos los índices
+void horario_limpiar();
+
+#endif // HORARIO_H
\ No newline at end of file
@@ -0,0 +1,816 @@
+#include "ocupacion.h"
+#include "asiento.h"
+#include "billete.h"
+#include "sesion.h"
+#include "../utils/logger.h"
+#include "../utils/memory.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <pthread.h>
+
+// Número de listas de la tabla hash de mapas (potencia de 2)
+#define OCUPACION_NUM_CUBOS 256
+
+// Asientos por palabra del mapa
+#define OCUPACION_BITS_PALABRA 64
+
+// Máximo de asientos en una misma reserva
+#define OCUPACION_MAX_RESERVA 256
+
+// Palabras de una fila en la búsqueda de asientos contiguos (4096 columnas)
+#define OCUPACION_MAX_PALABRAS_FILA 64
+
+// Posición de un asiento en el mapa, para buscarla por ID
+typedef struct {
+    int asiento_id;
+    int posicion;
+} PosicionAsiento;
+
+// Mapa de una sesión guardado en memoria
+typedef struct EntradaOcupacion {
+    int sesion_id;
+    int sala_id;
+    int num_asientos;
+    int* asiento_ids;               // ID del asiento en cada posición del mapa
+    PosicionAsiento* por_id;        // Posiciones ordenadas por ID de asiento
+    uint64_t* palabras;             // Bit i en palabras[i / 64]; solo con operaciones atómicas
+    struct EntradaOcupacion* siguiente;
+} EntradaOcupacion;
+
+// Asientos retenidos de una sesión (retencion.h). Las retenciones no tienen
+// billete en la base de datos, así que esta lista sobrevive a descartar el
+// mapa: al volver a cargarlo se marcan de nuevo
+typedef struct RetenidosSesion {
+    int sesion_id;
+    int num_asientos;
+    int capacidad;
+    int* asiento_ids;
+    struct RetenidosSesion* siguiente;
+} RetenidosSesion;
+
+// Tabla hash de sesiones con el mapa ya cargado
+static EntradaOcupacion* g_cubos[OCUPACION_NUM_CUBOS];
+
+// Tabla hash de sesiones con asientos retenidos
+static RetenidosSesion* g_retenidos[OCUPACION_NUM_CUBOS];
+
+// El cerrojo protege la tabla, no los bits: las consultas y reservas lo toman
+// en lectura y cambian los bits con operaciones atómicas, así que muchas
+// ventas a la vez no se esperan entre ellas. Solo cargar o descartar un mapa
+// lo toma en escritura
+static pthread_rwlock_t g_ocupacion_cerrojo = PTHREAD_RWLOCK_INITIALIZER;
+
+// Protege la lista de retenidos. Se toma siempre con el cerrojo ya tomado, así
+// que retener (cerrojo en lectura) y cargar un mapa (en escritura) no se cruzan
+static pthread_mutex_t g_retenidos_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static int ocupacion_palabras(int num_asientos) {
+    int palabras = (num_asientos + OCUPACION_BITS_PALABRA - 1) / OCUPACION_BITS_PALABRA;
+    return palabras > 0 ? palabras : 1;
+}
+
+static int ocupacion_bytes(int num_asientos) {
+    return (num_asientos + 7) / 8;
+}
+
+// Tamaño a reservar para un mapa; nunca cero para que MEM_ALLOC no devuelva NULL
+static int ocupacion_bytes_reserva(int num_asientos) {
+    int bytes = ocupacion_bytes(num_asientos);
+    return bytes > 0 ? bytes : 1;
+}
+
+static uint64_t ocupacion_bit(int posicion) {
+    return (uint64_t)1 << (posicion % OCUPACION_BITS_PALABRA);
+}
+
+static EntradaOcupacion** ocupacion_cubo(int sesion_id) {
+    return &g_cubos[(unsigned int)sesion_id & (OCUPACION_NUM_CUBOS - 1)];
+}
+
+static EntradaOcupacion* ocupacion_buscar(int sesion_id) {
+    EntradaOcupacion* entrada = *ocupacion_cubo(sesion_id);
+    
+    while (entrada && entrada->sesion_id != sesion_id) {
+        entrada = entrada->siguiente;
+    }
+    
+    return entrada;
+}
+
+static RetenidosSesion** ocupacion_cubo_retenidos(int sesion_id) {
+    return &g_retenidos[(unsigned int)sesion_id & (OCUPACION_NUM_CUBOS - 1)];
+}
+
+// Asientos retenidos de una sesión, o NULL (con g_retenidos_mutex tomado)
+static RetenidosSesion* ocupacion_buscar_retenidos(int sesion_id) {
+    RetenidosSesion* retenidos = *ocupacion_cubo_retenidos(sesion_id);
+    
+    while (retenidos && retenidos->sesion_id != sesion_id) {
+        retenidos = retenidos->siguiente;
+    }
+    
+    return retenidos;
+}
+
+// Comprobar si un asiento está retenido (con g_retenidos_mutex tomado)
+static bool ocupacion_esta_retenido(int sesion_id, int asiento_id) {
+    RetenidosSesion* retenidos = ocupacion_buscar_retenidos(sesion_id);
+    if (!retenidos) {
+        return false;
+    }
+    
+    for (int i = 0; i < retenidos->num_asientos; i++) {
+        if (retenidos->asiento_ids[i] == asiento_id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Anotar asientos retenidos (con g_retenidos_mutex tomado)
+static bool ocupacion_anotar_retenidos(int sesion_id, const int* asiento_ids, int num_asientos) {
+    RetenidosSesion* retenidos = ocupacion_buscar_retenidos(sesion_id);
+    
+    if (!retenidos) {
+        retenidos = (RetenidosSesion*)MEM_ALLOC(sizeof(RetenidosSesion));
+        if (!retenidos) {
+            return false;
+        }
+        memset(retenidos, 0, sizeof(RetenidosSesion));
+        retenidos->sesion_id = sesion_id;
+        
+        RetenidosSesion** cubo = ocupacion_cubo_retenidos(sesion_id);
+        retenidos->siguiente = *cubo;
+        *cubo = retenidos;
+    }
+    
+    if (retenidos->num_asientos + num_asientos > retenidos->capacidad) {
+        int capacidad = retenidos->capacidad > 0 ? retenidos->capacidad : 16;
+        while (capacidad < retenidos->num_asientos + num_asientos) {
+            capacidad *= 2;
+        }
+        
+        int* asiento_ids_nuevos = (int*)MEM_ALLOC(capacidad * sizeof(int));
+        if (!asiento_ids_nuevos) {
+            return false;
+        }
+        if (retenidos->asiento_ids) {
+            memcpy(asiento_ids_nuevos, retenidos->asiento_ids, retenidos->num_asientos * sizeof(int));
+            MEM_FREE(retenidos->asiento_ids);
+        }
+        retenidos->asiento_ids = asiento_ids_nuevos;
+        retenidos->capacidad = capacidad;
+    }
+    
+    memcpy(retenidos->asiento_ids + retenidos->num_asientos, asiento_ids, num_asientos * sizeof(int));
+    retenidos->num_asientos += num_asientos;
+    return true;
+}
+
+// Quitar asientos de la lista de retenidos (con g_retenidos_mutex tomado).
+// Deja en quitados los que de verdad estaban y devuelve cuántos son
+static int ocupacion_quitar_retenidos(int sesion_id, const int* asiento_ids, int num_asientos, int* quitados) {
+    RetenidosSesion** actual = ocupacion_cubo_retenidos(sesion_id);
+    while (*actual && (*actual)->sesion_id != sesion_id) {
+        actual = &(*actual)->siguiente;
+    }
+    
+    RetenidosSesion* retenidos = *actual;
+    if (!retenidos) {
+        return 0;
+    }
+    
+    int num_quitados = 0;
+    for (int i = 0; i < num_asientos; i++) {
+        for (int j = 0; j < retenidos->num_asientos; j++) {
+            if (retenidos->asiento_ids[j] == asiento_ids[i]) {
+                retenidos->asiento_ids[j] = retenidos->asiento_ids[--retenidos->num_asientos];
+                quitados[num_quitados++] = asiento_ids[i];
+                break;
+            }
+        }
+    }
+    
+    if (retenidos->num_asientos == 0) {
+        *actual = retenidos->siguiente;
+        if (retenidos->asiento_ids) {
+            MEM_FREE(retenidos->asiento_ids);
+        }
+        MEM_FREE(retenidos);
+    }
+    
+    return num_quitados;
+}
+
+static void ocupacion_liberar_entrada(EntradaOcupacion* entrada) {
+    if (entrada->asiento_ids) {
+        MEM_FREE(entrada->asiento_ids);
+    }
+    if (entrada->por_id) {
+        MEM_FREE(entrada->por_id);
+    }
+    if (entrada->palabras) {
+        MEM_FREE(entrada->palabras);
+    }
+    MEM_FREE(entrada);
+}
+
+static int ocupacion_comparar_posiciones(const void* a, const void* b) {
+    int id_a = ((const PosicionAsiento*)a)->asiento_id;
+    int id_b = ((const PosicionAsiento*)b)->asiento_id;
+    return (id_a > id_b) - (id_a < id_b);
+}
+
+// Posición de un asiento en el mapa, o -1 si no pertenece a la sala
+static int ocupacion_posicion(EntradaOcupacion* entrada, int asiento_id) {
+    int inicio = 0;
+    int fin = entrada->num_asientos;
+    
+    while (inicio < fin) {
+        int medio = inicio + (fin - inicio) / 2;
+        if (entrada->por_id[medio].asiento_id < asiento_id) {
+            inicio = medio + 1;
+        } else {
+            fin = medio;
+        }
+    }
+    
+    if (inicio < entrada->num_asientos && entrada->por_id[inicio].asiento_id == asiento_id) {
+        return entrada->por_id[inicio].posicion;
+    }
+    return -1;
+}
+
+static bool ocupacion_leer_bit(EntradaOcupacion* entrada, int posicion) {
+    uint64_t palabra = __atomic_load_n(&entrada->palabras[posicion / OCUPACION_BITS_PALABRA],
+                                       __ATOMIC_ACQUIRE);
+    return (palabra & ocupacion_bit(posicion)) != 0;
+}
+
+static void ocupacion_poner_bit(EntradaOcupacion* entrada, int posicion, bool ocupado) {
+    uint64_t* palabra = &entrada->palabras[posicion / OCUPACION_BITS_PALABRA];
+    
+    if (ocupado) {
+        __atomic_fetch_or(palabra, ocupacion_bit(posicion), __ATOMIC_ACQ_REL);
+    } else {
+        __atomic_fetch_and(palabra, ~ocupacion_bit(posicion), __ATOMIC_ACQ_REL);
+    }
+}
+
+// Construir el mapa de una sesión a partir de la base de datos
+static EntradaOcupacion* ocupacion_cargar(int sesion_id) {
+    Sesion sesion;
+    if (!sesion_obtener_por_id(sesion_id, &sesion) || sesion.id != sesion_id) {
+        log_error("No se pudo obtener la sesión %d para su mapa de ocupación", sesion_id);
+        return NULL;
+    }
+    
+    Asiento* asientos = NULL;
+    int num_asientos = 0;
+    if (!asiento_listar_por_sala(sesion.sala_id, &asientos, &num_asientos)) {
+        log_error("No se pudieron obtener los asientos de la sala %d", sesion.sala_id);
+        return NULL;
+    }
+    
+    Billete* billetes = NULL;
+    int num_billetes = 0;
+    if (!billete_listar_por_sesion(sesion_id, &billetes, &num_billetes)) {
+        log_error("No se pudieron obtener los billetes de la sesión %d", sesion_id);
+        asiento_liberar_lista(asientos, num_asientos);
+        return NULL;
+    }
+    
+    EntradaOcupacion* entrada = (EntradaOcupacion*)MEM_ALLOC(sizeof(EntradaOcupacion));
+    if (!entrada) {
+        log_error("Error al asignar memoria para el mapa de ocupación");
+        asiento_liberar_lista(asientos, num_asientos);
+        billete_liberar_lista(billetes, num_billetes);
+        return NULL;
+    }
+    
+    memset(entrada, 0, sizeof(EntradaOcupacion));
+    entrada->sesion_id = sesion_id;
+    entrada->sala_id = sesion.sala_id;
+    entrada->num_asientos = num_asientos;
+    
+    int reserva = num_asientos > 0 ? num_asientos : 1;
+    entrada->asiento_ids = (int*)MEM_ALLOC(reserva * sizeof(int));
+    entrada->por_id = (PosicionAsiento*)MEM_ALLOC(reserva * sizeof(PosicionAsiento));
+    entrada->palabras = (uint64_t*)MEM_ALLOC(ocupacion_palabras(num_asientos) * sizeof(uint64_t));
+    
+    if (!entrada->asiento_ids || !entrada->por_id || !entrada->palabras) {
+        log_error("Error al asignar memoria para el mapa de ocupación");
+        ocupacion_liberar_entrada(entrada);
+        asiento_liberar_lista(asientos, num_asientos);
+        billete_liberar_lista(billetes, num_billetes);
+        return NULL;
+    }
+    
+    memset(entrada->palabras, 0, ocupacion_palabras(num_asientos) * sizeof(uint64_t));
+    
+    // Los asientos vienen ordenados por Numero
+    for (int i = 0; i < num_asientos; i++) {
+        entrada->asiento_ids[i] = asientos[i].id;
+        entrada->por_id[i].asiento_id = asientos[i].id;
+        entrada->por_id[i].posicion = i;
+    }
+    qsort(entrada->por_id, num_asientos, sizeof(PosicionAsiento), ocupacion_comparar_posiciones);
+    
+    for (int i = 0; i < num_billetes; i++) {
+        int posicion = ocupacion_posicion(entrada, billetes[i].asiento_id);
+        if (posicion >= 0) {
+            entrada->palabras[posicion / OCUPACION_BITS_PALABRA] |= ocupacion_bit(posicion);
+        }
+    }
+    
+    asiento_liberar_lista(asientos, num_asientos);
+    billete_liberar_lista(billetes, num_billetes);
+    
+    // Volver a marcar los asientos retenidos, que no tienen billete
+    pthread_mutex_lock(&g_retenidos_mutex);
+    RetenidosSesion* retenidos = ocupacion_buscar_retenidos(sesion_id);
+    if (retenidos) {
+        for (int i = 0; i < retenidos->num_asientos; i++) {
+            int posicion = ocupacion_posicion(entrada, retenidos->asiento_ids[i]);
+            if (posicion >= 0) {
+                entrada->palabras[posicion / OCUPACION_BITS_PALABRA] |= ocupacion_bit(posicion);
+            }
+        }
+    }
+    pthread_mutex_unlock(&g_retenidos_mutex);
+    
+    // Añadir a la tabla
+    EntradaOcupacion** cubo = ocupacion_cubo(sesion_id);
+    entrada->siguiente = *cubo;
+    *cubo = entrada;
+    
+    log_info("Mapa de ocupación cargado para la sesión %d (%d asientos, %d ocupados)",
+             sesion_id, num_asientos, num_billetes);
+    return entrada;
+}
+
+// Obtener el mapa de una sesión con el cerrojo tomado en lectura, cargándolo
+// si aún no está. Si devuelve NULL el cerrojo queda libre
+static EntradaOcupacion* ocupacion_leer_entrada(int sesion_id) {
+    for (;;) {
+        pthread_rwlock_rdlock(&g_ocupacion_cerrojo);
+        EntradaOcupacion* entrada = ocupacion_buscar(sesion_id);
+        if (entrada) {
+            return entrada;
+        }
+        pthread_rwlock_unlock(&g_ocupacion_cerrojo);
+        
+        // La carga se hace con el cerrojo en escritura para que una venta que
+        // confirme mientras tanto espere y marque el mapa ya cargado
+        pthread_rwlock_wrlock(&g_ocupacion_cerrojo);
+        entrada = ocupacion_buscar(sesion_id);
+        if (!entrada) {
+            entrada = ocupacion_cargar(sesion_id);
+        }
+        pthread_rwlock_unlock(&g_ocupacion_cerrojo);
+        
+        if (!entrada) {
+            return NULL;
+        }
+        // Volver a buscarlo en lectura: pudo descartarse al soltar el cerrojo
+    }
+}
+
+// Obtener una copia del mapa de ocupación de una sesión
+bool ocupacion_obtener_mapa(int sesion_id, MapaOcupacion* mapa) {
+    if (!mapa) {
+        return false;
+    }
+    
+    memset(mapa, 0, sizeof(MapaOcupacion));
+    
+    EntradaOcupacion* entrada = ocupacion_leer_entrada(sesion_id);
+    if (!entrada) {
+        return false;
+    }
+    
+    int bytes = ocupacion_bytes_reserva(entrada->num_asientos);
+    mapa->mapa = (unsigned char*)MEM_ALLOC(bytes);
+    if (!mapa->mapa) {
+        pthread_rwlock_unlock(&g_ocupacion_cerrojo);
+        log_error("Error al asignar memoria para copiar el mapa de ocupación");
+        return false;
+    }
+    
+    memset(mapa->mapa, 0, bytes);
+    for (int i = 0; i < ocupacion_bytes(entrada->num_asientos); i++) {
+        uint64_t palabra = __atomic_load_n(&entrada->palabras[i / 8], __ATOMIC_ACQUIRE);
+        mapa->mapa[i] = (unsigned char)(palabra >> ((i % 8) * 8));
+    }
+    mapa->sesion_id = entrada->sesion_id;
+    mapa->sala_id = entrada->sala_id;
+    mapa->num_asientos = entrada->num_asientos;
+    
+    pthread_rwlock_unlock(&g_ocupacion_cerrojo);
+    return true;
+}
+
+// Consultar si un asiento está ocupado en una sesión
+bool ocupacion_asiento_ocupado(int sesion_id, int asiento_id, bool* ocupado) {
+    EntradaOcupacion* entrada = ocupacion_leer_entrada(sesion_id);
+    if (!entrada) {
+        return false;
+    }
+    
+    int posicion = ocupacion_posicion(entrada, asiento_id);
+    if (posicion >= 0) {
+        *ocupado = ocupacion_leer_bit(entrada, posicion);
+    }
+    
+    pthread_rwlock_unlock(&g_ocupacion_cerrojo);
+    return posicion >= 0;
+}
+
+// Disposición de la sala: la misma que dibuja el menú de compra
+void ocupacion_disposicion(int num_asientos, int* filas, int* columnas) {
+    *filas = (int)sqrt(num_asientos) + 1;
+    *columnas = (num_asientos / *filas) + 1;
+}
+
+// Copiar en libres los asientos [inicio, inicio + ancho) del mapa con los
+// bits invertidos (1 = libre). Los bits a partir de ancho quedan a 0
+static void ocupacion_extraer_libres(EntradaOcupacion* entrada, int inicio, int ancho, uint64_t* libres) {
+    int num_palabras = ocupacion_palabras(entrada->num_asientos);
+    int palabras_fila = (ancho + OCUPACION_BITS_PALABRA - 1) / OCUPACION_BITS_PALABRA;
+    
+    for (int w = 0; w < palabras_fila; w++) {
+        int bit = inicio + w * OCUPACION_BITS_PALABRA;
+        int indice = bit / OCUPACION_BITS_PALABRA;
+        int desplazamiento = bit % OCUPACION_BITS_PALABRA;
+        
+        uint64_t valor = __atomic_load_n(&entrada->palabras[indice], __ATOMIC_ACQUIRE) >> desplazamiento;
+        if (desplazamiento > 0 && indice + 1 < num_palabras) {
+            uint64_t siguiente = __atomic_load_n(&entrada->palabras[indice + 1], __ATOMIC_ACQUIRE);
+            valor |= siguiente << (OCUPACION_BITS_PALABRA - desplazamiento);
+        }
+        libres[w] = ~valor;
+    }
+    
+    int resto = ancho % OCUPACION_BITS_PALABRA;
+    if (resto > 0) {
+        libres[palabras_fila - 1] &= ((uint64_t)1 << resto) - 1;
+    }
+}
+
+// bits &= bits >> desplazamiento sobre una fila de varias palabras
+static void ocupacion_and_desplazado(uint64_t* bits, int palabras_fila, int desplazamiento) {
+    int salto = desplazamiento / OCUPACION_BITS_PALABRA;
+    int resto = desplazamiento % OCUPACION_BITS_PALABRA;
+    
+    for (int w = 0; w < palabras_fila; w++) {
+        uint64_t desplazado = 0;
+        if (w + salto < palabras_fila) {
+            desplazado = bits[w + salto] >> resto;
+            if (resto > 0 && w + salto + 1 < palabras_fila) {
+                desplazado |= bits[w + salto + 1] << (OCUPACION_BITS_PALABRA - resto);
+            }
+        }
+        bits[w] &= desplazado;
+    }
+}
+
+// Buscar los mejores asientos contiguos de una sesión
+bool ocupacion_mejores_asientos(int sesion_id, int num_asientos, int* asiento_ids, int* fila) {
+    if (num_asientos <= 0 || !asiento_ids) {
+        return false;
+    }
+    
+    EntradaOcupacion* entrada = ocupacion_leer_entrada(sesion_id);
+    if (!entrada) {
+        return false;
+    }
+    
+    int filas, columnas;
+    ocupacion_disposicion(entrada->num_asientos, &filas, &columnas);
+    
+    if (num_asientos > columnas ||
+        (columnas + OCUPACION_BITS_PALABRA - 1) / OCUPACION_BITS_PALABRA > OCUPACION_MAX_PALABRAS_FILA) {
+        pthread_rwlock_unlock(&g_ocupacion_cerrojo);
+        return false;
+    }
+    
+    // Se prefiere el centro de la fila y, entre filas, las de dos tercios
+    // hacia el fondo. Las distancias van al doble para no usar decimales, y
+    // cambiar de fila pesa el doble que desplazarse un asiento
+    int fila_ideal_doble = (4 * (filas - 1)) / 3;
+    int mejor_puntuacion = -1;
+    int mejor_inicio = -1;
+    int mejor_fila = -1;
+    
+    uint64_t huecos[OCUPACION_MAX_PALABRAS_FILA];
+    
+    for (int f = 0; f < filas; f++) {
+        int inicio = f * columnas;
+        int ancho = entrada->num_asientos - inicio;
+        if (ancho > columnas) {
+            ancho = columnas;
+        }
+        if (ancho < num_asientos) {
+            continue;
+        }
+        
+        int distancia_fila = 2 * f - fila_ideal_doble;
+        int puntuacion_fila = 2 * (distancia_fila < 0 ? -distancia_fila : distancia_fila);
+        if (mejor_puntuacion >= 0 && puntuacion_fila >= mejor_puntuacion) {
+            continue;
+        }
+        
+        // Tras el bucle, el bit j de huecos vale 1 si los asientos j .. j +
+        // num_asientos - 1 están libres. Cada paso dobla la longitud
+        // comprobada, así que un hueco de n asientos cuesta log2(n) pasadas
+        // por palabra en lugar de n comprobaciones por asiento
+        int palabras_fila = (ancho + OCUPACION_BITS_PALABRA - 1) / OCUPACION_BITS_PALABRA;
+        ocupacion_extraer_libres(entrada, inicio, ancho, huecos);
+        
+        int comprobados = 1;
+        while (comprobados < num_asientos) {
+            int paso = comprobados < num_asientos - comprobados ? comprobados : num_asientos - comprobados;
+            ocupacion_and_desplazado(huecos, palabras_fila, paso);
+            comprobados += paso;
+        }
+        
+        for (int w = 0; w < palabras_fila; w++) {
+            uint64_t candidatos = huecos[w];
+            while (candidatos) {
+                int j = w * OCUPACION_BITS_PALABRA + __builtin_ctzll(candidatos);
+                candidatos &= candidatos - 1;
+                
+                int distancia = 2 * j + num_asientos - ancho;
+                int puntuacion = (distancia < 0 ? -distancia : distancia) + puntuacion_fila;
+                
+                if (mejor_puntuacion < 0 || puntuacion < mejor_puntuacion) {
+                    mejor_puntuacion = puntuacion;
+                    mejor_inicio = inicio + j;
+                    mejor_fila = f;
+                }
+            }
+        }
+    }
+    
+    if (mejor_inicio >= 0) {
+        for (int i = 0; i < num_asientos; i++) {
+            asiento_ids[i] = entrada->asiento_ids[mejor_inicio + i];
+        }
+        *fila = mejor_fila;
+    }
+    
+    pthread_rwlock_unlock(&g_ocupacion_cerrojo);
+    return mejor_inicio >= 0;
+}
+
+static int ocupacion_comparar_enteros(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// Deshacer las palabras ya marcadas de una reserva que no se pudo completar
+static void ocupacion_deshacer_palabras(EntradaOcupacion* entrada, const int* palabras,
+                                        const uint64_t* mascaras, int num_palabras) {
+    for (int i = 0; i < num_palabras; i++) {
+        __atomic_fetch_and(&entrada->palabras[palabras[i]], ~mascaras[i], __ATOMIC_ACQ_REL);
+    }
+}
+
+// Reservar varios asientos de una sesión de forma atómica. Con retener, se
+// anotan además como retenidos antes de soltar el cerrojo, así que ninguna
+// recarga del mapa puede verlos marcados sin anotar
+static bool ocupacion_reservar(int sesion_id, const int* asiento_ids, int num_asientos, bool retener) {
+    if (!asiento_ids || num_asientos <= 0 || num_asientos > OCUPACION_MAX_RESERVA) {
+        log_error("Reserva de %d asientos inválida para la sesión %d", num_asientos, sesion_id);
+        return false;
+    }
+    
+    EntradaOcupacion* entrada = ocupacion_leer_entrada(sesion_id);
+    if (!entrada) {
+        return false;
+    }
+    
+    // Pasar los asientos a posiciones ordenadas para agrupar los de una
+    // misma palabra y marcarlos con una sola comparación e intercambio
+    int posiciones[OCUPACION_MAX_RESERVA];
+    for (int i = 0; i < num_asientos; i++) {
+        posiciones[i] = ocupacion_posicion(entrada, asiento_ids[i]);
+        if (posiciones[i] < 0) {
+            pthread_rwlock_unlock(&g_ocupacion_cerrojo);
+            log_error("El asiento %d no pertenece a la sala de la sesión %d", asiento_ids[i], sesion_id);
+            return false;
+        }
+    }
+    qsort(posiciones, num_asientos, sizeof(int), ocupacion_comparar_enteros);
+    
+    int palabras[OCUPACION_MAX_RESERVA];
+    uint64_t mascaras[OCUPACION_MAX_RESERVA];
+    int num_palabras = 0;
+    
+    for (int i = 0; i < num_asientos; i++) {
+        if (i > 0 && posiciones[i] == posiciones[i - 1]) {
+            pthread_rwlock_unlock(&g_ocupacion_cerrojo);
+            log_error("Asiento repetido en la reserva de la sesión %d", sesion_id);
+            return false;
+        }
+        
+        int palabra = posiciones[i] / OCUPACION_BITS_PALABRA;
+        if (num_palabras == 0 || palabras[num_palabras - 1] != palabra) {
+            palabras[num_palabras] = palabra;
+            mascaras[num_palabras] = 0;
+            num_palabras++;
+        }
+        mascaras[num_palabras - 1] |= ocupacion_bit(posiciones[i]);
+    }
+    
+    for (int i = 0; i < num_palabras; i++) {
+        uint64_t* destino = &entrada->palabras[palabras[i]];
+        uint64_t actual = __atomic_load_n(destino, __ATOMIC_ACQUIRE);
+        
+        do {
+            if (actual & mascaras[i]) {
+                // Algún asiento ya está ocupado: soltar lo marcado hasta ahora
+                ocupacion_deshacer_palabras(entrada, palabras, mascaras, i);
+                pthread_rwlock_unlock(&g_ocupacion_cerrojo);
+                return false;
+            }
+        } while (!__atomic_compare_exchange_n(destino, &actual, actual | mascaras[i], false,
+                                              __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+    }
+    
+    if (retener) {
+        pthread_mutex_lock(&g_retenidos_mutex);
+        bool anotados = ocupacion_anotar_retenidos(sesion_id, asiento_ids, num_asientos);
+        pthread_mutex_unlock(&g_retenidos_mutex);
+        
+        if (!anotados) {
+            ocupacion_deshacer_palabras(entrada, palabras, mascaras, num_palabras);
+            pthread_rwlock_unlock(&g_ocupacion_cerrojo);
+            log_error("Error al asignar memoria para los asientos retenidos");
+            return false;
+        }
+    }
+    
+    pthread_rwlock_unlock(&g_ocupacion_cerrojo);
+    return true;
+}
+
+// Reservar varios asientos de una sesión
+bool ocupacion_reservar_asientos(int sesion_id, const int* asiento_ids, int num_asientos) {
+    return ocupacion_reservar(sesion_id, asiento_ids, num_asientos, false);
+}
+
+// Retener varios asientos de una sesión
+bool ocupacion_retener_asientos(int sesion_id, const int* asiento_ids, int num_asientos) {
+    return ocupacion_reservar(sesion_id, asiento_ids, num_asientos, true);
+}
+
+// Devolver al inventario asientos reservados
+void ocupacion_liberar_asientos(int sesion_id, const int* asiento_ids, int num_asientos) {
+    pthread_rwlock_rdlock(&g_ocupacion_cerrojo);
+    
+    // Si el mapa ya no está, se volverá a cargar sin esos billetes
+    EntradaOcupacion* entrada = ocupacion_buscar(sesion_id);
+    if (entrada) {
+        pthread_mutex_lock(&g_retenidos_mutex);
+        for (int i = 0; i < num_asientos; i++) {
+            // Un asiento retenido es de su retención, aunque el mapa se haya
+            // recargado después de reservarlo aquí
+            int posicion = ocupacion_posicion(entrada, asiento_ids[i]);
+            if (posicion >= 0 && !ocupacion_esta_retenido(sesion_id, asiento_ids[i])) {
+                ocupacion_poner_bit(entrada, posicion, false);
+            }
+        }
+        pthread_mutex_unlock(&g_retenidos_mutex);
+    }
+    
+    pthread_rwlock_unlock(&g_ocupacion_cerrojo);
+}
+
+// Quitar asientos de la lista de retenidos y, si se sueltan, desmarcarlos
+static void ocupacion_quitar_retencion(int sesion_id, const int* asiento_ids, int num_asientos, bool soltar) {
+    if (!asiento_ids || num_asientos <= 0 || num_asientos > OCUPACION_MAX_RESERVA) {
+        return;
+    }
+    
+    pthread_rwlock_rdlock(&g_ocupacion_cerrojo);
+    
+    int quitados[OCUPACION_MAX_RESERVA];
+    pthread_mutex_lock(&g_retenidos_mutex);
+    int num_quitados = ocupacion_quitar_retenidos(sesion_id, asiento_ids, num_asientos, quitados);
+    pthread_mutex_unlock(&g_retenidos_mutex);
+    
+    // Solo se desmarcan los que seguían retenidos: los demás ya no son de
+    // esta retención
+    EntradaOcupacion* entrada = soltar ? ocupacion_buscar(sesion_id) : NULL;
+    if (entrada) {
+        for (int i = 0; i < num_quitados; i++) {
+            int posicion = ocupacion_posicion(entrada, quitados[i]);
+            if (posicion >= 0) {
+                ocupacion_poner_bit(entrada, posicion, false);
+            }
+        }
+    }
+    
+    pthread_rwlock_unlock(&g_ocupacion_cerrojo);
+}
+
+// Devolver al inventario asientos retenidos
+void ocupacion_soltar_retenidos(int sesion_id, const int* asiento_ids, int num_asientos) {
+    ocupacion_quitar_retencion(sesion_id, asiento_ids, num_asientos, true);
+}
+
+// Pasar asientos retenidos a vendidos
+void ocupacion_confirmar_retenidos(int sesion_id, const int* asiento_ids, int num_asientos) {
+    ocupacion_quitar_retencion(sesion_id, asiento_ids, num_asientos, false);
+}
+
+// Quitar de la tabla el mapa de una sesión (con el cerrojo en escritura)
+static void ocupacion_descartar(int sesion_id) {
+    EntradaOcupacion** actual = ocupacion_cubo(sesion_id);
+    
+    while (*actual) {
+        if ((*actual)->sesion_id == sesion_id) {
+            EntradaOcupacion* eliminada = *actual;
+            *actual = eliminada->siguiente;
+            ocupacion_liberar_entrada(eliminada);
+            return;
+        }
+        actual = &(*actual)->siguiente;
+    }
+}
+
+// Actualizar el mapa de una sesión al crear o eliminar un billete
+void ocupacion_marcar_asiento(int sesion_id, int asiento_id, bool ocupado) {
+    pthread_rwlock_rdlock(&g_ocupacion_cerrojo);
+    
+    EntradaOcupacion* entrada = ocupacion_buscar(sesion_id);
+    if (!entrada) {
+        // Aún no se ha cargado; se leerá actualizado de la base de datos
+        pthread_rwlock_unlock(&g_ocupacion_cerrojo);
+        return;
+    }
+    
+    int posicion = ocupacion_posicion(entrada, asiento_id);
+    if (posicion >= 0) {
+        pthread_mutex_lock(&g_retenidos_mutex);
+        if (ocupado || !ocupacion_esta_retenido(sesion_id, asiento_id)) {
+            ocupacion_poner_bit(entrada, posicion, ocupado);
+        }
+        pthread_mutex_unlock(&g_retenidos_mutex);
+        pthread_rwlock_unlock(&g_ocupacion_cerrojo);
+        return;
+    }
+    
+    pthread_rwlock_unlock(&g_ocupacion_cerrojo);
+    
+    // La sala ha cambiado desde que se cargó el mapa
+    ocupacion_invalidar_sesion(sesion_id);
+}
+
+// Descartar el mapa de una sesión
+void ocupacion_invalidar_sesion(int sesion_id) {
+    pthread_rwlock_wrlock(&g_ocupacion_cerrojo);
+    ocupacion_descartar(sesion_id);
+    pthread_rwlock_unlock(&g_ocupacion_cerrojo);
+}
+
+// Descartar todos los mapas
+void ocupacion_limpiar() {
+    pthread_rwlock_wrlock(&g_ocupacion_cerrojo);
+    
+    for (int i = 0; i < OCUPACION_NUM_CUBOS; i++) {
+        while (g_cubos[i]) {
+            EntradaOcupacion* eliminada = g_cubos[i];
+            g_cubos[i] = eliminada->siguiente;
+            ocupacion_liberar_entrada(eliminada);
+        }
+    }
+    
+    pthread_mutex_lock(&g_retenidos_mutex);
+    for (int i = 0; i < OCUPACION_NUM_CUBOS; i++) {
+        while (g_retenidos[i]) {
+            RetenidosSesion* eliminados = g_retenidos[i];
+            g_retenidos[i] = eliminados->siguiente;
+            if (eliminados->asiento_ids) {
+                MEM_FREE(eliminados->asiento_ids);
+            }
+            MEM_FREE(eliminados);
+        }
+    }
+    pthread_mutex_unlock(&g_retenidos_mutex);
+    
+    pthread_rwlock_unlock(&g_ocupacion_cerrojo);
+}
+
+// Liberar la copia de un mapa de ocupación
+void ocupacion_liberar_mapa(MapaOcupacion* mapa) {
+    if (mapa && mapa->mapa) {
+        MEM_FREE(mapa->mapa);
+        mapa->mapa = NULL;
+    }
+}
\ No newline at end of file
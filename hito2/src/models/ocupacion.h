@@ -0,0 +1,73 @@
+#ifndef OCUPACION_H
+#define OCUPACION_H
+
+#include <stdbool.h>
+
+// Inventario en memoria de los asientos de cada sesión. Es la referencia para
+// saber si un asiento está libre: las ventas reservan aquí sus asientos de
+// forma atómica antes de escribir los billetes, y la base de datos guarda
+// después lo que se ha confirmado. La primera consulta de cada sesión lo
+// carga de los billetes existentes; las siguientes se sirven de memoria.
+
+// Mapa de ocupación de los asientos de una sesión.
+// El bit i del mapa (bit i % 8 del byte i / 8) corresponde al asiento en la
+// posición i de la sala ordenada por Numero, y vale 1 si ya hay un billete
+// para ese asiento en la sesión.
+typedef struct {
+    int sesion_id;
+    int sala_id;
+    int num_asientos;
+    unsigned char* mapa;    // (num_asientos + 7) / 8 bytes
+} MapaOcupacion;
+
+// Obtener una copia del mapa de una sesión
+bool ocupacion_obtener_mapa(int sesion_id, MapaOcupacion* mapa);
+
+// Consultar si un asiento está ocupado en una sesión. Devuelve false si la
+// sesión no existe o el asiento no es de su sala
+bool ocupacion_asiento_ocupado(int sesion_id, int asiento_id, bool* ocupado);
+
+// Filas y columnas en que se disponen los asientos de una sala, en orden de
+// Numero: el asiento en la posición i va en la fila i / columnas
+void ocupacion_disposicion(int num_asientos, int* filas, int* columnas);
+
+// Buscar num_asientos asientos libres y contiguos de una misma fila, los más
+// centrados de la sala. Deja sus IDs en asiento_ids y la fila (desde 0) en
+// fila. Devuelve false si la sesión no existe o no hay ningún hueco así
+bool ocupacion_mejores_asientos(int sesion_id, int num_asientos, int* asiento_ids, int* fila);
+
+// Reservar varios asientos de una sesión: se marcan todos o ninguno. Falla
+// si alguno ya está ocupado, no es de la sala o aparece repetido. Dos ventas
+// que compiten por el mismo asiento nunca lo consiguen las dos
+bool ocupacion_reservar_asientos(int sesion_id, const int* asiento_ids, int num_asientos);
+
+// Devolver asientos reservados cuyo billete no se llegó a guardar. Los que
+// están retenidos no se tocan: son de su retención
+void ocupacion_liberar_asientos(int sesion_id, const int* asiento_ids, int num_asientos);
+
+// Reservar asientos para una retención. Además de marcarlos, se anotan como
+// retenidos: como no tienen billete, se vuelven a marcar si el mapa de la
+// sesión se descarta y se carga otra vez
+bool ocupacion_retener_asientos(int sesion_id, const int* asiento_ids, int num_asientos);
+
+// Devolver al inventario asientos retenidos. Solo se desmarcan los que
+// seguían anotados como retenidos
+void ocupacion_soltar_retenidos(int sesion_id, const int* asiento_ids, int num_asientos);
+
+// Dejar de anotar asientos retenidos cuyo billete ya se ha confirmado; siguen
+// ocupados
+void ocupacion_confirmar_retenidos(int sesion_id, const int* asiento_ids, int num_asientos);
+
+// Mantener el mapa al crear o eliminar un billete fuera de una reserva
+void ocupacion_marcar_asiento(int sesion_id, int asiento_id, bool ocupado);
+
+// Descartar el mapa de una sesión para que se vuelva a cargar
+void ocupacion_invalidar_sesion(int sesion_id);
+
+// Descartar todos los mapas
+void ocupacion_limpiar();
+
+// Liberar la copia devuelta por ocupacion_obtener_mapa
+void ocupacion_liberar_mapa(MapaOcupacion* mapa);
+
+#endif // OCUPACION_H
\ No newline at end of file
@@ -1,60 +1,23 @@
 #include "pelicula.h"
+#include "titulos.h"
+#include "generos.h"
 #include "../database.h"
 #include "../utils/logger.h"
 #include "../utils/memory.h"
+#include "../utils/result_set.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
-// Función auxiliar para callback de SQLite
-static int pelicula_callback(void* data, int argc, char** argv, char** column_names) {
-    Pelicula* pelicula = (Pelicula*)data;
-    
-    for (int i = 0; i < argc; i++) {
-        if (strcmp(column_names[i], "ID") == 0) {
-            pelicula->id = atoi(argv[i]);
-        } else if (strcmp(column_names[i], "Titulo") == 0) {
-            strncpy(pelicula->titulo, argv[i] ? argv[i] : "", sizeof(pelicula->titulo) - 1);
-        } else if (strcmp(column_names[i], "Duracion") == 0) {
-            pelicula->duracion = atoi(argv[i]);
-        } else if (strcmp(column_names[i], "Genero") == 0) {
-            strncpy(pelicula->genero, argv[i] ? argv[i] : "", sizeof(pelicula->genero) - 1);
-        }
-    }
-    
-    return 0;
-}
+// Columnas de la tabla Pelicula
+static const DbColumn pelicula_columnas[] = {
+    DB_INT_COLUMN("ID", Pelicula, id),
+    DB_TEXT_COLUMN("Titulo", Pelicula, titulo),
+    DB_INT_COLUMN("Duracion", Pelicula, duracion),
+    DB_TEXT_COLUMN("Genero", Pelicula, genero)
+};
 
-// Función callback para listar películas
-static int peliculas_listar_callback(void* data, int argc, char** argv, char** column_names) {
-    struct {
-        Pelicula* peliculas;
-        int max_peliculas;
-        int* num_peliculas;
-    }* callback_data = (void*)data;
-    
-    if (*callback_data->num_peliculas >= callback_data->max_peliculas) {
-        // No hay más espacio para películas
-        return 1;
-    }
-    
-    Pelicula* pelicula = &callback_data->peliculas[*callback_data->num_peliculas];
-    
-    for (int i = 0; i < argc; i++) {
-        if (strcmp(column_names[i], "ID") == 0) {
-            pelicula->id = atoi(argv[i]);
-        } else if (strcmp(column_names[i], "Titulo") == 0) {
-            strncpy(pelicula->titulo, argv[i] ? argv[i] : "", sizeof(pelicula->titulo) - 1);
-        } else if (strcmp(column_names[i], "Duracion") == 0) {
-            pelicula->duracion = atoi(argv[i]);
-        } else if (strcmp(column_names[i], "Genero") == 0) {
-            strncpy(pelicula->genero, argv[i] ? argv[i] : "", sizeof(pelicula->genero) - 1);
-        }
-    }
-    
-    (*callback_data->num_peliculas)++;
-    return 0;
-}
+static const DbRowMap pelicula_fila = DB_ROW_MAP(pelicula_columnas);
 
 // Crear una nueva película
 bool pelicula_crear(Pelicula* pelicula) {
@@ -63,14 +26,17 @@ bool pelicula_crear(Pelicula* pelicula) {
         return false;
     }
     
-    char sql[512];
-    snprintf(sql, sizeof(sql),
+    sqlite3_stmt* stmt = db_statement(STMT_PELICULA_CREAR,
             "INSERT INTO Pelicula (Titulo, Duracion, Genero) "
-            "VALUES ('%s', %d, '%s');",
-            pelicula->titulo, pelicula->duracion, pelicula->genero);
+            "VALUES (?, ?, ?);");
+    db_bind_text(stmt, 1, pelicula->titulo);
+    db_bind_int(stmt, 2, pelicula->duracion);
+    db_bind_text(stmt, 3, pelicula->genero);
     
-    if (db_execute(sql)) {
+    if (db_statement_execute(stmt)) {
         pelicula->id = db_last_insert_id();
+        titulos_guardar_pelicula(pelicula);
+        generos_guardar_pelicula(pelicula);
         log_info("Película creada con ID: %d", pelicula->id);
         return true;
     }
@@ -81,11 +47,12 @@ bool pelicula_crear(Pelicula* pelicula) {
 
 // Obtener película por ID
 bool pelicula_obtener_por_id(int id, Pelicula* pelicula) {
-    char sql[256];
-    snprintf(sql, sizeof(sql), "SELECT * FROM Pelicula WHERE ID = %d;", id);
+    sqlite3_stmt* stmt = db_statement(STMT_PELICULA_OBTENER_POR_ID,
+            "SELECT * FROM Pelicula WHERE ID = ?;");
+    db_bind_int(stmt, 1, id);
     
     memset(pelicula, 0, sizeof(Pelicula));
-    return db_query(sql, pelicula_callback, pelicula);
+    return db_statement_read(stmt, &pelicula_fila, pelicula);
 }
 
 // Actualizar una película existente
@@ -95,13 +62,19 @@ bool pelicula_actualizar(Pelicula* pelicula) {
         return false;
     }
     
-    char sql[512];
-    snprintf(sql, sizeof(sql),
-            "UPDATE Pelicula SET Titulo = '%s', Duracion = %d, Genero = '%s' "
-            "WHERE ID = %d;",
-            pelicula->titulo, pelicula->duracion, pelicula->genero, pelicula->id);
+    sqlite3_stmt* stmt = db_statement(STMT_PELICULA_ACTUALIZAR,
+            "UPDATE Pelicula SET Titulo = ?, Duracion = ?, Genero = ? "
+            "WHERE ID = ?;");
+    db_bind_text(stmt, 1, pelicula->titulo);
+    db_bind_int(stmt, 2, pelicula->duracion);
+    db_bind_text(stmt, 3, pelicula->genero);
+    db_bind_int(stmt, 4, pelicula->id);
     
-    if (db_execute(sql)) {
+    if (db_statement_execute(stmt)) {
+        if (db_changes() > 0) {
+            titulos_guardar_pelicula(pelicula);
+            generos_guardar_pelicula(pelicula);
+        }
         log_info("Película actualizada con ID: %d", pelicula->id);
         return true;
     }
@@ -112,10 +85,12 @@ bool pelicula_actualizar(Pelicula* pelicula) {
 
 // Eliminar una película
 bool pelicula_eliminar(int id) {
-    char sql[256];
-    snprintf(sql, sizeof(sql), "DELETE FROM Pelicula WHERE ID = %d;", id);
+    sqlite3_stmt* stmt = db_statement(STMT_PELICULA_ELIMINAR, "DELETE FROM Pelicula WHERE ID = ?;");
+    db_bind_int(stmt, 1, id);
     
-    if (db_execute(sql)) {
+    if (db_statement_execute(stmt)) {
+        titulos_quitar_pelicula(id);
+        generos_quitar_pelicula(id);
         log_info("Película eliminada con ID: %d", id);
         return true;
     }
@@ -126,116 +101,30 @@ bool pelicula_eliminar(int id) {
 
 // Listar todas las películas
 bool pelicula_listar(Pelicula** peliculas, int* num_peliculas) {
-    // Primero, contar cuántas películas hay
-    char sql_count[256] = "SELECT COUNT(*) FROM Pelicula;";
-    int count = 0;
-    
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(get_database()->db, sql_count, -1, &stmt, NULL);
-    
-    if (rc != SQLITE_OK) {
-        log_error("Error al preparar la consulta: %s", sqlite3_errmsg(get_database()->db));
-        return false;
-    }
-    
-    rc = sqlite3_step(stmt);
-    
-    if (rc == SQLITE_ROW) {
-        count = sqlite3_column_int(stmt, 0);
-    }
-    
-    sqlite3_finalize(stmt);
-    
-    if (count == 0) {
-        *peliculas = NULL;
-        *num_peliculas = 0;
-        return true;
-    }
-    
-    // Asignar memoria para las películas
-    *peliculas = (Pelicula*)MEM_ALLOC(count * sizeof(Pelicula));
-    if (!*peliculas) {
-        log_error("Error al asignar memoria para la lista de películas");
-        return false;
-    }
-    
     // Consultar las películas
-    char sql[256] = "SELECT * FROM Pelicula;";
+    sqlite3_stmt* stmt = db_statement(STMT_PELICULA_LISTAR, "SELECT * FROM Pelicula;");
     
-    struct {
-        Pelicula* peliculas;
-        int max_peliculas;
-        int* num_peliculas;
-    } callback_data = {*peliculas, count, num_peliculas};
+    ResultSet resultado;
+    result_set_init(&resultado, sizeof(Pelicula));
     
-    *num_peliculas = 0;  // Inicializar el contador
-    
-    if (!db_query(sql, peliculas_listar_callback, &callback_data)) {
-        MEM_FREE(*peliculas);
+    if (!db_statement_read_all(stmt, &pelicula_fila, &resultado)) {
+        result_set_free(&resultado);
         *peliculas = NULL;
         *num_peliculas = 0;
         log_error("Error al consultar la lista de películas");
         return false;
     }
     
+    *peliculas = (Pelicula*)result_set_take(&resultado, num_peliculas);
+    
     log_info("Se listaron %d películas", *num_peliculas);
     return true;
 }
 
-// Buscar películas por título
+// Buscar películas por título. La búsqueda va al índice de trigramas, que no
+// distingue mayúsculas ni tildes y ordena por relevancia
 bool pelicula_buscar_por_titulo(const char* titulo, Pelicula** peliculas, int* num_peliculas) {
-    char sql_count[512];
-    snprintf(sql_count, sizeof(sql_count), 
-            "SELECT COUNT(*) FROM Pelicula WHERE Titulo LIKE '%%%s%%';", titulo);
-    
-    int count = 0;
-    
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(get_database()->db, sql_count, -1, &stmt, NULL);
-    
-    if (rc != SQLITE_OK) {
-        log_error("Error al preparar la consulta: %s", sqlite3_errmsg(get_database()->db));
-        return false;
-    }
-    
-    rc = sqlite3_step(stmt);
-    
-    if (rc == SQLITE_ROW) {
-        count = sqlite3_column_int(stmt, 0);
-    }
-    
-    sqlite3_finalize(stmt);
-    
-    if (count == 0) {
-        *peliculas = NULL;
-        *num_peliculas = 0;
-        return true;
-    }
-    
-    // Asignar memoria para las películas
-    *peliculas = (Pelicula*)MEM_ALLOC(count * sizeof(Pelicula));
-    if (!*peliculas) {
-        log_error("Error al asignar memoria para la búsqueda de películas");
-        return false;
-    }
-    
-    // Consultar las películas
-    char sql[512];
-    snprintf(sql, sizeof(sql), 
-            "SELECT * FROM Pelicula WHERE Titulo LIKE '%%%s%%';", titulo);
-    
-    struct {
-        Pelicula* peliculas;
-        int max_peliculas;
-        int* num_peliculas;
-    } callback_data = {*peliculas, count, num_peliculas};
-    
-    *num_peliculas = 0;  // Inicializar el contador
-    
-    if (!db_query(sql, peliculas_listar_callback, &callback_data)) {
-        MEM_FREE(*peliculas);
-        *peliculas = NULL;
-        *num_peliculas = 0;
+    if (!titulos_buscar(titulo, peliculas, num_peliculas)) {
         log_error("Error al consultar la búsqueda de películas por título");
         return false;
     }
@@ -244,65 +133,16 @@ bool pelicula_buscar_por_titulo(const char* titulo, Pelicula** peliculas, int* n
     return true;
 }
 
-// Buscar películas por género
+// Buscar películas por género. El término puede ser una lista separada por
+// comas ("Acción, Comedia"); se devuelven las películas que tienen todos
 bool pelicula_buscar_por_genero(const char* genero, Pelicula** peliculas, int* num_peliculas) {
-    char sql_count[512];
-    snprintf(sql_count, sizeof(sql_count), 
-            "SELECT COUNT(*) FROM Pelicula WHERE Genero LIKE '%%%s%%';", genero);
-    
-    int count = 0;
-    
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(get_database()->db, sql_count, -1, &stmt, NULL);
-    
-    if (rc != SQLITE_OK) {
-        log_error("Error al preparar la consulta: %s", sqlite3_errmsg(get_database()->db));
-        return false;
-    }
-    
-    rc = sqlite3_step(stmt);
-    
-    if (rc == SQLITE_ROW) {
-        count = sqlite3_column_int(stmt, 0);
-    }
-    
-    sqlite3_finalize(stmt);
-    
-    if (count == 0) {
-        *peliculas = NULL;
-        *num_peliculas = 0;
-        return true;
-    }
-    
-    // Asignar memoria para las películas
-    *peliculas = (Pelicula*)MEM_ALLOC(count * sizeof(Pelicula));
-    if (!*peliculas) {
-        log_error("Error al asignar memoria para la búsqueda de películas");
-        return false;
-    }
-    
-    // Consultar las películas
-    char sql[512];
-    snprintf(sql, sizeof(sql), 
-            "SELECT * FROM Pelicula WHERE Genero LIKE '%%%s%%';", genero);
-    
-    struct {
-        Pelicula* peliculas;
-        int max_peliculas;
-        int* num_peliculas;
-    } callback_data = {*peliculas, count, num_peliculas};
-    
-    *num_peliculas = 0;  // Inicializar el contador
-    
-    if (!db_query(sql, peliculas_listar_callback, &callback_data)) {
-        MEM_FREE(*peliculas);
-        *peliculas = NULL;
-        *num_peliculas = 0;
+    int total;
+    if (!generos_buscar(&genero, 1, GENEROS_TODOS, 0, 0, peliculas, num_peliculas, &total)) {
         log_error("Error al consultar la búsqueda de películas por género");
         return false;
     }
     
-    log_info("Se encontraron %d películas con género similar a '%s'", *num_peliculas, genero);
+    log_info("Se encontraron %d películas del género '%s'", *num_peliculas, genero);
     return true;
 }
 
@@ -0,0 +1,406 @@
+#include "retencion.h"
+#include "ocupacion.h"
+#include "../utils/logger.h"
+#include "../utils/memory.h"
+#include "../utils/timer_wheel.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+// Número de listas de la tabla hash de retenciones (potencia de 2)
+#define RETENCION_NUM_CUBOS 1024
+
+// Retenciones que se reservan de golpe; así miles de retenciones ocupan
+// pocos bloques de memoria
+#define RETENCION_POR_BLOQUE 256
+
+// Retención guardada en memoria
+typedef struct EntradaRetencion {
+    TimerWheelEntry temporizador;       // Primer campo: la rueda devuelve este puntero
+    Retencion datos;
+    struct EntradaRetencion* siguiente; // En su lista de la tabla o en la lista libre
+} EntradaRetencion;
+
+typedef struct BloqueRetenciones {
+    struct BloqueRetenciones* siguiente;
+    EntradaRetencion entradas[RETENCION_POR_BLOQUE];
+} BloqueRetenciones;
+
+// Asientos retenidos por cada usuario, para aplicar
+// RETENCION_MAX_ASIENTOS_USUARIO. Solo hay entrada mientras tiene alguno
+typedef struct RetencionesUsuario {
+    int usuario_id;
+    int num_asientos;
+    struct RetencionesUsuario* siguiente;
+} RetencionesUsuario;
+
+static EntradaRetencion* g_cubos[RETENCION_NUM_CUBOS];
+static RetencionesUsuario* g_usuarios[RETENCION_NUM_CUBOS];
+static EntradaRetencion* g_libres = NULL;
+static BloqueRetenciones* g_bloques = NULL;
+static int g_siguiente_id = 1;
+
+// Vencimientos, en segundos de reloj monótono
+static TimerWheel g_rueda;
+static bool g_rueda_iniciada = false;
+
+// Hilo que hace vencer las retenciones cada segundo
+static pthread_t g_hilo;
+static bool g_hilo_activo = false;
+static bool g_hilo_parar = false;
+static pthread_cond_t g_hilo_despertar = PTHREAD_COND_INITIALIZER;
+
+static pthread_mutex_t g_retencion_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t retencion_tick_actual() {
+    struct timespec ahora;
+    clock_gettime(CLOCK_MONOTONIC, &ahora);
+    return (uint64_t)ahora.tv_sec;
+}
+
+static EntradaRetencion** retencion_cubo(int retencion_id) {
+    return &g_cubos[(unsigned int)retencion_id & (RETENCION_NUM_CUBOS - 1)];
+}
+
+// Sacar una retención de la tabla (con el mutex tomado)
+static EntradaRetencion* retencion_extraer(int retencion_id) {
+    EntradaRetencion** actual = retencion_cubo(retencion_id);
+    
+    while (*actual) {
+        if ((*actual)->datos.id == retencion_id) {
+            EntradaRetencion* entrada = *actual;
+            *actual = entrada->siguiente;
+            entrada->siguiente = NULL;
+            return entrada;
+        }
+        actual = &(*actual)->siguiente;
+    }
+    
+    return NULL;
+}
+
+static EntradaRetencion* retencion_buscar(int retencion_id) {
+    EntradaRetencion* entrada = *retencion_cubo(retencion_id);
+    
+    while (entrada && entrada->datos.id != retencion_id) {
+        entrada = entrada->siguiente;
+    }
+    
+    return entrada;
+}
+
+static RetencionesUsuario** retencion_usuario(int usuario_id) {
+    RetencionesUsuario** actual = &g_usuarios[(unsigned int)usuario_id & (RETENCION_NUM_CUBOS - 1)];
+    
+    while (*actual && (*actual)->usuario_id != usuario_id) {
+        actual = &(*actual)->siguiente;
+    }
+    
+    return actual;
+}
+
+// Asientos que el usuario tiene retenidos (con el mutex tomado)
+static int retencion_asientos_usuario(int usuario_id) {
+    RetencionesUsuario* usuario = *retencion_usuario(usuario_id);
+    return usuario ? usuario->num_asientos : 0;
+}
+
+// Sumar o restar asientos retenidos al usuario (con el mutex tomado)
+static bool retencion_contar_usuario(int usuario_id, int num_asientos) {
+    RetencionesUsuario** enlace = retencion_usuario(usuario_id);
+    RetencionesUsuario* usuario = *enlace;
+    
+    if (!usuario) {
+        usuario = (RetencionesUsuario*)MEM_ALLOC(sizeof(RetencionesUsuario));
+        if (!usuario) {
+            log_error("Error al asignar memoria para las retenciones del usuario %d", usuario_id);
+            return false;
+        }
+        usuario->usuario_id = usuario_id;
+        usuario->num_asientos = 0;
+        usuario->siguiente = NULL;
+        *enlace = usuario;
+    }
+    
+    usuario->num_asientos += num_asientos;
+    if (usuario->num_asientos <= 0) {
+        *enlace = usuario->siguiente;
+        MEM_FREE(usuario);
+    }
+    return true;
+}
+
+// Obtener una entrada libre, reservando otro bloque si no quedan
+static EntradaRetencion* retencion_nueva_entrada() {
+    if (!g_libres) {
+        BloqueRetenciones* bloque = (BloqueRetenciones*)MEM_ALLOC(sizeof(BloqueRetenciones));
+        if (!bloque) {
+            log_error("Error al asignar memoria para las retenciones");
+            return NULL;
+        }
+        
+        bloque->siguiente = g_bloques;
+        g_bloques = bloque;
+        
+        for (int i = 0; i < RETENCION_POR_BLOQUE; i++) {
+            bloque->entradas[i].siguiente = g_libres;
+            g_libres = &bloque->entradas[i];
+        }
+    }
+    
+    EntradaRetencion* entrada = g_libres;
+    g_libres = entrada->siguiente;
+    
+    memset(entrada, 0, sizeof(EntradaRetencion));
+    return entrada;
+}
+
+static void retencion_devolver_entrada(EntradaRetencion* entrada) {
+    entrada->siguiente = g_libres;
+    g_libres = entrada;
+}
+
+static void retencion_vencer(TimerWheelEntry* temporizador, void* contexto) {
+    EntradaRetencion* entrada = (EntradaRetencion*)temporizador;
+    int* vencidas = (int*)contexto;
+    
+    retencion_extraer(entrada->datos.id);
+    retencion_contar_usuario(entrada->datos.usuario_id, -entrada->datos.num_asientos);
+    ocupacion_soltar_retenidos(entrada->datos.sesion_id, entrada->datos.asiento_ids,
+                               entrada->datos.num_asientos);
+    retencion_devolver_entrada(entrada);
+    (*vencidas)++;
+}
+
+// Hacer vencer las retenciones cuyo plazo ya pasó (con el mutex tomado)
+static void retencion_avanzar() {
+    uint64_t ahora = retencion_tick_actual();
+    
+    if (!g_rueda_iniciada) {
+        timer_wheel_init(&g_rueda, ahora);
+        g_rueda_iniciada = true;
+        return;
+    }
+    
+    int vencidas = 0;
+    timer_wheel_advance(&g_rueda, ahora, retencion_vencer, &vencidas);
+    
+    if (vencidas > 0) {
+        log_info("Han vencido %d retenciones de asientos", vencidas);
+    }
+}
+
+static void* retencion_hilo(void* arg) {
+    (void)arg;
+    
+    pthread_mutex_lock(&g_retencion_mutex);
+    
+    while (!g_hilo_parar) {
+        retencion_avanzar();
+        
+        struct timespec limite;
+        clock_gettime(CLOCK_REALTIME, &limite);
+        limite.tv_sec += 1;
+        
+        int resultado = 0;
+        while (!g_hilo_parar && resultado != ETIMEDOUT) {
+            resultado = pthread_cond_timedwait(&g_hilo_despertar, &g_retencion_mutex, &limite);
+        }
+    }
+    
+    pthread_mutex_unlock(&g_retencion_mutex);
+    return NULL;
+}
+
+// Retener asientos de una sesión
+bool retencion_crear(int usuario_id, int sesion_id, const int* asiento_ids, int num_asientos,
+                     int segundos, int* retencion_id, int64_t* vence) {
+    if (!asiento_ids || num_asientos <= 0 || num_asientos > RETENCION_MAX_ASIENTOS) {
+        log_error("Retención de %d asientos inválida", num_asientos);
+        return false;
+    }
+    
+    if (segundos <= 0) {
+        segundos = RETENCION_SEGUNDOS_DEFECTO;
+    } else if (segundos > RETENCION_SEGUNDOS_MAX) {
+        segundos = RETENCION_SEGUNDOS_MAX;
+    }
+    
+    // Apartar el cupo del usuario antes de soltar el mutex, para que dos
+    // peticiones simultáneas no pasen juntas del límite
+    pthread_mutex_lock(&g_retencion_mutex);
+    if (retencion_asientos_usuario(usuario_id) + num_asientos > RETENCION_MAX_ASIENTOS_USUARIO) {
+        pthread_mutex_unlock(&g_retencion_mutex);
+        log_error("El usuario %d superaría el máximo de %d asientos retenidos",
+                  usuario_id, RETENCION_MAX_ASIENTOS_USUARIO);
+        return false;
+    }
+    bool contado = retencion_contar_usuario(usuario_id, num_asientos);
+    pthread_mutex_unlock(&g_retencion_mutex);
+    
+    if (!contado) {
+        return false;
+    }
+    
+    // Reservar en el inventario, sin el mutex: puede cargar el mapa de la
+    // sesión de la base de datos
+    if (!ocupacion_retener_asientos(sesion_id, asiento_ids, num_asientos)) {
+        pthread_mutex_lock(&g_retencion_mutex);
+        retencion_contar_usuario(usuario_id, -num_asientos);
+        pthread_mutex_unlock(&g_retencion_mutex);
+        log_error("No se pudieron retener los asientos de la sesión %d", sesion_id);
+        return false;
+    }
+    
+    pthread_mutex_lock(&g_retencion_mutex);
+    
+    EntradaRetencion* entrada = retencion_nueva_entrada();
+    if (!entrada) {
+        retencion_contar_usuario(usuario_id, -num_asientos);
+        pthread_mutex_unlock(&g_retencion_mutex);
+        ocupacion_soltar_retenidos(sesion_id, asiento_ids, num_asientos);
+        return false;
+    }
+    
+    if (!g_hilo_activo) {
+        g_hilo_parar = false;
+        if (pthread_create(&g_hilo, NULL, retencion_hilo, NULL) != 0) {
+            retencion_devolver_entrada(entrada);
+            retencion_contar_usuario(usuario_id, -num_asientos);
+            pthread_mutex_unlock(&g_retencion_mutex);
+            ocupacion_soltar_retenidos(sesion_id, asiento_ids, num_asientos);
+            log_error("No se pudo crear el hilo de vencimiento de retenciones");
+            return false;
+        }
+        g_hilo_activo = true;
+    }
+    
+    // La rueda debe estar al día antes de programar el vencimiento
+    retencion_avanzar();
+    
+    entrada->datos.id = g_siguiente_id++;
+    entrada->datos.usuario_id = usuario_id;
+    entrada->datos.sesion_id = sesion_id;
+    entrada->datos.num_asientos = num_asientos;
+    memcpy(entrada->datos.asiento_ids, asiento_ids, num_asientos * sizeof(int));
+    
+    EntradaRetencion** cubo = retencion_cubo(entrada->datos.id);
+    entrada->siguiente = *cubo;
+    *cubo = entrada;
+    
+    timer_wheel_add(&g_rueda, &entrada->temporizador, g_rueda.now + (uint64_t)segundos);
+    
+    *retencion_id = entrada->datos.id;
+    *vence = (int64_t)time(NULL) + segundos;
+    
+    pthread_mutex_unlock(&g_retencion_mutex);
+    
+    log_info("Retención %d: %d asientos de la sesión %d durante %d segundos",
+             *retencion_id, num_asientos, sesion_id, segundos);
+    return true;
+}
+
+// Indicar si el usuario puede retener más asientos
+bool retencion_cabe(int usuario_id, int num_asientos) {
+    pthread_mutex_lock(&g_retencion_mutex);
+    bool cabe = retencion_asientos_usuario(usuario_id) + num_asientos <= RETENCION_MAX_ASIENTOS_USUARIO;
+    pthread_mutex_unlock(&g_retencion_mutex);
+    return cabe;
+}
+
+// Sacar de la tabla y de la rueda una retención del usuario (con el mutex tomado)
+static EntradaRetencion* retencion_retirar(int retencion_id, int usuario_id) {
+    EntradaRetencion* entrada = retencion_buscar(retencion_id);
+    if (!entrada || entrada->datos.usuario_id != usuario_id) {
+        return NULL;
+    }
+    
+    retencion_extraer(retencion_id);
+    timer_wheel_remove(&g_rueda, &entrada->temporizador);
+    retencion_contar_usuario(usuario_id, -entrada->datos.num_asientos);
+    return entrada;
+}
+
+// Liberar una retención
+bool retencion_liberar(int retencion_id, int usuario_id) {
+    pthread_mutex_lock(&g_retencion_mutex);
+    
+    EntradaRetencion* entrada = retencion_retirar(retencion_id, usuario_id);
+    if (!entrada) {
+        pthread_mutex_unlock(&g_retencion_mutex);
+        log_error("No existe la retención %d del usuario %d", retencion_id, usuario_id);
+        return false;
+    }
+    
+    ocupacion_soltar_retenidos(entrada->datos.sesion_id, entrada->datos.asiento_ids,
+                               entrada->datos.num_asientos);
+    retencion_devolver_entrada(entrada);
+    
+    pthread_mutex_unlock(&g_retencion_mutex);
+    
+    log_info("Retención %d liberada", retencion_id);
+    return true;
+}
+
+// Retirar una retención para convertirla en venta
+bool retencion_tomar(int retencion_id, int usuario_id, Retencion* retencion) {
+    pthread_mutex_lock(&g_retencion_mutex);
+    
+    EntradaRetencion* entrada = retencion_retirar(retencion_id, usuario_id);
+    if (!entrada) {
+        pthread_mutex_unlock(&g_retencion_mutex);
+        log_error("No existe la retención %d del usuario %d", retencion_id, usuario_id);
+        return false;
+    }
+    
+    *retencion = entrada->datos;
+    retencion_devolver_entrada(entrada);
+    
+    pthread_mutex_unlock(&g_retencion_mutex);
+    return true;
+}
+
+// Detener el hilo y descartar todas las retenciones
+void retencion_limpiar() {
+    pthread_mutex_lock(&g_retencion_mutex);
+    bool hilo_activo = g_hilo_activo;
+    g_hilo_parar = true;
+    pthread_cond_signal(&g_hilo_despertar);
+    pthread_mutex_unlock(&g_retencion_mutex);
+    
+    if (hilo_activo) {
+        pthread_join(g_hilo, NULL);
+    }
+    
+    pthread_mutex_lock(&g_retencion_mutex);
+    
+    // Devolver al inventario los asientos que seguían retenidos
+    for (int i = 0; i < RETENCION_NUM_CUBOS; i++) {
+        for (EntradaRetencion* entrada = g_cubos[i]; entrada; entrada = entrada->siguiente) {
+            ocupacion_soltar_retenidos(entrada->datos.sesion_id, entrada->datos.asiento_ids,
+                                       entrada->datos.num_asientos);
+        }
+        g_cubos[i] = NULL;
+        
+        while (g_usuarios[i]) {
+            RetencionesUsuario* usuario = g_usuarios[i];
+            g_usuarios[i] = usuario->siguiente;
+            MEM_FREE(usuario);
+        }
+    }
+    
+    while (g_bloques) {
+        BloqueRetenciones* bloque = g_bloques;
+        g_bloques = bloque->siguiente;
+        MEM_FREE(bloque);
+    }
+    
+    g_libres = NULL;
+    g_hilo_activo = false;
+    g_rueda_iniciada = false;
+    
+    pthread_mutex_unlock(&g_retencion_mutex);
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#ifndef RETENCION_H
+#define RETENCION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Retenciones temporales de asientos. Mientras un cliente paga, sus asientos
+// quedan retenidos en el inventario de la sesión (ocupacion.h), así que las
+// consultas de disponibilidad ya los dan por ocupados y ninguna otra venta
+// puede tomarlos. Si la retención no se convierte en venta ni se libera antes
+// de su plazo, un hilo la hace vencer y los asientos vuelven a estar libres.
+// Las retenciones solo viven en memoria
+
+// Máximo de asientos en una retención
+#define RETENCION_MAX_ASIENTOS 16
+
+// Máximo de asientos que un usuario puede tener retenidos a la vez, sumando
+// todas sus retenciones. Impide que una cuenta acapare una sala entera
+// renovando retenciones
+#define RETENCION_MAX_ASIENTOS_USUARIO 32
+
+// Plazos de una retención, en segundos
+#define RETENCION_SEGUNDOS_DEFECTO 300
+#define RETENCION_SEGUNDOS_MAX 900
+
+// Asientos de una retención entregada para convertirla en venta
+typedef struct {
+    int id;
+    int usuario_id;
+    int sesion_id;
+    int num_asientos;
+    int asiento_ids[RETENCION_MAX_ASIENTOS];
+} Retencion;
+
+// Retener asientos de una sesión para un usuario durante segundos (0 usa el
+// plazo por defecto). Falla si alguno no está libre o si el usuario superaría
+// RETENCION_MAX_ASIENTOS_USUARIO. Devuelve el ID de la retención y la hora de
+// vencimiento (segundos desde la época)
+bool retencion_crear(int usuario_id, int sesion_id, const int* asiento_ids, int num_asientos,
+                     int segundos, int* retencion_id, int64_t* vence);
+
+// Indicar si el usuario puede retener num_asientos más sin pasar del límite
+bool retencion_cabe(int usuario_id, int num_asientos);
+
+// Liberar una retención del usuario y devolver sus asientos
+bool retencion_liberar(int retencion_id, int usuario_id);
+
+// Retirar una retención del usuario para venderla. Sus asientos siguen
+// retenidos en el inventario: quien la retiró debe confirmarlos con
+// ocupacion_confirmar_retenidos cuando la venta se guarde, o soltarlos con
+// ocupacion_soltar_retenidos si falla
+bool retencion_tomar(int retencion_id, int usuario_id, Retencion* retencion);
+
+// Detener el hilo de vencimientos y descartar todas las retenciones
+void retencion_limpiar();
+
+#endif // RETENCION_H
\ No newline at end of file
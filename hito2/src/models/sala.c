@@ -2,51 +2,18 @@
 #include "../database.h"
 #include "../utils/logger.h"
 #include "../utils/memory.h"
+#include "../utils/result_set.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
-// Función auxiliar para callback de SQLite
-static int sala_callback(void* data, int argc, char** argv, char** column_names) {
-    Sala* sala = (Sala*)data;
-    
-    for (int i = 0; i < argc; i++) {
-        if (strcmp(column_names[i], "ID") == 0) {
-            sala->id = atoi(argv[i]);
-        } else if (strcmp(column_names[i], "NumeroAsientos") == 0) {
-            sala->numero_asientos = atoi(argv[i]);
-        }
-    }
-    
-    return 0;
-}
+// Columnas de la tabla Sala
+static const DbColumn sala_columnas[] = {
+    DB_INT_COLUMN("ID", Sala, id),
+    DB_INT_COLUMN("NumeroAsientos", Sala, numero_asientos)
+};
 
-// Función callback para listar salas
-static int salas_listar_callback(void* data, int argc, char** argv, char** column_names) {
-    struct {
-        Sala* salas;
-        int max_salas;
-        int* num_salas;
-    }* callback_data = (void*)data;
-    
-    if (*callback_data->num_salas >= callback_data->max_salas) {
-        // No hay más espacio para salas
-        return 1;
-    }
-    
-    Sala* sala = &callback_data->salas[*callback_data->num_salas];
-    
-    for (int i = 0; i < argc; i++) {
-        if (strcmp(column_names[i], "ID") == 0) {
-            sala->id = atoi(argv[i]);
-        } else if (strcmp(column_names[i], "NumeroAsientos") == 0) {
-            sala->numero_asientos = atoi(argv[i]);
-        }
-    }
-    
-    (*callback_data->num_salas)++;
-    return 0;
-}
+static const DbRowMap sala_fila = DB_ROW_MAP(sala_columnas);
 
 // Crear una nueva sala
 bool sala_crear(Sala* sala) {
@@ -55,12 +22,12 @@ bool sala_crear(Sala* sala) {
         return false;
     }
     
-    char sql[256];
-    snprintf(sql, sizeof(sql),
-            "INSERT INTO Sala (NumeroAsientos) VALUES (%d);",
-            sala->numero_asientos);
+    sqlite3_stmt* stmt = db_statement(STMT_SALA_CREAR,
+    
+            "INSERT INTO Sala (NumeroAsientos) VALUES (?);");
+    db_bind_int(stmt, 1, sala->numero_asientos);
     
-    if (db_execute(sql)) {
+    if (db_statement_execute(stmt)) {
         sala->id = db_last_insert_id();
         log_info("Sala creada con ID: %d", sala->id);
         
@@ -78,11 +45,11 @@ bool sala_crear(Sala* sala) {
 
 // Obtener sala por ID
 bool sala_obtener_por_id(int id, Sala* sala) {
-    char sql[256];
-    snprintf(sql, sizeof(sql), "SELECT * FROM Sala WHERE ID = %d;", id);
+    sqlite3_stmt* stmt = db_statement(STMT_SALA_OBTENER_POR_ID, "SELECT * FROM Sala WHERE ID = ?;");
+    db_bind_int(stmt, 1, id);
     
     memset(sala, 0, sizeof(Sala));
-    return db_query(sql, sala_callback, sala);
+    return db_statement_read(stmt, &sala_fila, sala);
 }
 
 // Actualizar una sala existente
@@ -104,12 +71,13 @@ bool sala_actualizar(Sala* sala) {
         log_warning("Cambiar el número de asientos de una sala podría afectar a las sesiones y entradas existentes");
     }
     
-    char sql[256];
-    snprintf(sql, sizeof(sql),
-            "UPDATE Sala SET NumeroAsientos = %d WHERE ID = %d;",
-            sala->numero_asientos, sala->id);
+    sqlite3_stmt* stmt = db_statement(STMT_SALA_ACTUALIZAR,
     
-    if (db_execute(sql)) {
+            "UPDATE Sala SET NumeroAsientos = ? WHERE ID = ?;");
+    db_bind_int(stmt, 1, sala->numero_asientos);
+    db_bind_int(stmt, 2, sala->id);
+    
+    if (db_statement_execute(stmt)) {
         log_info("Sala actualizada con ID: %d", sala->id);
         return true;
     }
@@ -123,10 +91,10 @@ bool sala_eliminar(int id) {
     // Nota: Las restricciones de clave foránea en la base de datos se encargarán
     // de eliminar los asientos asociados (ON DELETE CASCADE)
     
-    char sql[256];
-    snprintf(sql, sizeof(sql), "DELETE FROM Sala WHERE ID = %d;", id);
+    sqlite3_stmt* stmt = db_statement(STMT_SALA_ELIMINAR, "DELETE FROM Sala WHERE ID = ?;");
+    db_bind_int(stmt, 1, id);
     
-    if (db_execute(sql)) {
+    if (db_statement_execute(stmt)) {
         log_info("Sala eliminada con ID: %d", id);
         return true;
     }
@@ -137,58 +105,22 @@ bool sala_eliminar(int id) {
 
 // Listar todas las salas
 bool sala_listar(Sala** salas, int* num_salas) {
-    // Primero, contar cuántas salas hay
-    char sql_count[256] = "SELECT COUNT(*) FROM Sala;";
-    int count = 0;
-    
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(get_database()->db, sql_count, -1, &stmt, NULL);
-    
-    if (rc != SQLITE_OK) {
-        log_error("Error al preparar la consulta: %s", sqlite3_errmsg(get_database()->db));
-        return false;
-    }
-    
-    rc = sqlite3_step(stmt);
-    
-    if (rc == SQLITE_ROW) {
-        count = sqlite3_column_int(stmt, 0);
-    }
-    
-    sqlite3_finalize(stmt);
-    
-    if (count == 0) {
-        *salas = NULL;
-        *num_salas = 0;
-        return true;
-    }
-    
-    // Asignar memoria para las salas
-    *salas = (Sala*)MEM_ALLOC(count * sizeof(Sala));
-    if (!*salas) {
-        log_error("Error al asignar memoria para la lista de salas");
-        return false;
-    }
-    
     // Consultar las salas
-    char sql[256] = "SELECT * FROM Sala;";
-    
-    struct {
-        Sala* salas;
-        int max_salas;
-        int* num_salas;
-    } callback_data = {*salas, count, num_salas};
+    sqlite3_stmt* stmt = db_statement(STMT_SALA_LISTAR, "SELECT * FROM Sala;");
     
-    *num_salas = 0;  // Inicializar el contador
+    ResultSet resultado;
+    result_set_init(&resultado, sizeof(Sala));
     
-    if (!db_query(sql, salas_listar_callback, &callback_data)) {
-        MEM_FREE(*salas);
+    if (!db_statement_read_all(stmt, &sala_fila, &resultado)) {
+        result_set_free(&resultado);
         *salas = NULL;
         *num_salas = 0;
         log_error("Error al consultar la lista de salas");
         return false;
     }
     
+    *salas = (Sala*)result_set_take(&resultado, num_salas);
+    
     log_info("Se listaron %d salas", *num_salas);
     return true;
 }
@@ -212,12 +144,12 @@ bool sala_crear_asientos(int sala_id) {
     
     // Crear los asientos
     for (int i = 1; i <= sala.numero_asientos; i++) {
-        char sql[256];
-        snprintf(sql, sizeof(sql),
-                "INSERT INTO Asiento (Sala_ID, Numero, Estado) VALUES (%d, %d, 'Libre');",
-                sala_id, i);
+        sqlite3_stmt* stmt = db_statement(STMT_ASIENTO_CREAR,
+                "INSERT INTO Asiento (Sala_ID, Numero, Estado) VALUES (?, ?, 'Libre');");
+        db_bind_int(stmt, 1, sala_id);
+        db_bind_int(stmt, 2, i);
         
-        if (!db_execute(sql)) {
+        if (!db_statement_execute(stmt)) {
             log_error("Error al crear asiento %d para la sala %d", i, sala_id);
             exito = false;
             break;
@@ -243,29 +175,16 @@ bool sala_crear_asientos(int sala_id) {
 
 // Contar asientos libres en una sala
 int sala_contar_asientos_libres(int sala_id) {
-    char sql[256];
-    snprintf(sql, sizeof(sql),
-            "SELECT COUNT(*) FROM Asiento WHERE Sala_ID = %d AND Estado = 'Libre';",
-            sala_id);
+    sqlite3_stmt* stmt = db_statement(STMT_SALA_CONTAR_ASIENTOS_LIBRES,
+            "SELECT COUNT(*) FROM Asiento WHERE Sala_ID = ? AND Estado = 'Libre';");
+    db_bind_int(stmt, 1, sala_id);
     
     int count = 0;
-    
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(get_database()->db, sql, -1, &stmt, NULL);
-    
-    if (rc != SQLITE_OK) {
-        log_error("Error al preparar la consulta: %s", sqlite3_errmsg(get_database()->db));
+    if (!db_statement_int(stmt, &count)) {
+        log_error("Error al contar los asientos libres");
         return -1;
     }
     
-    rc = sqlite3_step(stmt);
-    
-    if (rc == SQLITE_ROW) {
-        count = sqlite3_column_int(stmt, 0);
-    }
-    
-    sqlite3_finalize(stmt);
-    
     return count;
 }
 
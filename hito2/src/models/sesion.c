@@ -1,66 +1,43 @@
 #include "sesion.h"
 #include "pelicula.h"
 #include "sala.h"
+#include "ocupacion.h"
+#include "horario.h"
 #include "../database.h"
 #include "../utils/logger.h"
 #include "../utils/memory.h"
+#include "../utils/result_set.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <time.h>
 
-// Función auxiliar para callback de SQLite
-static int sesion_callback(void* data, int argc, char** argv, char** column_names) {
-    Sesion* sesion = (Sesion*)data;
-    
-    for (int i = 0; i < argc; i++) {
-        if (strcmp(column_names[i], "ID") == 0) {
-            sesion->id = atoi(argv[i]);
-        } else if (strcmp(column_names[i], "Pelicula_ID") == 0) {
-            sesion->pelicula_id = atoi(argv[i]);
-        } else if (strcmp(column_names[i], "Sala_ID") == 0) {
-            sesion->sala_id = atoi(argv[i]);
-        } else if (strcmp(column_names[i], "HoraInicio") == 0) {
-            strncpy(sesion->hora_inicio, argv[i] ? argv[i] : "", sizeof(sesion->hora_inicio) - 1);
-        } else if (strcmp(column_names[i], "HoraFin") == 0) {
-            strncpy(sesion->hora_fin, argv[i] ? argv[i] : "", sizeof(sesion->hora_fin) - 1);
-        }
-    }
-    
-    return 0;
-}
+// Columnas de la tabla Sesion
+static const DbColumn sesion_columnas[] = {
+    DB_INT_COLUMN("ID", Sesion, id),
+    DB_INT_COLUMN("Pelicula_ID", Sesion, pelicula_id),
+    DB_INT_COLUMN("Sala_ID", Sesion, sala_id),
+    DB_INT64_COLUMN("Inicio", Sesion, inicio),
+    DB_INT64_COLUMN("Fin", Sesion, fin)
+};
 
-// Función callback para listar sesiones
-static int sesiones_listar_callback(void* data, int argc, char** argv, char** column_names) {
-    struct {
-        Sesion* sesiones;
-        int max_sesiones;
-        int* num_sesiones;
-    }* callback_data = (void*)data;
-    
-    if (*callback_data->num_sesiones >= callback_data->max_sesiones) {
-        // No hay más espacio para sesiones
-        return 1;
-    }
-    
-    Sesion* sesion = &callback_data->sesiones[*callback_data->num_sesiones];
-    
-    for (int i = 0; i < argc; i++) {
-        if (strcmp(column_names[i], "ID") == 0) {
-            sesion->id = atoi(argv[i]);
-        } else if (strcmp(column_names[i], "Pelicula_ID") == 0) {
-            sesion->pelicula_id = atoi(argv[i]);
-        } else if (strcmp(column_names[i], "Sala_ID") == 0) {
-            sesion->sala_id = atoi(argv[i]);
-        } else if (strcmp(column_names[i], "HoraInicio") == 0) {
-            strncpy(sesion->hora_inicio, argv[i] ? argv[i] : "", sizeof(sesion->hora_inicio) - 1);
-        } else if (strcmp(column_names[i], "HoraFin") == 0) {
-            strncpy(sesion->hora_fin, argv[i] ? argv[i] : "", sizeof(sesion->hora_fin) - 1);
-        }
-    }
-    
-    (*callback_data->num_sesiones)++;
-    return 0;
+static const DbRowMap sesion_fila = DB_ROW_MAP(sesion_columnas);
+
+// Segundos de un día
+#define SESION_SEGUNDOS_DIA 86400
+
+// Días desde 1970-01-01 hasta una fecha del calendario gregoriano. Los años
+// se cuentan desde marzo para que el 29 de febrero quede al final
+static int64_t sesion_dias_desde_epoch(int64_t anio, int mes, int dia) {
+    if (mes <= 2) {
+        anio--;
+    }
+    
+    int64_t era = (anio >= 0 ? anio : anio - 399) / 400;
+    int64_t anio_era = anio - era * 400;
+    int64_t dia_anio = (153 * (mes > 2 ? mes - 3 : mes + 9) + 2) / 5 + dia - 1;
+    int64_t dia_era = anio_era * 365 + anio_era / 4 - anio_era / 100 + dia_anio;
+    return era * 146097 + dia_era - 719468;
 }
 
 // Crear una nueva sesión
@@ -76,15 +53,17 @@ bool sesion_crear(Sesion* sesion) {
         return false;
     }
     
-    char sql[512];
-    snprintf(sql, sizeof(sql),
-            "INSERT INTO Sesion (Pelicula_ID, Sala_ID, HoraInicio, HoraFin) "
-            "VALUES (%d, %d, '%s', '%s');",
-            sesion->pelicula_id, sesion->sala_id, 
-            sesion->hora_inicio, sesion->hora_fin);
+    sqlite3_stmt* stmt = db_statement(STMT_SESION_CREAR,
+            "INSERT INTO Sesion (Pelicula_ID, Sala_ID, Inicio, Fin) "
+            "VALUES (?, ?, ?, ?);");
+    db_bind_int(stmt, 1, sesion->pelicula_id);
+    db_bind_int(stmt, 2, sesion->sala_id);
+    db_bind_int64(stmt, 3, sesion->inicio);
+    db_bind_int64(stmt, 4, sesion->fin);
     
-    if (db_execute(sql)) {
+    if (db_statement_execute(stmt)) {
         sesion->id = db_last_insert_id();
+        horario_anadir_sesion(sesion->sala_id, sesion->id, sesion->inicio, sesion->fin);
         log_info("Sesión creada con ID: %d", sesion->id);
         return true;
     }
@@ -95,11 +74,12 @@ bool sesion_crear(Sesion* sesion) {
 
 // Obtener sesión por ID
 bool sesion_obtener_por_id(int id, Sesion* sesion) {
-    char sql[256];
-    snprintf(sql, sizeof(sql), "SELECT * FROM Sesion WHERE ID = %d;", id);
+    sqlite3_stmt* stmt = db_statement(STMT_SESION_OBTENER_POR_ID,
+            "SELECT * FROM Sesion WHERE ID = ?;");
+    db_bind_int(stmt, 1, id);
     
     memset(sesion, 0, sizeof(Sesion));
-    return db_query(sql, sesion_callback, sesion);
+    return db_statement_read(stmt, &sesion_fila, sesion);
 }
 
 // Actualizar una sesión existente
@@ -115,16 +95,28 @@ bool sesion_actualizar(Sesion* sesion) {
         return false;
     }
     
-    char sql[512];
-    snprintf(sql, sizeof(sql),
-            "UPDATE Sesion SET Pelicula_ID = %d, Sala_ID = %d, "
-            "HoraInicio = '%s', HoraFin = '%s' "
-            "WHERE ID = %d;",
-            sesion->pelicula_id, sesion->sala_id,
-            sesion->hora_inicio, sesion->hora_fin,
-            sesion->id);
+    // Horario anterior, para moverla en el índice
+    Sesion anterior;
+    if (!sesion_obtener_por_id(sesion->id, &anterior) || anterior.id != sesion->id) {
+        log_error("No existe la sesión con ID: %d", sesion->id);
+        return false;
+    }
     
-    if (db_execute(sql)) {
+    sqlite3_stmt* stmt = db_statement(STMT_SESION_ACTUALIZAR,
+            "UPDATE Sesion SET Pelicula_ID = ?, Sala_ID = ?, "
+            "Inicio = ?, Fin = ? "
+            "WHERE ID = ?;");
+    db_bind_int(stmt, 1, sesion->pelicula_id);
+    db_bind_int(stmt, 2, sesion->sala_id);
+    db_bind_int64(stmt, 3, sesion->inicio);
+    db_bind_int64(stmt, 4, sesion->fin);
+    db_bind_int(stmt, 5, sesion->id);
+    
+    if (db_statement_execute(stmt)) {
+        // La sala puede haber cambiado, así que el mapa de asientos se rehace
+        ocupacion_invalidar_sesion(sesion->id);
+        horario_quitar_sesion(anterior.sala_id, anterior.id, anterior.inicio);
+        horario_anadir_sesion(sesion->sala_id, sesion->id, sesion->inicio, sesion->fin);
         log_info("Sesión actualizada con ID: %d", sesion->id);
         return true;
     }
@@ -135,10 +127,17 @@ bool sesion_actualizar(Sesion* sesion) {
 
 // Eliminar una sesión
 bool sesion_eliminar(int id) {
-    char sql[256];
-    snprintf(sql, sizeof(sql), "DELETE FROM Sesion WHERE ID = %d;", id);
+    Sesion anterior;
+    bool existe = sesion_obtener_por_id(id, &anterior) && anterior.id == id;
     
-    if (db_execute(sql)) {
+    sqlite3_stmt* stmt = db_statement(STMT_SESION_ELIMINAR, "DELETE FROM Sesion WHERE ID = ?;");
+    db_bind_int(stmt, 1, id);
+    
+    if (db_statement_execute(stmt)) {
+        ocupacion_invalidar_sesion(id);
+        if (existe) {
+            horario_quitar_sesion(anterior.sala_id, anterior.id, anterior.inicio);
+        }
         log_info("Sesión eliminada con ID: %d", id);
         return true;
     }
@@ -149,245 +148,163 @@ bool sesion_eliminar(int id) {
 
 // Listar todas las sesiones
 bool sesion_listar(Sesion** sesiones, int* num_sesiones) {
-    // Primero, contar cuántas sesiones hay
-    char sql_count[256] = "SELECT COUNT(*) FROM Sesion;";
-    int count = 0;
-    
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(get_database()->db, sql_count, -1, &stmt, NULL);
-    
-    if (rc != SQLITE_OK) {
-        log_error("Error al preparar la consulta: %s", sqlite3_errmsg(get_database()->db));
-        return false;
-    }
-    
-    rc = sqlite3_step(stmt);
-    
-    if (rc == SQLITE_ROW) {
-        count = sqlite3_column_int(stmt, 0);
-    }
-    
-    sqlite3_finalize(stmt);
-    
-    if (count == 0) {
-        *sesiones = NULL;
-        *num_sesiones = 0;
-        return true;
-    }
-    
-    // Asignar memoria para las sesiones
-    *sesiones = (Sesion*)MEM_ALLOC(count * sizeof(Sesion));
-    if (!*sesiones) {
-        log_error("Error al asignar memoria para la lista de sesiones");
-        return false;
-    }
-    
     // Consultar las sesiones
-    char sql[256] = "SELECT * FROM Sesion ORDER BY HoraInicio;";
+    sqlite3_stmt* stmt = db_statement(STMT_SESION_LISTAR,
+            "SELECT * FROM Sesion ORDER BY Inicio;");
     
-    struct {
-        Sesion* sesiones;
-        int max_sesiones;
-        int* num_sesiones;
-    } callback_data = {*sesiones, count, num_sesiones};
+    ResultSet resultado;
+    result_set_init(&resultado, sizeof(Sesion));
     
-    *num_sesiones = 0;  // Inicializar el contador
-    
-    if (!db_query(sql, sesiones_listar_callback, &callback_data)) {
-        MEM_FREE(*sesiones);
+    if (!db_statement_read_all(stmt, &sesion_fila, &resultado)) {
+        result_set_free(&resultado);
         *sesiones = NULL;
         *num_sesiones = 0;
         log_error("Error al consultar la lista de sesiones");
         return false;
     }
     
+    *sesiones = (Sesion*)result_set_take(&resultado, num_sesiones);
+    
     log_info("Se listaron %d sesiones", *num_sesiones);
     return true;
 }
 
 // Buscar sesiones por película
 bool sesion_buscar_por_pelicula(int pelicula_id, Sesion** sesiones, int* num_sesiones) {
-    char sql_count[256];
-    snprintf(sql_count, sizeof(sql_count), 
-            "SELECT COUNT(*) FROM Sesion WHERE Pelicula_ID = %d;", pelicula_id);
-    
-    int count = 0;
-    
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(get_database()->db, sql_count, -1, &stmt, NULL);
-    
-    if (rc != SQLITE_OK) {
-        log_error("Error al preparar la consulta: %s", sqlite3_errmsg(get_database()->db));
-        return false;
-    }
-    
-    rc = sqlite3_step(stmt);
-    
-    if (rc == SQLITE_ROW) {
-        count = sqlite3_column_int(stmt, 0);
-    }
-    
-    sqlite3_finalize(stmt);
-    
-    if (count == 0) {
-        *sesiones = NULL;
-        *num_sesiones = 0;
-        return true;
-    }
-    
-    // Asignar memoria para las sesiones
-    *sesiones = (Sesion*)MEM_ALLOC(count * sizeof(Sesion));
-    if (!*sesiones) {
-        log_error("Error al asignar memoria para la búsqueda de sesiones");
-        return false;
-    }
-    
     // Consultar las sesiones
-    char sql[256];
-    snprintf(sql, sizeof(sql), 
-            "SELECT * FROM Sesion WHERE Pelicula_ID = %d ORDER BY HoraInicio;", pelicula_id);
-    
-    struct {
-        Sesion* sesiones;
-        int max_sesiones;
-        int* num_sesiones;
-    } callback_data = {*sesiones, count, num_sesiones};
+    sqlite3_stmt* stmt = db_statement(STMT_SESION_BUSCAR_POR_PELICULA,
+            "SELECT * FROM Sesion WHERE Pelicula_ID = ? ORDER BY Inicio;");
+    db_bind_int(stmt, 1, pelicula_id);
     
-    *num_sesiones = 0;  // Inicializar el contador
+    ResultSet resultado;
+    result_set_init(&resultado, sizeof(Sesion));
     
-    if (!db_query(sql, sesiones_listar_callback, &callback_data)) {
-        MEM_FREE(*sesiones);
+    if (!db_statement_read_all(stmt, &sesion_fila, &resultado)) {
+        result_set_free(&resultado);
         *sesiones = NULL;
         *num_sesiones = 0;
         log_error("Error al consultar la búsqueda de sesiones por película");
         return false;
     }
     
+    *sesiones = (Sesion*)result_set_take(&resultado, num_sesiones);
+    
     log_info("Se encontraron %d sesiones para la película %d", *num_sesiones, pelicula_id);
     return true;
 }
 
 // Buscar sesiones por sala
 bool sesion_buscar_por_sala(int sala_id, Sesion** sesiones, int* num_sesiones) {
-    char sql_count[256];
-    snprintf(sql_count, sizeof(sql_count), 
-            "SELECT COUNT(*) FROM Sesion WHERE Sala_ID = %d;", sala_id);
-    
-    int count = 0;
-    
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(get_database()->db, sql_count, -1, &stmt, NULL);
-    
-    if (rc != SQLITE_OK) {
-        log_error("Error al preparar la consulta: %s", sqlite3_errmsg(get_database()->db));
-        return false;
-    }
-    
-    rc = sqlite3_step(stmt);
-    
-    if (rc == SQLITE_ROW) {
-        count = sqlite3_column_int(stmt, 0);
-    }
-    
-    sqlite3_finalize(stmt);
-    
-    if (count == 0) {
-        *sesiones = NULL;
-        *num_sesiones = 0;
-        return true;
-    }
-    
-    // Asignar memoria para las sesiones
-    *sesiones = (Sesion*)MEM_ALLOC(count * sizeof(Sesion));
-    if (!*sesiones) {
-        log_error("Error al asignar memoria para la búsqueda de sesiones");
-        return false;
-    }
-    
     // Consultar las sesiones
-    char sql[256];
-    snprintf(sql, sizeof(sql), 
-            "SELECT * FROM Sesion WHERE Sala_ID = %d ORDER BY HoraInicio;", sala_id);
+    sqlite3_stmt* stmt = db_statement(STMT_SESION_BUSCAR_POR_SALA,
+            "SELECT * FROM Sesion WHERE Sala_ID = ? ORDER BY Inicio;");
+    db_bind_int(stmt, 1, sala_id);
     
-    struct {
-        Sesion* sesiones;
-        int max_sesiones;
-        int* num_sesiones;
-    } callback_data = {*sesiones, count, num_sesiones};
+    ResultSet resultado;
+    result_set_init(&resultado, sizeof(Sesion));
     
-    *num_sesiones = 0;  // Inicializar el contador
-    
-    if (!db_query(sql, sesiones_listar_callback, &callback_data)) {
-        MEM_FREE(*sesiones);
+    if (!db_statement_read_all(stmt, &sesion_fila, &resultado)) {
+        result_set_free(&resultado);
         *sesiones = NULL;
         *num_sesiones = 0;
         log_error("Error al consultar la búsqueda de sesiones por sala");
         return false;
     }
     
+    *sesiones = (Sesion*)result_set_take(&resultado, num_sesiones);
+    
     log_info("Se encontraron %d sesiones para la sala %d", *num_sesiones, sala_id);
     return true;
 }
 
 // Buscar sesiones por fecha
 bool sesion_buscar_por_fecha(const char* fecha, Sesion** sesiones, int* num_sesiones) {
-    char sql_count[512];
-    snprintf(sql_count, sizeof(sql_count), 
-            "SELECT COUNT(*) FROM Sesion WHERE HoraInicio LIKE '%s%%';", fecha);
-    
-    int count = 0;
-    
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(get_database()->db, sql_count, -1, &stmt, NULL);
-    
-    if (rc != SQLITE_OK) {
-        log_error("Error al preparar la consulta: %s", sqlite3_errmsg(get_database()->db));
+    // La fecha (YYYY-MM-DD) se convierte en el rango de su día
+    int anio, mes, dia;
+    if (!fecha || sscanf(fecha, "%d-%d-%d", &anio, &mes, &dia) != 3) {
+        *sesiones = NULL;
+        *num_sesiones = 0;
+        log_error("Formato de fecha inválido: %s", fecha ? fecha : "");
         return false;
     }
     
-    rc = sqlite3_step(stmt);
+    int64_t desde = sesion_dias_desde_epoch(anio, mes, dia) * SESION_SEGUNDOS_DIA;
     
-    if (rc == SQLITE_ROW) {
-        count = sqlite3_column_int(stmt, 0);
-    }
+    // Consultar las sesiones
+    sqlite3_stmt* stmt = db_statement(STMT_SESION_BUSCAR_POR_FECHA,
+            "SELECT * FROM Sesion WHERE Inicio >= ? AND Inicio < ? ORDER BY Inicio;");
+    db_bind_int64(stmt, 1, desde);
+    db_bind_int64(stmt, 2, desde + SESION_SEGUNDOS_DIA);
     
-    sqlite3_finalize(stmt);
+    ResultSet resultado;
+    result_set_init(&resultado, sizeof(Sesion));
     
-    if (count == 0) {
+    if (!db_statement_read_all(stmt, &sesion_fila, &resultado)) {
+        result_set_free(&resultado);
         *sesiones = NULL;
         *num_sesiones = 0;
-        return true;
+        log_error("Error al consultar la búsqueda de sesiones por fecha");
+        return false;
     }
     
-    // Asignar memoria para las sesiones
-    *sesiones = (Sesion*)MEM_ALLOC(count * sizeof(Sesion));
-    if (!*sesiones) {
-        log_error("Error al asignar memoria para la búsqueda de sesiones");
+    *sesiones = (Sesion*)result_set_take(&resultado, num_sesiones);
+    
+    log_info("Se encontraron %d sesiones para la fecha %s", *num_sesiones, fecha);
+    return true;
+}
+
+// Buscar sesiones por rango de horas
+bool sesion_buscar_por_rango(int64_t desde, int64_t hasta, int sala_id, int pelicula_id,
+                             int limite, Sesion** sesiones, int* num_sesiones) {
+    *sesiones = NULL;
+    *num_sesiones = 0;
+    
+    if (hasta < desde) {
+        log_error("Rango de horas inválido: %lld - %lld", (long long)desde, (long long)hasta);
         return false;
     }
     
-    // Consultar las sesiones
-    char sql[512];
-    snprintf(sql, sizeof(sql), 
-            "SELECT * FROM Sesion WHERE HoraInicio LIKE '%s%%' ORDER BY HoraInicio;", fecha);
+    // Cada filtro tiene su consulta para que SQLite recorra el índice que
+    // empieza por esa columna y siga Inicio: el rango sale ya ordenado y el
+    // LIMIT corta el recorrido sin ordenar nada. Un LIMIT negativo no limita
+    sqlite3_stmt* stmt;
+    int siguiente;
+    if (sala_id > 0) {
+        stmt = db_statement(STMT_SESION_BUSCAR_POR_RANGO_SALA,
+                "SELECT * FROM Sesion WHERE Sala_ID = ? AND Inicio >= ? AND Inicio < ? "
+                "AND (?4 <= 0 OR Pelicula_ID = ?4) ORDER BY Inicio LIMIT ?5;");
+        db_bind_int(stmt, 1, sala_id);
+        db_bind_int(stmt, 4, pelicula_id);
+        siguiente = 2;
+    } else if (pelicula_id > 0) {
+        stmt = db_statement(STMT_SESION_BUSCAR_POR_RANGO_PELICULA,
+                "SELECT * FROM Sesion WHERE Pelicula_ID = ? AND Inicio >= ? AND Inicio < ? "
+                "ORDER BY Inicio LIMIT ?;");
+        db_bind_int(stmt, 1, pelicula_id);
+        siguiente = 2;
+    } else {
+        stmt = db_statement(STMT_SESION_BUSCAR_POR_RANGO,
+                "SELECT * FROM Sesion WHERE Inicio >= ? AND Inicio < ? ORDER BY Inicio LIMIT ?;");
+        siguiente = 1;
+    }
     
-    struct {
-        Sesion* sesiones;
-        int max_sesiones;
-        int* num_sesiones;
-    } callback_data = {*sesiones, count, num_sesiones};
+    db_bind_int64(stmt, siguiente, desde);
+    db_bind_int64(stmt, siguiente + 1, hasta);
+    db_bind_int(stmt, sala_id > 0 ? 5 : siguiente + 2, limite > 0 ? limite : -1);
     
-    *num_sesiones = 0;  // Inicializar el contador
+    ResultSet resultado;
+    result_set_init(&resultado, sizeof(Sesion));
     
-    if (!db_query(sql, sesiones_listar_callback, &callback_data)) {
-        MEM_FREE(*sesiones);
-        *sesiones = NULL;
-        *num_sesiones = 0;
-        log_error("Error al consultar la búsqueda de sesiones por fecha");
+    if (!db_statement_read_all(stmt, &sesion_fila, &resultado)) {
+        result_set_free(&resultado);
+        log_error("Error al consultar la búsqueda de sesiones por rango");
         return false;
     }
     
-    log_info("Se encontraron %d sesiones para la fecha %s", *num_sesiones, fecha);
+    *sesiones = (Sesion*)result_set_take(&resultado, num_sesiones);
+    
+    log_info("Se encontraron %d sesiones entre %lld y %lld", *num_sesiones,
+             (long long)desde, (long long)hasta);
     return true;
 }
 
@@ -399,9 +316,7 @@ bool sesion_validar(Sesion* sesion) {
     
     // Validar que los campos obligatorios no estén vacíos
     if (sesion->pelicula_id <= 0 || 
-        sesion->sala_id <= 0 || 
-        strlen(sesion->hora_inicio) == 0 || 
-        strlen(sesion->hora_fin) == 0) {
+        sesion->sala_id <= 0) {
         return false;
     }
     
@@ -419,19 +334,8 @@ bool sesion_validar(Sesion* sesion) {
         return false;
     }
     
-    // Verificar formato de fechas y que hora_fin sea posterior a hora_inicio
-    struct tm tm_inicio, tm_fin;
-    
-    if (!sesion_convertir_str_a_time(sesion->hora_inicio, &tm_inicio) ||
-        !sesion_convertir_str_a_time(sesion->hora_fin, &tm_fin)) {
-        log_error("Formato de fecha inválido");
-        return false;
-    }
-    
-    time_t tiempo_inicio = mktime(&tm_inicio);
-    time_t tiempo_fin = mktime(&tm_fin);
-    
-    if (tiempo_fin <= tiempo_inicio) {
+    // Verificar que la hora de fin sea posterior a la de inicio
+    if (sesion->fin <= sesion->inicio) {
         log_error("La hora de fin debe ser posterior a la hora de inicio");
         return false;
     }
@@ -441,67 +345,20 @@ bool sesion_validar(Sesion* sesion) {
 
 // Comprobar disponibilidad de la sala en el horario especificado
 bool sesion_comprobar_disponibilidad(Sesion* sesion) {
-    char sql[512];
-    
     // Si estamos actualizando una sesión existente, excluirla de la comprobación
-    if (sesion->id > 0) {
-        snprintf(sql, sizeof(sql),
-                "SELECT COUNT(*) FROM Sesion "
-                "WHERE Sala_ID = %d AND ID != %d AND "
-                "((HoraInicio <= '%s' AND HoraFin > '%s') OR "
-                "(HoraInicio < '%s' AND HoraFin >= '%s') OR "
-                "(HoraInicio >= '%s' AND HoraFin <= '%s'));",
-                sesion->sala_id, sesion->id,
-                sesion->hora_inicio, sesion->hora_inicio,
-                sesion->hora_fin, sesion->hora_fin,
-                sesion->hora_inicio, sesion->hora_fin);
-    } else {
-        snprintf(sql, sizeof(sql),
-                "SELECT COUNT(*) FROM Sesion "
-                "WHERE Sala_ID = %d AND "
-                "((HoraInicio <= '%s' AND HoraFin > '%s') OR "
-                "(HoraInicio < '%s' AND HoraFin >= '%s') OR "
-                "(HoraInicio >= '%s' AND HoraFin <= '%s'));",
-                sesion->sala_id,
-                sesion->hora_inicio, sesion->hora_inicio,
-                sesion->hora_fin, sesion->hora_fin,
-                sesion->hora_inicio, sesion->hora_fin);
-    }
-    
-    int count = 0;
-    
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(get_database()->db, sql, -1, &stmt, NULL);
-    
-    if (rc != SQLITE_OK) {
-        log_error("Error al preparar la consulta: %s", sqlite3_errmsg(get_database()->db));
+    // (las sesiones nuevas tienen ID 0, que no coincide con ninguna)
+    bool solapa = false;
+    if (!horario_hay_solape(sesion->sala_id, sesion->inicio, sesion->fin, sesion->id > 0 ? sesion->id : 0, &solapa)) {
+        log_error("Error al comprobar la disponibilidad de la sala %d", sesion->sala_id);
         return false;
     }
     
-    rc = sqlite3_step(stmt);
-    
-    if (rc == SQLITE_ROW) {
-        count = sqlite3_column_int(stmt, 0);
-    }
-    
-    sqlite3_finalize(stmt);
-    
-    return count == 0;
+    return !solapa;
 }
 
 // Calcular la duración de la sesión en minutos
 int sesion_calcular_duracion_minutos(Sesion* sesion) {
-    struct tm tm_inicio, tm_fin;
-    
-    if (!sesion_convertir_str_a_time(sesion->hora_inicio, &tm_inicio) ||
-        !sesion_convertir_str_a_time(sesion->hora_fin, &tm_fin)) {
-        return -1;
-    }
-    
-    time_t tiempo_inicio = mktime(&tm_inicio);
-    time_t tiempo_fin = mktime(&tm_fin);
-    
-    return (int)difftime(tiempo_fin, tiempo_inicio) / 60;
+    return (int)((sesion->fin - sesion->inicio) / 60);
 }
 
 // Convertir cadena a estructura tm
@@ -525,6 +382,55 @@ bool sesion_convertir_str_a_time(const char* str_hora, struct tm* tm_hora) {
     return true;
 }
 
+// Convertir cadena a segundos desde la época. La hora se toma tal cual, sin
+// zona horaria, así que no le afectan los cambios de hora
+bool sesion_convertir_str_a_epoch(const char* str_hora, int64_t* epoch) {
+    int anio, mes, dia, hora, minuto, segundo;
+    if (!str_hora || !epoch ||
+        sscanf(str_hora, "%d-%d-%d %d:%d:%d", &anio, &mes, &dia, &hora, &minuto, &segundo) != 6) {
+        return false;
+    }
+    
+    if (mes < 1 || mes > 12 || dia < 1 || dia > 31 ||
+        hora < 0 || hora > 23 || minuto < 0 || minuto > 59 || segundo < 0 || segundo > 59) {
+        return false;
+    }
+    
+    *epoch = sesion_dias_desde_epoch(anio, mes, dia) * SESION_SEGUNDOS_DIA +
+             hora * 3600 + minuto * 60 + segundo;
+    return true;
+}
+
+// Convertir segundos desde la época a cadena "YYYY-MM-DD HH:MM:SS"
+bool sesion_convertir_epoch_a_str(int64_t epoch, char* str_hora, size_t tam) {
+    if (!str_hora) {
+        return false;
+    }
+    
+    int64_t dias = epoch / SESION_SEGUNDOS_DIA;
+    int64_t segundos = epoch % SESION_SEGUNDOS_DIA;
+    if (segundos < 0) {
+        segundos += SESION_SEGUNDOS_DIA;
+        dias--;
+    }
+    
+    // Inverso de sesion_dias_desde_epoch
+    dias += 719468;
+    int64_t era = (dias >= 0 ? dias : dias - 146096) / 146097;
+    int64_t dia_era = dias - era * 146097;
+    int64_t anio_era = (dia_era - dia_era / 1460 + dia_era / 36524 - dia_era / 146096) / 365;
+    int64_t dia_anio = dia_era - (365 * anio_era + anio_era / 4 - anio_era / 100);
+    int64_t mes_marzo = (5 * dia_anio + 2) / 153;
+    int dia = (int)(dia_anio - (153 * mes_marzo + 2) / 5 + 1);
+    int mes = (int)(mes_marzo < 10 ? mes_marzo + 3 : mes_marzo - 9);
+    int64_t anio = anio_era + era * 400 + (mes <= 2 ? 1 : 0);
+    
+    snprintf(str_hora, tam, "%04lld-%02d-%02d %02d:%02d:%02d",
+             (long long)anio, mes, dia,
+             (int)(segundos / 3600), (int)(segundos / 60 % 60), (int)(segundos % 60));
+    return true;
+}
+
 // Convertir estructura tm a cadena
 bool sesion_convertir_time_a_str(struct tm* tm_hora, char* str_hora, size_t tam) {
     if (!tm_hora || !str_hora) {
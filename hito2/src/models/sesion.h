@@ -2,6 +2,7 @@
 #define SESION_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <time.h>
 
 // Estructura de sesión
@@ -9,8 +10,8 @@ typedef struct {
     int id;
     int pelicula_id;
     int sala_id;
-    char hora_inicio[20]; // Formato: "YYYY-MM-DD HH:MM:SS"
-    char hora_fin[20];    // Formato: "YYYY-MM-DD HH:MM:SS"
+    int64_t inicio;       // Segundos desde 1970-01-01 00:00:00, en hora local sin zona
+    int64_t fin;          // Igual que inicio; el intervalo es [inicio, fin)
 } Sesion;
 
 // Funciones CRUD
@@ -25,14 +26,23 @@ bool sesion_buscar_por_pelicula(int pelicula_id, Sesion** sesiones, int* num_ses
 bool sesion_buscar_por_sala(int sala_id, Sesion** sesiones, int* num_sesiones);
 bool sesion_buscar_por_fecha(const char* fecha, Sesion** sesiones, int* num_sesiones);
 
+// Sesiones que empiezan en [desde, hasta), ordenadas por hora de inicio.
+// sala_id y pelicula_id solo filtran si son mayores que 0, y limite <= 0
+// devuelve todas
+bool sesion_buscar_por_rango(int64_t desde, int64_t hasta, int sala_id, int pelicula_id,
+                             int limite, Sesion** sesiones, int* num_sesiones);
+
 // Funciones adicionales
 bool sesion_validar(Sesion* sesion);
 bool sesion_comprobar_disponibilidad(Sesion* sesion); // Comprueba si la sala está disponible en ese horario
 int sesion_calcular_duracion_minutos(Sesion* sesion); // Calcula la duración en minutos
 
-// Funciones de ayuda
+// Funciones de ayuda. Las horas solo se pasan a texto ("YYYY-MM-DD HH:MM:SS")
+// para leerlas del usuario o mostrarlas
 bool sesion_convertir_str_a_time(const char* str_hora, struct tm* tm_hora);
 bool sesion_convertir_time_a_str(struct tm* tm_hora, char* str_hora, size_t tam);
+bool sesion_convertir_str_a_epoch(const char* str_hora, int64_t* epoch);
+bool sesion_convertir_epoch_a_str(int64_t epoch, char* str_hora, size_t tam);
 
 // Funciones de memoria
 void sesion_liberar_lista(Sesion* sesiones, int num_sesiones);
@@ -0,0 +1,633 @@
+#include "titulos.h"
+#include "../utils/logger.h"
+#include "../utils/memory.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+// Caracteres de un título normalizado: espacio, a-z y 0-9
+#define TITULOS_ALFABETO 37
+#define TITULOS_NUM_TRIGRAMAS (TITULOS_ALFABETO * TITULOS_ALFABETO * TITULOS_ALFABETO)
+
+// Longitud máxima de un texto normalizado (la de Pelicula.titulo)
+#define TITULOS_MAX_TEXTO 200
+
+// Palabras de la consulta que se tienen en cuenta
+#define TITULOS_MAX_PALABRAS 16
+
+// Películas (ids ordenados) con un trigrama. Todas las listas comparten un
+// único array para no hacer una reserva por trigrama: la lista que se llena
+// se copia al final con el doble de capacidad y deja un hueco, que se
+// recupera al reorganizar el array
+typedef struct {
+    int inicio;
+    int num;
+    int capacidad;
+} ListaTrigrama;
+
+// Película indexada, con su título ya normalizado
+typedef struct {
+    Pelicula pelicula;
+    char normalizado[TITULOS_MAX_TEXTO];
+} DocumentoTitulo;
+
+// Película candidata de una búsqueda
+typedef struct {
+    int puntos;
+    const DocumentoTitulo* documento;
+} ResultadoTitulo;
+
+static bool g_cargado = false;
+
+static ListaTrigrama* g_listas;
+static int* g_ids;
+static int g_ids_usados;
+static int g_ids_capacidad;
+static int g_ids_huecos;
+
+// Documentos ordenados por id de película
+static DocumentoTitulo* g_documentos;
+static int g_num_documentos;
+static int g_capacidad_documentos;
+
+// Las películas se guardan desde el hilo escritor, pero se buscan desde
+// cualquier hilo
+static pthread_mutex_t g_titulos_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Letra sin tilde de cada carácter de U+00C0 a U+00FF según sus 5 bits bajos,
+// que son los mismos en mayúscula y en minúscula. Los símbolos separan
+// palabras (U+00FF, ÿ, se trata aparte porque en mayúscula es ß)
+static const char g_sin_tilde[] = "aaaaaaaceeeeiiiidnooooo ouuuuy s";
+
+// Pasar un texto a minúsculas sin tildes
+void titulos_normalizar(const char* texto, char* destino, size_t tam) {
+    if (tam == 0) {
+        return;
+    }
+    
+    const unsigned char* p = (const unsigned char*)texto;
+    size_t longitud = 0;
+    bool separar = false;
+    
+    while (*p) {
+        char c = ' ';
+        
+        if (*p < 0x80) {
+            if (*p >= 'A' && *p <= 'Z') {
+                c = (char)(*p - 'A' + 'a');
+            } else if ((*p >= 'a' && *p <= 'z') || (*p >= '0' && *p <= '9')) {
+                c = (char)*p;
+            }
+            p++;
+        } else if (*p == 0xC3 && p[1] >= 0x80 && p[1] <= 0xBF) {
+            c = p[1] == 0xBF ? 'y' : g_sin_tilde[p[1] & 0x1F];
+            p += 2;
+        } else {
+            // Cualquier otro carácter multibyte separa palabras
+            p++;
+            while ((*p & 0xC0) == 0x80) {
+                p++;
+            }
+        }
+        
+        if (c == ' ') {
+            separar = longitud > 0;
+            continue;
+        }
+        
+        if (longitud + (separar ? 2 : 1) >= tam) {
+            break;
+        }
+        
+        if (separar) {
+            destino[longitud++] = ' ';
+            separar = false;
+        }
+        destino[longitud++] = c;
+    }
+    
+    destino[longitud] = '\0';
+}
+
+static int titulos_codigo(char c) {
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a' + 1;
+    }
+    if (c >= '0' && c <= '9') {
+        return c - '0' + 27;
+    }
+    return 0;
+}
+
+static int titulos_trigrama(int primero, int segundo, int tercero) {
+    return (primero * TITULOS_ALFABETO + segundo) * TITULOS_ALFABETO + tercero;
+}
+
+static int titulos_comparar_enteros(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// Trigramas distintos de un texto normalizado. Cada palabra lleva delante dos
+// espacios, así que "sol" da "  s", " so" y "sol"
+static int titulos_trigramas(const char* texto, int* trigramas) {
+    int num = 0;
+    int penultimo = 0;
+    int ultimo = 0;
+    
+    for (const char* p = texto; *p; p++) {
+        if (*p == ' ') {
+            penultimo = ultimo = 0;
+            continue;
+        }
+        
+        int codigo = titulos_codigo(*p);
+        trigramas[num++] = titulos_trigrama(penultimo, ultimo, codigo);
+        penultimo = ultimo;
+        ultimo = codigo;
+    }
+    
+    qsort(trigramas, num, sizeof(int), titulos_comparar_enteros);
+    
+    int distintos = 0;
+    for (int i = 0; i < num; i++) {
+        if (distintos == 0 || trigramas[distintos - 1] != trigramas[i]) {
+            trigramas[distintos++] = trigramas[i];
+        }
+    }
+    
+    return distintos;
+}
+
+// Trigramas que tiene que contener un título para que una palabra de la
+// consulta pueda estar en él. Desde tres letras vale cualquier posición; con
+// menos, la palabra solo puede ser el principio de una palabra del título
+static int titulos_trigramas_consulta(const char* palabra, int longitud, int* trigramas) {
+    if (longitud == 1) {
+        trigramas[0] = titulos_trigrama(0, 0, titulos_codigo(palabra[0]));
+        return 1;
+    }
+    if (longitud == 2) {
+        trigramas[0] = titulos_trigrama(0, titulos_codigo(palabra[0]), titulos_codigo(palabra[1]));
+        return 1;
+    }
+    
+    for (int i = 0; i + 2 < longitud; i++) {
+        trigramas[i] = titulos_trigrama(titulos_codigo(palabra[i]),
+                                        titulos_codigo(palabra[i + 1]),
+                                        titulos_codigo(palabra[i + 2]));
+    }
+    return longitud - 2;
+}
+
+// Primera posición de ids con un valor >= id
+static int titulos_posicion(const int* ids, int num, int id) {
+    int bajo = 0;
+    int alto = num;
+    
+    while (bajo < alto) {
+        int medio = (bajo + alto) / 2;
+        if (ids[medio] < id) {
+            bajo = medio + 1;
+        } else {
+            alto = medio;
+        }
+    }
+    
+    return bajo;
+}
+
+// Primer documento con un id de película >= id
+static int titulos_posicion_documento(int id) {
+    int bajo = 0;
+    int alto = g_num_documentos;
+    
+    while (bajo < alto) {
+        int medio = (bajo + alto) / 2;
+        if (g_documentos[medio].pelicula.id < id) {
+            bajo = medio + 1;
+        } else {
+            alto = medio;
+        }
+    }
+    
+    return bajo;
+}
+
+// Compactar las listas en un array nuevo con sitio para al menos minimo ids
+// más al final
+static bool titulos_reorganizar(int minimo) {
+    int capacidad = (g_ids_usados - g_ids_huecos + minimo) * 2;
+    if (capacidad < 1024) {
+        capacidad = 1024;
+    }
+    
+    int* ids = (int*)MEM_ALLOC(capacidad * sizeof(int));
+    if (!ids) {
+        return false;
+    }
+    
+    int usados = 0;
+    for (int i = 0; i < TITULOS_NUM_TRIGRAMAS; i++) {
+        ListaTrigrama* lista = &g_listas[i];
+        
+        // Las listas vacías dejan de ocupar sitio
+        if (lista->num == 0) {
+            lista->inicio = 0;
+            lista->capacidad = 0;
+            continue;
+        }
+        
+        memcpy(ids + usados, g_ids + lista->inicio, lista->num * sizeof(int));
+        lista->inicio = usados;
+        usados += lista->capacidad;
+    }
+    
+    if (g_ids) {
+        MEM_FREE(g_ids);
+    }
+    
+    g_ids = ids;
+    g_ids_capacidad = capacidad;
+    g_ids_usados = usados;
+    g_ids_huecos = 0;
+    return true;
+}
+
+static bool titulos_insertar_id(ListaTrigrama* lista, int id) {
+    // Las películas nuevas tienen el id más alto y van al final
+    int posicion = lista->num;
+    if (posicion > 0 && g_ids[lista->inicio + posicion - 1] >= id) {
+        posicion = titulos_posicion(g_ids + lista->inicio, lista->num, id);
+        if (posicion < lista->num && g_ids[lista->inicio + posicion] == id) {
+            return true;
+        }
+    }
+    
+    if (lista->num == lista->capacidad) {
+        int capacidad = lista->capacidad > 0 ? lista->capacidad * 2 : 4;
+        
+        // Reorganizar puede mover también esta lista
+        if (g_ids_usados + capacidad > g_ids_capacidad && !titulos_reorganizar(capacidad)) {
+            return false;
+        }
+        
+        memcpy(g_ids + g_ids_usados, g_ids + lista->inicio, lista->num * sizeof(int));
+        g_ids_huecos += lista->capacidad;
+        lista->inicio = g_ids_usados;
+        lista->capacidad = capacidad;
+        g_ids_usados += capacidad;
+    }
+    
+    int* ids = g_ids + lista->inicio;
+    memmove(ids + posicion + 1, ids + posicion, (lista->num - posicion) * sizeof(int));
+    ids[posicion] = id;
+    lista->num++;
+    return true;
+}
+
+static void titulos_borrar_id(ListaTrigrama* lista, int id) {
+    int* ids = g_ids + lista->inicio;
+    int posicion = titulos_posicion(ids, lista->num, id);
+    
+    if (posicion < lista->num && ids[posicion] == id) {
+        memmove(ids + posicion, ids + posicion + 1, (lista->num - posicion - 1) * sizeof(int));
+        lista->num--;
+    }
+}
+
+static bool titulos_contiene(const ListaTrigrama* lista, int id) {
+    const int* ids = g_ids + lista->inicio;
+    int posicion = titulos_posicion(ids, lista->num, id);
+    return posicion < lista->num && ids[posicion] == id;
+}
+
+// Quitar una película del índice (con el mutex tomado)
+static void titulos_quitar(int pelicula_id) {
+    int posicion = titulos_posicion_documento(pelicula_id);
+    if (posicion >= g_num_documentos || g_documentos[posicion].pelicula.id != pelicula_id) {
+        return;
+    }
+    
+    int trigramas[TITULOS_MAX_TEXTO];
+    int num_trigramas = titulos_trigramas(g_documentos[posicion].normalizado, trigramas);
+    for (int i = 0; i < num_trigramas; i++) {
+        titulos_borrar_id(&g_listas[trigramas[i]], pelicula_id);
+    }
+    
+    memmove(&g_documentos[posicion], &g_documentos[posicion + 1],
+            (g_num_documentos - posicion - 1) * sizeof(DocumentoTitulo));
+    g_num_documentos--;
+}
+
+// Añadir una película que no está en el índice (con el mutex tomado)
+static bool titulos_anadir(const Pelicula* pelicula) {
+    if (g_num_documentos == g_capacidad_documentos) {
+        int capacidad = g_capacidad_documentos > 0 ? g_capacidad_documentos * 2 : 64;
+        DocumentoTitulo* documentos = (DocumentoTitulo*)MEM_REALLOC(g_documentos,
+                capacidad * sizeof(DocumentoTitulo));
+        if (!documentos) {
+            return false;
+        }
+        
+        g_documentos = documentos;
+        g_capacidad_documentos = capacidad;
+    }
+    
+    int posicion = titulos_posicion_documento(pelicula->id);
+    memmove(&g_documentos[posicion + 1], &g_documentos[posicion],
+            (g_num_documentos - posicion) * sizeof(DocumentoTitulo));
+    g_num_documentos++;
+    
+    DocumentoTitulo* documento = &g_documentos[posicion];
+    documento->pelicula = *pelicula;
+    titulos_normalizar(pelicula->titulo, documento->normalizado, sizeof(documento->normalizado));
+    
+    int trigramas[TITULOS_MAX_TEXTO];
+    int num_trigramas = titulos_trigramas(documento->normalizado, trigramas);
+    for (int i = 0; i < num_trigramas; i++) {
+        if (!titulos_insertar_id(&g_listas[trigramas[i]], pelicula->id)) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+// Liberar el índice (con el mutex tomado)
+static void titulos_descartar() {
+    if (g_listas) {
+        MEM_FREE(g_listas);
+    }
+    if (g_ids) {
+        MEM_FREE(g_ids);
+    }
+    if (g_documentos) {
+        MEM_FREE(g_documentos);
+    }
+    
+    g_listas = NULL;
+    g_ids = NULL;
+    g_ids_usados = g_ids_capacidad = g_ids_huecos = 0;
+    g_documentos = NULL;
+    g_num_documentos = g_capacidad_documentos = 0;
+    g_cargado = false;
+}
+
+// Construir el índice a partir de la base de datos
+static bool titulos_cargar() {
+    Pelicula* peliculas = NULL;
+    int num_peliculas = 0;
+    if (!pelicula_listar(&peliculas, &num_peliculas)) {
+        log_error("No se pudieron obtener las películas para el índice de títulos");
+        return false;
+    }
+    
+    g_listas = (ListaTrigrama*)MEM_ALLOC(TITULOS_NUM_TRIGRAMAS * sizeof(ListaTrigrama));
+    if (!g_listas) {
+        log_error("Error al asignar memoria para el índice de títulos");
+        pelicula_liberar_lista(peliculas, num_peliculas);
+        return false;
+    }
+    memset(g_listas, 0, TITULOS_NUM_TRIGRAMAS * sizeof(ListaTrigrama));
+    
+    for (int i = 0; i < num_peliculas; i++) {
+        if (!titulos_anadir(&peliculas[i])) {
+            log_error("Error al asignar memoria para el índice de títulos");
+            titulos_descartar();
+            pelicula_liberar_lista(peliculas, num_peliculas);
+            return false;
+        }
+    }
+    
+    pelicula_liberar_lista(peliculas, num_peliculas);
+    g_cargado = true;
+    
+    log_info("Índice de títulos cargado (%d películas)", num_peliculas);
+    return true;
+}
+
+// Puntos de un título para la consulta, o 0 si le falta alguna palabra.
+// Cada palabra suma 3 si coincide con una palabra entera del título, 2 si es
+// su principio y 1 si está en medio, y 1 más si es la primera del título
+static int titulos_puntuar(const char* titulo, const char** palabras, const int* longitudes, int num_palabras) {
+    int puntos = 0;
+    
+    for (int i = 0; i < num_palabras; i++) {
+        int mejor = 0;
+        int orden = 0;
+        const char* p = titulo;
+        
+        while (*p) {
+            const char* fin = strchr(p, ' ');
+            int longitud = fin ? (int)(fin - p) : (int)strlen(p);
+            int valor = 0;
+            
+            if (longitud >= longitudes[i] && strncmp(p, palabras[i], longitudes[i]) == 0) {
+                valor = longitud == longitudes[i] ? 3 : 2;
+            } else if (longitudes[i] >= 3) {
+                for (int j = 1; j + longitudes[i] <= longitud; j++) {
+                    if (strncmp(p + j, palabras[i], longitudes[i]) == 0) {
+                        valor = 1;
+                        break;
+                    }
+                }
+            }
+            
+            if (valor > 0 && orden == 0) {
+                valor++;
+            }
+            if (valor > mejor) {
+                mejor = valor;
+            }
+            
+            if (!fin) {
+                break;
+            }
+            p = fin + 1;
+            orden++;
+        }
+        
+        if (mejor == 0) {
+            return 0;
+        }
+        puntos += mejor;
+    }
+    
+    return puntos;
+}
+
+// Más puntos primero; a igualdad, títulos más cortos y en orden alfabético
+static int titulos_comparar_resultados(const void* a, const void* b) {
+    const ResultadoTitulo* x = (const ResultadoTitulo*)a;
+    const ResultadoTitulo* y = (const ResultadoTitulo*)b;
+    
+    if (x->puntos != y->puntos) {
+        return y->puntos - x->puntos;
+    }
+    
+    size_t longitud_x = strlen(x->documento->normalizado);
+    size_t longitud_y = strlen(y->documento->normalizado);
+    if (longitud_x != longitud_y) {
+        return longitud_x < longitud_y ? -1 : 1;
+    }
+    
+    int orden = strcmp(x->documento->normalizado, y->documento->normalizado);
+    if (orden != 0) {
+        return orden;
+    }
+    
+    return x->documento->pelicula.id - y->documento->pelicula.id;
+}
+
+// Buscar películas por título
+bool titulos_buscar(const char* consulta, Pelicula** peliculas, int* num_peliculas) {
+    *peliculas = NULL;
+    *num_peliculas = 0;
+    
+    char texto[TITULOS_MAX_TEXTO];
+    titulos_normalizar(consulta ? consulta : "", texto, sizeof(texto));
+    
+    // Separar las palabras de la consulta
+    const char* palabras[TITULOS_MAX_PALABRAS];
+    int longitudes[TITULOS_MAX_PALABRAS];
+    int num_palabras = 0;
+    
+    for (const char* p = texto; *p && num_palabras < TITULOS_MAX_PALABRAS; ) {
+        const char* fin = strchr(p, ' ');
+        palabras[num_palabras] = p;
+        longitudes[num_palabras] = fin ? (int)(fin - p) : (int)strlen(p);
+        num_palabras++;
+        
+        if (!fin) {
+            break;
+        }
+        p = fin + 1;
+    }
+    
+    int trigramas[TITULOS_MAX_TEXTO];
+    int num_trigramas = 0;
+    for (int i = 0; i < num_palabras; i++) {
+        num_trigramas += titulos_trigramas_consulta(palabras[i], longitudes[i], trigramas + num_trigramas);
+    }
+    
+    pthread_mutex_lock(&g_titulos_mutex);
+    
+    if (!g_cargado && !titulos_cargar()) {
+        pthread_mutex_unlock(&g_titulos_mutex);
+        return false;
+    }
+    
+    // Las candidatas salen de la lista de trigramas más corta; el resto de
+    // listas solo se consultan para ellas
+    const ListaTrigrama* menor = NULL;
+    for (int i = 0; i < num_trigramas; i++) {
+        const ListaTrigrama* lista = &g_listas[trigramas[i]];
+        if (!menor || lista->num < menor->num) {
+            menor = lista;
+        }
+    }
+    
+    int max_candidatas = menor ? menor->num : g_num_documentos;
+    ResultadoTitulo* resultados = NULL;
+    int num_resultados = 0;
+    
+    if (max_candidatas > 0) {
+        resultados = (ResultadoTitulo*)MEM_ALLOC(max_candidatas * sizeof(ResultadoTitulo));
+        if (!resultados) {
+            pthread_mutex_unlock(&g_titulos_mutex);
+            log_error("Error al asignar memoria para la búsqueda de títulos");
+            return false;
+        }
+    }
+    
+    for (int i = 0; i < max_candidatas; i++) {
+        const DocumentoTitulo* documento;
+        
+        if (menor) {
+            int id = g_ids[menor->inicio + i];
+            bool contiene = true;
+            for (int j = 0; j < num_trigramas && contiene; j++) {
+                if (&g_listas[trigramas[j]] != menor) {
+                    contiene = titulos_contiene(&g_listas[trigramas[j]], id);
+                }
+            }
+            if (!contiene) {
+                continue;
+            }
+            
+            documento = &g_documentos[titulos_posicion_documento(id)];
+        } else {
+            documento = &g_documentos[i];
+        }
+        
+        // Los trigramas pueden estar en el título sin formar la palabra
+        int puntos = titulos_puntuar(documento->normalizado, palabras, longitudes, num_palabras);
+        if (puntos == 0 && num_palabras > 0) {
+            continue;
+        }
+        
+        resultados[num_resultados].puntos = puntos;
+        resultados[num_resultados].documento = documento;
+        num_resultados++;
+    }
+    
+    if (num_resultados > 0) {
+        qsort(resultados, num_resultados, sizeof(ResultadoTitulo), titulos_comparar_resultados);
+        
+        *peliculas = (Pelicula*)MEM_ALLOC(num_resultados * sizeof(Pelicula));
+        if (!*peliculas) {
+            MEM_FREE(resultados);
+            pthread_mutex_unlock(&g_titulos_mutex);
+            log_error("Error al asignar memoria para la búsqueda de títulos");
+            return false;
+        }
+        
+        for (int i = 0; i < num_resultados; i++) {
+            (*peliculas)[i] = resultados[i].documento->pelicula;
+        }
+        *num_peliculas = num_resultados;
+    }
+    
+    if (resultados) {
+        MEM_FREE(resultados);
+    }
+    
+    pthread_mutex_unlock(&g_titulos_mutex);
+    return true;
+}
+
+// Añadir o actualizar una película en el índice
+void titulos_guardar_pelicula(const Pelicula* pelicula) {
+    pthread_mutex_lock(&g_titulos_mutex);
+    
+    if (g_cargado) {
+        titulos_quitar(pelicula->id);
+        if (!titulos_anadir(pelicula)) {
+            // Sin memoria; se volverá a cargar de la base de datos
+            titulos_descartar();
+        }
+    }
+    
+    pthread_mutex_unlock(&g_titulos_mutex);
+}
+
+// Quitar una película del índice
+void titulos_quitar_pelicula(int pelicula_id) {
+    pthread_mutex_lock(&g_titulos_mutex);
+    
+    if (g_cargado) {
+        titulos_quitar(pelicula_id);
+    }
+    
+    pthread_mutex_unlock(&g_titulos_mutex);
+}
+
+// Descartar el índice
+void titulos_limpiar() {
+    pthread_mutex_lock(&g_titulos_mutex);
+    titulos_descartar();
+    pthread_mutex_unlock(&g_titulos_mutex);
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#ifndef TITULOS_H
+#define TITULOS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "pelicula.h"
+
+// Índice en memoria de los títulos de las películas para la búsqueda según
+// se escribe. Los títulos se pasan a minúsculas sin tildes y cada palabra se
+// indexa por sus trigramas, con dos espacios delante para poder buscar
+// también por sus primeras letras. La primera búsqueda lo carga de la base
+// de datos; después se mantiene con las altas, cambios y bajas de películas
+
+// Buscar las películas cuyo título contiene todas las palabras de la
+// consulta, como principio de una palabra o, desde tres letras, en cualquier
+// parte de ella. Se devuelven de más a menos relevantes
+bool titulos_buscar(const char* consulta, Pelicula** peliculas, int* num_peliculas);
+
+// Mantener el índice al crear o modificar (guardar) y eliminar películas
+void titulos_guardar_pelicula(const Pelicula* pelicula);
+void titulos_quitar_pelicula(int pelicula_id);
+
+// Descartar el índice
+void titulos_limpiar();
+
+// Pasar un texto UTF-8 a minúsculas sin tildes, dejando solo letras y
+// números y un espacio entre palabras
+void titulos_normalizar(const char* texto, char* destino, size_t tam);
+
+#endif // TITULOS_H
\ No newline at end of file
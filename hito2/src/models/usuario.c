@@ -2,67 +2,27 @@
 #include "../database.h"
 #include "../utils/logger.h"
 #include "../utils/memory.h"
+#include "../utils/result_set.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
-// Función auxiliar para callback de SQLite
-static int usuario_callback(void* data, int argc, char** argv, char** column_names) {
-    Usuario* usuario = (Usuario*)data;
-    
-    for (int i = 0; i < argc; i++) {
-        if (strcmp(column_names[i], "ID") == 0) {
-            usuario->id = atoi(argv[i]);
-        } else if (strcmp(column_names[i], "Nombre") == 0) {
-            strncpy(usuario->nombre, argv[i] ? argv[i] : "", sizeof(usuario->nombre) - 1);
-        } else if (strcmp(column_names[i], "CorreoElectronico") == 0) {
-            strncpy(usuario->correo, argv[i] ? argv[i] : "", sizeof(usuario->correo) - 1);
-        } else if (strcmp(column_names[i], "Contrasena") == 0) {
-            strncpy(usuario->contrasena, argv[i] ? argv[i] : "", sizeof(usuario->contrasena) - 1);
-        } else if (strcmp(column_names[i], "Telefono") == 0) {
-            strncpy(usuario->telefono, argv[i] ? argv[i] : "", sizeof(usuario->telefono) - 1);
-        } else if (strcmp(column_names[i], "TipoUsuario") == 0) {
-            usuario->tipo = usuario_string_a_tipo(argv[i]);
-        }
-    }
-    
-    return 0;
+// Conversión de la columna TipoUsuario
+static int usuario_columna_tipo(const char* texto) {
+    return usuario_string_a_tipo(texto);
 }
 
-// Función callback para listar usuarios
-static int usuarios_listar_callback(void* data, int argc, char** argv, char** column_names) {
-    struct {
-        Usuario* usuarios;
-        int max_usuarios;
-        int* num_usuarios;
-    }* callback_data = (void*)data;
-    
-    if (*callback_data->num_usuarios >= callback_data->max_usuarios) {
-        // No hay más espacio para usuarios
-        return 1;
-    }
-    
-    Usuario* usuario = &callback_data->usuarios[*callback_data->num_usuarios];
-    
-    for (int i = 0; i < argc; i++) {
-        if (strcmp(column_names[i], "ID") == 0) {
-            usuario->id = atoi(argv[i]);
-        } else if (strcmp(column_names[i], "Nombre") == 0) {
-            strncpy(usuario->nombre, argv[i] ? argv[i] : "", sizeof(usuario->nombre) - 1);
-        } else if (strcmp(column_names[i], "CorreoElectronico") == 0) {
-            strncpy(usuario->correo, argv[i] ? argv[i] : "", sizeof(usuario->correo) - 1);
-        } else if (strcmp(column_names[i], "Contrasena") == 0) {
-            strncpy(usuario->contrasena, argv[i] ? argv[i] : "", sizeof(usuario->contrasena) - 1);
-        } else if (strcmp(column_names[i], "Telefono") == 0) {
-            strncpy(usuario->telefono, argv[i] ? argv[i] : "", sizeof(usuario->telefono) - 1);
-        } else if (strcmp(column_names[i], "TipoUsuario") == 0) {
-            usuario->tipo = usuario_string_a_tipo(argv[i]);
-        }
-    }
-    
-    (*callback_data->num_usuarios)++;
-    return 0;
-}
+// Columnas de la tabla Usuarios
+static const DbColumn usuario_columnas[] = {
+    DB_INT_COLUMN("ID", Usuario, id),
+    DB_TEXT_COLUMN("Nombre", Usuario, nombre),
+    DB_TEXT_COLUMN("CorreoElectronico", Usuario, correo),
+    DB_TEXT_COLUMN("Contrasena", Usuario, contrasena),
+    DB_TEXT_COLUMN("Telefono", Usuario, telefono),
+    DB_ENUM_COLUMN("TipoUsuario", Usuario, tipo, usuario_columna_tipo)
+};
+
+static const DbRowMap usuario_fila = DB_ROW_MAP(usuario_columnas);
 
 // Crear un nuevo usuario
 bool usuario_crear(Usuario* usuario) {
@@ -71,14 +31,16 @@ bool usuario_crear(Usuario* usuario) {
         return false;
     }
     
-    char sql[512];
-    snprintf(sql, sizeof(sql),
+    sqlite3_stmt* stmt = db_statement(STMT_USUARIO_CREAR,
             "INSERT INTO Usuarios (Nombre, CorreoElectronico, Contrasena, Telefono, TipoUsuario) "
-            "VALUES ('%s', '%s', '%s', '%s', '%s');",
-            usuario->nombre, usuario->correo, usuario->contrasena, 
-            usuario->telefono, usuario_tipo_a_string(usuario->tipo));
-    
-    if (db_execute(sql)) {
+            "VALUES (?, ?, ?, ?, ?);");
+    db_bind_text(stmt, 1, usuario->nombre);
+    db_bind_text(stmt, 2, usuario->correo);
+    db_bind_text(stmt, 3, usuario->contrasena);
+    db_bind_text(stmt, 4, usuario->telefono);
+    db_bind_text(stmt, 5, usuario_tipo_a_string(usuario->tipo));
+    
+    if (db_statement_execute(stmt)) {
         usuario->id = db_last_insert_id();
         log_info("Usuario creado con ID: %d", usuario->id);
         return true;
@@ -90,20 +52,22 @@ bool usuario_crear(Usuario* usuario) {
 
 // Obtener usuario por ID
 bool usuario_obtener_por_id(int id, Usuario* usuario) {
-    char sql[256];
-    snprintf(sql, sizeof(sql), "SELECT * FROM Usuarios WHERE ID = %d;", id);
+    sqlite3_stmt* stmt = db_statement(STMT_USUARIO_OBTENER_POR_ID,
+            "SELECT * FROM Usuarios WHERE ID = ?;");
+    db_bind_int(stmt, 1, id);
     
     memset(usuario, 0, sizeof(Usuario));
-    return db_query(sql, usuario_callback, usuario);
+    return db_statement_read(stmt, &usuario_fila, usuario);
 }
 
 // Obtener usuario por correo electrónico
 bool usuario_obtener_por_correo(const char* correo, Usuario* usuario) {
-    char sql[256];
-    snprintf(sql, sizeof(sql), "SELECT * FROM Usuarios WHERE CorreoElectronico = '%s';", correo);
+    sqlite3_stmt* stmt = db_statement(STMT_USUARIO_OBTENER_POR_CORREO,
+            "SELECT * FROM Usuarios WHERE CorreoElectronico = ?;");
+    db_bind_text(stmt, 1, correo);
     
     memset(usuario, 0, sizeof(Usuario));
-    return db_query(sql, usuario_callback, usuario);
+    return db_statement_read(stmt, &usuario_fila, usuario);
 }
 
 // Actualizar un usuario existente
@@ -113,16 +77,18 @@ bool usuario_actualizar(Usuario* usuario) {
         return false;
     }
     
-    char sql[512];
-    snprintf(sql, sizeof(sql),
-            "UPDATE Usuarios SET Nombre = '%s', CorreoElectronico = '%s', "
-            "Contrasena = '%s', Telefono = '%s', TipoUsuario = '%s' "
-            "WHERE ID = %d;",
-            usuario->nombre, usuario->correo, usuario->contrasena, 
-            usuario->telefono, usuario_tipo_a_string(usuario->tipo),
-            usuario->id);
+    sqlite3_stmt* stmt = db_statement(STMT_USUARIO_ACTUALIZAR,
+            "UPDATE Usuarios SET Nombre = ?, CorreoElectronico = ?, "
+            "Contrasena = ?, Telefono = ?, TipoUsuario = ? "
+            "WHERE ID = ?;");
+    db_bind_text(stmt, 1, usuario->nombre);
+    db_bind_text(stmt, 2, usuario->correo);
+    db_bind_text(stmt, 3, usuario->contrasena);
+    db_bind_text(stmt, 4, usuario->telefono);
+    db_bind_text(stmt, 5, usuario_tipo_a_string(usuario->tipo));
+    db_bind_int(stmt, 6, usuario->id);
     
-    if (db_execute(sql)) {
+    if (db_statement_execute(stmt)) {
         log_info("Usuario actualizado con ID: %d", usuario->id);
         return true;
     }
@@ -133,10 +99,10 @@ bool usuario_actualizar(Usuario* usuario) {
 
 // Eliminar un usuario
 bool usuario_eliminar(int id) {
-    char sql[256];
-    snprintf(sql, sizeof(sql), "DELETE FROM Usuarios WHERE ID = %d;", id);
+    sqlite3_stmt* stmt = db_statement(STMT_USUARIO_ELIMINAR, "DELETE FROM Usuarios WHERE ID = ?;");
+    db_bind_int(stmt, 1, id);
     
-    if (db_execute(sql)) {
+    if (db_statement_execute(stmt)) {
         log_info("Usuario eliminado con ID: %d", id);
         return true;
     }
@@ -147,58 +113,22 @@ bool usuario_eliminar(int id) {
 
 // Listar todos los usuarios
 bool usuario_listar(Usuario** usuarios, int* num_usuarios) {
-    // Primero, contar cuántos usuarios hay
-    char sql_count[256] = "SELECT COUNT(*) FROM Usuarios;";
-    int count = 0;
-    
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(get_database()->db, sql_count, -1, &stmt, NULL);
-    
-    if (rc != SQLITE_OK) {
-        log_error("Error al preparar la consulta: %s", sqlite3_errmsg(get_database()->db));
-        return false;
-    }
-    
-    rc = sqlite3_step(stmt);
-    
-    if (rc == SQLITE_ROW) {
-        count = sqlite3_column_int(stmt, 0);
-    }
-    
-    sqlite3_finalize(stmt);
-    
-    if (count == 0) {
-        *usuarios = NULL;
-        *num_usuarios = 0;
-        return true;
-    }
-    
-    // Asignar memoria para los usuarios
-    *usuarios = (Usuario*)MEM_ALLOC(count * sizeof(Usuario));
-    if (!*usuarios) {
-        log_error("Error al asignar memoria para la lista de usuarios");
-        return false;
-    }
-    
     // Consultar los usuarios
-    char sql[256] = "SELECT * FROM Usuarios;";
-    
-    struct {
-        Usuario* usuarios;
-        int max_usuarios;
-        int* num_usuarios;
-    } callback_data = {*usuarios, count, num_usuarios};
+    sqlite3_stmt* stmt = db_statement(STMT_USUARIO_LISTAR, "SELECT * FROM Usuarios;");
     
-    *num_usuarios = 0;  // Inicializar el contador
+    ResultSet resultado;
+    result_set_init(&resultado, sizeof(Usuario));
     
-    if (!db_query(sql, usuarios_listar_callback, &callback_data)) {
-        MEM_FREE(*usuarios);
+    if (!db_statement_read_all(stmt, &usuario_fila, &resultado)) {
+        result_set_free(&resultado);
         *usuarios = NULL;
         *num_usuarios = 0;
         log_error("Error al consultar la lista de usuarios");
         return false;
     }
     
+    *usuarios = (Usuario*)result_set_take(&resultado, num_usuarios);
+    
     log_info("Se listaron %d usuarios", *num_usuarios);
     return true;
 }
@@ -226,12 +156,13 @@ bool usuario_cambiar_contrasena(int id, const char* nueva_contrasena) {
         return false;
     }
     
-    char sql[256];
-    snprintf(sql, sizeof(sql), 
-            "UPDATE Usuarios SET Contrasena = '%s' WHERE ID = %d;",
-            nueva_contrasena, id);
+    sqlite3_stmt* stmt = db_statement(STMT_USUARIO_CAMBIAR_CONTRASENA,
+    
+            "UPDATE Usuarios SET Contrasena = ? WHERE ID = ?;");
+    db_bind_text(stmt, 1, nueva_contrasena);
+    db_bind_int(stmt, 2, id);
     
-    if (db_execute(sql)) {
+    if (db_statement_execute(stmt)) {
         log_info("Contraseña actualizada para el usuario con ID: %d", id);
         return true;
     }
@@ -1,74 +1,125 @@
 #include "venta.h"
 #include "usuario.h"
+#include "ocupacion.h"
 #include "../database.h"
 #include "../utils/logger.h"
 #include "../utils/memory.h"
+#include "../utils/result_set.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <time.h>
 
-// Función auxiliar para callback de SQLite
-static int venta_callback(void* data, int argc, char** argv, char** column_names) {
-    Venta* venta = (Venta*)data;
-    
-    for (int i = 0; i < argc; i++) {
-        if (strcmp(column_names[i], "ID") == 0) {
-            venta->id = atoi(argv[i]);
-        } else if (strcmp(column_names[i], "Usuario_ID") == 0) {
-            venta->usuario_id = atoi(argv[i]);
-        } else if (strcmp(column_names[i], "Fecha") == 0) {
-            strncpy(venta->fecha, argv[i] ? argv[i] : "", sizeof(venta->fecha) - 1);
-        } else if (strcmp(column_names[i], "Descuento") == 0) {
-            venta->descuento = atof(argv[i]);
-        } else if (strcmp(column_names[i], "PrecioTotal") == 0) {
-            venta->precio_total = atof(argv[i]);
-        }
+// Columnas de la tabla Venta
+static const DbColumn venta_columnas[] = {
+    DB_INT_COLUMN("ID", Venta, id),
+    DB_INT_COLUMN("Usuario_ID", Venta, usuario_id),
+    DB_TEXT_COLUMN("Fecha", Venta, fecha),
+    DB_DOUBLE_COLUMN("Descuento", Venta, descuento),
+    DB_DOUBLE_COLUMN("PrecioTotal", Venta, precio_total)
+};
+
+static const DbRowMap venta_fila = DB_ROW_MAP(venta_columnas);
+
+// Los billetes eliminados dentro de una transacción que se revierte ya habían
+// liberado su asiento en el mapa de ocupación; se descarta para recargarlo
+static void venta_descartar_ocupacion(Billete* billetes, int num_billetes) {
+    for (int i = 0; i < num_billetes; i++) {
+        ocupacion_invalidar_sesion(billetes[i].sesion_id);
+    }
+}
+
+// Devolver al inventario los asientos que reservó una venta revertida; los
+// de billetes que ya existían antes de la venta siguen ocupados
+static void venta_liberar_reservas(Billete* billetes, const bool* creados, int num_billetes) {
+    if (!creados) {
+        return;
     }
     
-    return 0;
+    for (int i = 0; i < num_billetes; i++) {
+        if (creados[i]) {
+            ocupacion_liberar_asientos(billetes[i].sesion_id, &billetes[i].asiento_id, 1);
+        }
+    }
 }
 
-// Función callback para listar ventas
-static int ventas_listar_callback(void* data, int argc, char** argv, char** column_names) {
-    struct {
-        Venta* ventas;
-        int max_ventas;
-        int* num_ventas;
-    }* callback_data = (void*)data;
-    
-    if (*callback_data->num_ventas >= callback_data->max_ventas) {
-        // No hay más espacio para ventas
-        return 1;
+// Reservar en el inventario los asientos de los billetes nuevos con una sola
+// operación por sesión, que comprueba a la vez que la sesión existe, que los
+// asientos son de su sala, que no se repiten y que están libres. Marca en
+// creados los billetes reservados; si falla no deja ninguno reservado
+static bool venta_reservar_asientos(Billete* billetes, int num_billetes, bool* creados) {
+    for (int i = 0; i < num_billetes; i++) {
+        if (billetes[i].id <= 0 &&
+            (billetes[i].sesion_id <= 0 || billetes[i].asiento_id <= 0 || billetes[i].precio < 0)) {
+            log_error("Datos del billete %d inválidos", i);
+            return false;
+        }
+    }
+    
+    int* asiento_ids = (int*)MEM_ALLOC(num_billetes * sizeof(int));
+    if (!asiento_ids) {
+        log_error("Error al asignar memoria para crear la venta");
+        return false;
     }
     
-    Venta* venta = &callback_data->ventas[*callback_data->num_ventas];
-    
-    for (int i = 0; i < argc; i++) {
-        if (strcmp(column_names[i], "ID") == 0) {
-            venta->id = atoi(argv[i]);
-        } else if (strcmp(column_names[i], "Usuario_ID") == 0) {
-            venta->usuario_id = atoi(argv[i]);
-        } else if (strcmp(column_names[i], "Fecha") == 0) {
-            strncpy(venta->fecha, argv[i] ? argv[i] : "", sizeof(venta->fecha) - 1);
-        } else if (strcmp(column_names[i], "Descuento") == 0) {
-            venta->descuento = atof(argv[i]);
-        } else if (strcmp(column_names[i], "PrecioTotal") == 0) {
-            venta->precio_total = atof(argv[i]);
+    for (int i = 0; i < num_billetes; i++) {
+        if (billetes[i].id > 0 || creados[i]) {
+            continue;
+        }
+        
+        // Asientos nuevos de la misma sesión que el billete i
+        int sesion_id = billetes[i].sesion_id;
+        int num_asientos = 0;
+        for (int j = i; j < num_billetes; j++) {
+            if (billetes[j].id <= 0 && billetes[j].sesion_id == sesion_id) {
+                asiento_ids[num_asientos++] = billetes[j].asiento_id;
+            }
+        }
+        
+        if (!ocupacion_reservar_asientos(sesion_id, asiento_ids, num_asientos)) {
+            log_error("Los asientos de la sesión %d no están disponibles", sesion_id);
+            venta_liberar_reservas(billetes, creados, num_billetes);
+            MEM_FREE(asiento_ids);
+            return false;
+        }
+        
+        for (int j = i; j < num_billetes; j++) {
+            if (billetes[j].id <= 0 && billetes[j].sesion_id == sesion_id) {
+                creados[j] = true;
+            }
         }
     }
     
-    (*callback_data->num_ventas)++;
-    return 0;
+    MEM_FREE(asiento_ids);
+    return true;
 }
 
-// Crear una nueva venta con sus billetes
-bool venta_crear(Venta* venta, Billete* billetes, int num_billetes) {
-    if (!venta_validar(venta) || !billetes || num_billetes <= 0) {
-        log_error("Datos de venta inválidos");
-        return false;
+// Asociar los billetes a la venta con un INSERT por cada DB_BATCH_ROWS
+static bool venta_asociar_billetes(int venta_id, Billete* billetes, int num_billetes) {
+    for (int inicio = 0; inicio < num_billetes; inicio += DB_BATCH_ROWS) {
+        sqlite3_stmt* stmt = db_statement(STMT_VENTA_BILLETE_ASOCIAR,
+                "INSERT INTO Venta_Billetes (Venta_ID, Billete_ID) "
+                "SELECT ?, column1 FROM (VALUES " DB_BATCH("(?)") ") "
+                "WHERE column1 IS NOT NULL;");
+        db_bind_int(stmt, 1, venta_id);
+        
+        for (int i = inicio; i < num_billetes && i < inicio + DB_BATCH_ROWS; i++) {
+            db_bind_int(stmt, 2 + i - inicio, billetes[i].id);
+        }
+        
+        if (!db_statement_execute(stmt)) {
+            log_error("Error al asociar los billetes a la venta %d", venta_id);
+            return false;
+        }
     }
     
+    return true;
+}
+
+// Insertar una venta y sus billetes en una transacción. Los asientos de los
+// billetes nuevos ya están reservados en el inventario; con creados, los
+// marcados se liberan si la venta se revierte
+static bool venta_insertar(Venta* venta, Billete* billetes, int num_billetes, bool* creados) {
     // Calcular el precio total
     venta->precio_total = venta_calcular_total(billetes, num_billetes, venta->descuento);
     
@@ -86,13 +137,15 @@ bool venta_crear(Venta* venta, Billete* billetes, int num_billetes) {
     }
     
     // Insertar la venta
-    char sql[512];
-    snprintf(sql, sizeof(sql),
+    sqlite3_stmt* stmt = db_statement(STMT_VENTA_CREAR,
             "INSERT INTO Venta (Usuario_ID, Fecha, Descuento, PrecioTotal) "
-            "VALUES (%d, '%s', %.2f, %.2f);",
-            venta->usuario_id, venta->fecha, venta->descuento, venta->precio_total);
+            "VALUES (?, ?, ?, ?);");
+    db_bind_int(stmt, 1, venta->usuario_id);
+    db_bind_text(stmt, 2, venta->fecha);
+    db_bind_double(stmt, 3, venta->descuento);
+    db_bind_double(stmt, 4, venta->precio_total);
     
-    if (!db_execute(sql)) {
+    if (!db_statement_execute(stmt)) {
         log_error("Error al crear la venta");
         db_rollback_transaction();
         return false;
@@ -100,34 +153,20 @@ bool venta_crear(Venta* venta, Billete* billetes, int num_billetes) {
     
     venta->id = db_last_insert_id();
     
-    // Insertar los billetes
-    for (int i = 0; i < num_billetes; i++) {
-        // Crear el billete si no existe
-        if (billetes[i].id <= 0) {
-            if (!billete_crear(&billetes[i])) {
-                log_error("Error al crear el billete %d", i);
-                db_rollback_transaction();
-                return false;
-            }
-        }
-        
-        // Asociar el billete a la venta
-        snprintf(sql, sizeof(sql),
-                "INSERT INTO Venta_Billetes (Venta_ID, Billete_ID) "
-                "VALUES (%d, %d);",
-                venta->id, billetes[i].id);
-        
-        if (!db_execute(sql)) {
-            log_error("Error al asociar el billete %d a la venta %d", billetes[i].id, venta->id);
-            db_rollback_transaction();
-            return false;
-        }
+    // Crear los billetes nuevos y asociarlos todos a la venta, con
+    // sentencias de varias filas
+    if (!billete_crear_lote(billetes, num_billetes) ||
+        !venta_asociar_billetes(venta->id, billetes, num_billetes)) {
+        db_rollback_transaction();
+        venta_liberar_reservas(billetes, creados, num_billetes);
+        return false;
     }
     
     // Confirmar transacción
     if (!db_commit_transaction()) {
         log_error("Error al confirmar transacción para crear venta");
         db_rollback_transaction();
+        venta_liberar_reservas(billetes, creados, num_billetes);
         return false;
     }
     
@@ -135,13 +174,46 @@ bool venta_crear(Venta* venta, Billete* billetes, int num_billetes) {
     return true;
 }
 
+// Crear una nueva venta con sus billetes
+bool venta_crear(Venta* venta, Billete* billetes, int num_billetes) {
+    if (!venta_validar(venta) || !billetes || num_billetes <= 0 || num_billetes > VENTA_MAX_BILLETES) {
+        log_error("Datos de venta inválidos");
+        return false;
+    }
+    
+    // Billetes que crea esta venta, para liberar sus asientos si se revierte
+    bool* creados = (bool*)MEM_ALLOC(num_billetes * sizeof(bool));
+    if (!creados) {
+        log_error("Error al asignar memoria para crear la venta");
+        return false;
+    }
+    memset(creados, 0, num_billetes * sizeof(bool));
+    
+    bool resultado = venta_reservar_asientos(billetes, num_billetes, creados) &&
+                     venta_insertar(venta, billetes, num_billetes, creados);
+    
+    MEM_FREE(creados);
+    return resultado;
+}
+
+// Crear una venta con los asientos ya reservados
+bool venta_crear_reservada(Venta* venta, Billete* billetes, int num_billetes) {
+    if (!venta_validar(venta) || !billetes || num_billetes <= 0) {
+        log_error("Datos de venta inválidos");
+        return false;
+    }
+    
+    return venta_insertar(venta, billetes, num_billetes, NULL);
+}
+
 // Obtener venta por ID
 bool venta_obtener_por_id(int id, Venta* venta) {
-    char sql[256];
-    snprintf(sql, sizeof(sql), "SELECT * FROM Venta WHERE ID = %d;", id);
+    sqlite3_stmt* stmt = db_statement(STMT_VENTA_OBTENER_POR_ID,
+            "SELECT * FROM Venta WHERE ID = ?;");
+    db_bind_int(stmt, 1, id);
     
     memset(venta, 0, sizeof(Venta));
-    return db_query(sql, venta_callback, venta);
+    return db_statement_read(stmt, &venta_fila, venta);
 }
 
 // Eliminar una venta
@@ -166,6 +238,7 @@ bool venta_eliminar(int id) {
     for (int i = 0; i < num_billetes; i++) {
         if (!billete_eliminar(billetes[i].id)) {
             log_error("Error al eliminar el billete %d", billetes[i].id);
+            venta_descartar_ocupacion(billetes, num_billetes);
             db_rollback_transaction();
             billete_liberar_lista(billetes, num_billetes);
             return false;
@@ -173,21 +246,25 @@ bool venta_eliminar(int id) {
     }
     
     // Eliminar las relaciones en la tabla intermedia
-    char sql[256];
-    snprintf(sql, sizeof(sql), "DELETE FROM Venta_Billetes WHERE Venta_ID = %d;", id);
+    sqlite3_stmt* stmt = db_statement(STMT_VENTA_BILLETE_ELIMINAR,
+            "DELETE FROM Venta_Billetes WHERE Venta_ID = ?;");
+    db_bind_int(stmt, 1, id);
     
-    if (!db_execute(sql)) {
+    if (!db_statement_execute(stmt)) {
         log_error("Error al eliminar las relaciones de venta-billetes");
+        venta_descartar_ocupacion(billetes, num_billetes);
         db_rollback_transaction();
         billete_liberar_lista(billetes, num_billetes);
         return false;
     }
     
     // Eliminar la venta
-    snprintf(sql, sizeof(sql), "DELETE FROM Venta WHERE ID = %d;", id);
+    stmt = db_statement(STMT_VENTA_ELIMINAR, "DELETE FROM Venta WHERE ID = ?;");
+    db_bind_int(stmt, 1, id);
     
-    if (!db_execute(sql)) {
+    if (!db_statement_execute(stmt)) {
         log_error("Error al eliminar venta con ID: %d", id);
+        venta_descartar_ocupacion(billetes, num_billetes);
         db_rollback_transaction();
         billete_liberar_lista(billetes, num_billetes);
         return false;
@@ -196,6 +273,7 @@ bool venta_eliminar(int id) {
     // Confirmar transacción
     if (!db_commit_transaction()) {
         log_error("Error al confirmar transacción para eliminar venta");
+        venta_descartar_ocupacion(billetes, num_billetes);
         db_rollback_transaction();
         billete_liberar_lista(billetes, num_billetes);
         return false;
@@ -208,62 +286,24 @@ bool venta_eliminar(int id) {
 
 // Listar ventas por usuario
 bool venta_listar_por_usuario(int usuario_id, Venta** ventas, int* num_ventas) {
-    char sql_count[256];
-    snprintf(sql_count, sizeof(sql_count), 
-            "SELECT COUNT(*) FROM Venta WHERE Usuario_ID = %d;", usuario_id);
-    
-    int count = 0;
-    
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(get_database()->db, sql_count, -1, &stmt, NULL);
-    
-    if (rc != SQLITE_OK) {
-        log_error("Error al preparar la consulta: %s", sqlite3_errmsg(get_database()->db));
-        return false;
-    }
-    
-    rc = sqlite3_step(stmt);
-    
-    if (rc == SQLITE_ROW) {
-        count = sqlite3_column_int(stmt, 0);
-    }
-    
-    sqlite3_finalize(stmt);
-    
-    if (count == 0) {
-        *ventas = NULL;
-        *num_ventas = 0;
-        return true;
-    }
-    
-    // Asignar memoria para las ventas
-    *ventas = (Venta*)MEM_ALLOC(count * sizeof(Venta));
-    if (!*ventas) {
-        log_error("Error al asignar memoria para la lista de ventas");
-        return false;
-    }
-    
     // Consultar las ventas
-    char sql[256];
-    snprintf(sql, sizeof(sql), 
-            "SELECT * FROM Venta WHERE Usuario_ID = %d ORDER BY Fecha DESC;", usuario_id);
-    
-    struct {
-        Venta* ventas;
-        int max_ventas;
-        int* num_ventas;
-    } callback_data = {*ventas, count, num_ventas};
+    sqlite3_stmt* stmt = db_statement(STMT_VENTA_LISTAR_POR_USUARIO,
+            "SELECT * FROM Venta WHERE Usuario_ID = ? ORDER BY Fecha DESC;");
+    db_bind_int(stmt, 1, usuario_id);
     
-    *num_ventas = 0;  // Inicializar el contador
+    ResultSet resultado;
+    result_set_init(&resultado, sizeof(Venta));
     
-    if (!db_query(sql, ventas_listar_callback, &callback_data)) {
-        MEM_FREE(*ventas);
+    if (!db_statement_read_all(stmt, &venta_fila, &resultado)) {
+        result_set_free(&resultado);
         *ventas = NULL;
         *num_ventas = 0;
         log_error("Error al consultar la lista de ventas");
         return false;
     }
     
+    *ventas = (Venta*)result_set_take(&resultado, num_ventas);
+    
     log_info("Se listaron %d ventas para el usuario %d", *num_ventas, usuario_id);
     return true;
 }
@@ -297,78 +337,7 @@ bool venta_validar(Venta* venta) {
 
 // Obtener los billetes de una venta
 bool venta_obtener_billetes(int venta_id, Billete** billetes, int* num_billetes) {
-    char sql_count[256];
-    snprintf(sql_count, sizeof(sql_count), 
-            "SELECT COUNT(*) FROM Venta_Billetes WHERE Venta_ID = %d;", venta_id);
-    
-    int count = 0;
-    
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(get_database()->db, sql_count, -1, &stmt, NULL);
-    
-    if (rc != SQLITE_OK) {
-        log_error("Error al preparar la consulta: %s", sqlite3_errmsg(get_database()->db));
-        return false;
-    }
-    
-    rc = sqlite3_step(stmt);
-    
-    if (rc == SQLITE_ROW) {
-        count = sqlite3_column_int(stmt, 0);
-    }
-    
-    sqlite3_finalize(stmt);
-    
-    if (count == 0) {
-        *billetes = NULL;
-        *num_billetes = 0;
-        return true;
-    }
-    
-    // Asignar memoria para los billetes
-    *billetes = (Billete*)MEM_ALLOC(count * sizeof(Billete));
-    if (!*billetes) {
-        log_error("Error al asignar memoria para la lista de billetes");
-        return false;
-    }
-    
-    // Consultar los IDs de los billetes
-    char sql[512];
-    snprintf(sql, sizeof(sql), 
-            "SELECT Billete_ID FROM Venta_Billetes WHERE Venta_ID = %d;", venta_id);
-    
-    sqlite3_stmt *stmt_ids;
-    rc = sqlite3_prepare_v2(get_database()->db, sql, -1, &stmt_ids, NULL);
-    
-    if (rc != SQLITE_OK) {
-        log_error("Error al preparar la consulta: %s", sqlite3_errmsg(get_database()->db));
-        MEM_FREE(*billetes);
-        *billetes = NULL;
-        *num_billetes = 0;
-        return false;
-    }
-    
-    int i = 0;
-    while (sqlite3_step(stmt_ids) == SQLITE_ROW && i < count) {
-        int billete_id = sqlite3_column_int(stmt_ids, 0);
-        
-        // Obtener el billete
-        if (!billete_obtener_por_id(billete_id, &(*billetes)[i])) {
-            log_error("Error al obtener el billete %d", billete_id);
-            sqlite3_finalize(stmt_ids);
-            MEM_FREE(*billetes);
-            *billetes = NULL;
-            *num_billetes = 0;
-            return false;
-        }
-        
-        i++;
-    }
-    
-    sqlite3_finalize(stmt_ids);
-    *num_billetes = i;
-    
-    return true;
+    return billete_listar_por_venta(venta_id, billetes, num_billetes);
 }
 
 // Calcular el total de una venta
@@ -4,6 +4,10 @@
 #include <stdbool.h>
 #include "billete.h"
 
+// Billetes que se aceptan en una venta. Es también el máximo de asientos que
+// el inventario reserva de una vez en una sesión
+#define VENTA_MAX_BILLETES 256
+
 // Estructura de venta
 typedef struct {
     int id;
@@ -19,6 +23,11 @@ bool venta_obtener_por_id(int id, Venta* venta);
 bool venta_eliminar(int id);
 bool venta_listar_por_usuario(int usuario_id, Venta** ventas, int* num_ventas);
 
+// Crear una venta cuyos asientos ya están reservados en el inventario (los de
+// una retención): sus billetes no se vuelven a validar ni a comprobar. Si
+// falla, los asientos siguen reservados
+bool venta_crear_reservada(Venta* venta, Billete* billetes, int num_billetes);
+
 // Funciones adicionales
 bool venta_validar(Venta* venta);
 bool venta_obtener_billetes(int venta_id, Billete** billetes, int* num_billetes);
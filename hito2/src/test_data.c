@@ -173,27 +173,30 @@ static bool crear_salas_prueba() {
 static bool crear_sesiones_prueba() {
     log_info("Creando sesiones de prueba...");
     
-    // Sesión 1: El Padrino en Sala 1 (hoy a las 16:00)
-    Sesion sesion1 = {0};
-    sesion1.pelicula_id = 1;
-    sesion1.sala_id = 1;
-    
+    // Medianoche de hoy en segundos desde la época
     time_t ahora = time(NULL);
     struct tm* tm_hoy = localtime(&ahora);
-    
-    // Configurar para hoy a las 16:00
-    tm_hoy->tm_hour = 16;
+    tm_hoy->tm_hour = 0;
     tm_hoy->tm_min = 0;
     tm_hoy->tm_sec = 0;
     
-    sesion_convertir_time_a_str(tm_hoy, sesion1.hora_inicio, sizeof(sesion1.hora_inicio));
+    char texto_hoy[20];
+    int64_t hoy;
+    sesion_convertir_time_a_str(tm_hoy, texto_hoy, sizeof(texto_hoy));
+    if (!sesion_convertir_str_a_epoch(texto_hoy, &hoy)) {
+        log_error("No se pudo calcular la fecha de hoy");
+        return false;
+    }
     
-    // Calcular hora de fin (duración película + 15 min)
-    time_t tiempo_inicio = mktime(tm_hoy);
-    time_t tiempo_fin = tiempo_inicio + (175 + 15) * 60; // El Padrino: 175 min + 15 min limpieza
-    struct tm* tm_fin = localtime(&tiempo_fin);
+    const int64_t hora = 3600;
+    const int64_t dia = 24 * hora;
     
-    sesion_convertir_time_a_str(tm_fin, sesion1.hora_fin, sizeof(sesion1.hora_fin));
+    // Sesión 1: El Padrino en Sala 1 (hoy a las 16:00)
+    Sesion sesion1 = {0};
+    sesion1.pelicula_id = 1;
+    sesion1.sala_id = 1;
+    sesion1.inicio = hoy + 16 * hora;
+    sesion1.fin = sesion1.inicio + (175 + 15) * 60; // El Padrino: 175 min + 15 min limpieza
     
     if (!sesion_crear(&sesion1)) {
         log_error("No se pudo crear sesion1");
@@ -204,20 +207,8 @@ static bool crear_sesiones_prueba() {
     Sesion sesion2 = {0};
     sesion2.pelicula_id = 2;
     sesion2.sala_id = 2;
-    
-    // Configurar para hoy a las 18:00
-    tm_hoy->tm_hour = 18;
-    tm_hoy->tm_min = 0;
-    tm_hoy->tm_sec = 0;
-    
-    sesion_convertir_time_a_str(tm_hoy, sesion2.hora_inicio, sizeof(sesion2.hora_inicio));
-    
-    // Calcular hora de fin
-    tiempo_inicio = mktime(tm_hoy);
-    tiempo_fin = tiempo_inicio + (178 + 15) * 60; // El Señor de los Anillos: 178 min + 15 min limpieza
-    tm_fin = localtime(&tiempo_fin);
-    
-    sesion_convertir_time_a_str(tm_fin, sesion2.hora_fin, sizeof(sesion2.hora_fin));
+    sesion2.inicio = hoy + 18 * hora;
+    sesion2.fin = sesion2.inicio + (178 + 15) * 60; // El Señor de los Anillos: 178 min + 15 min limpieza
     
     if (!sesion_crear(&sesion2)) {
         log_error("No se pudo crear sesion2");
@@ -228,20 +219,8 @@ static bool crear_sesiones_prueba() {
     Sesion sesion3 = {0};
     sesion3.pelicula_id = 3;
     sesion3.sala_id = 3;
-    
-    // Configurar para hoy a las 20:00
-    tm_hoy->tm_hour = 20;
-    tm_hoy->tm_min = 0;
-    tm_hoy->tm_sec = 0;
-    
-    sesion_convertir_time_a_str(tm_hoy, sesion3.hora_inicio, sizeof(sesion3.hora_inicio));
-    
-    // Calcular hora de fin
-    tiempo_inicio = mktime(tm_hoy);
-    tiempo_fin = tiempo_inicio + (136 + 15) * 60; // Matrix: 136 min + 15 min limpieza
-    tm_fin = localtime(&tiempo_fin);
-    
-    sesion_convertir_time_a_str(tm_fin, sesion3.hora_fin, sizeof(sesion3.hora_fin));
+    sesion3.inicio = hoy + 20 * hora;
+    sesion3.fin = sesion3.inicio + (136 + 15) * 60; // Matrix: 136 min + 15 min limpieza
     
     if (!sesion_crear(&sesion3)) {
         log_error("No se pudo crear sesion3");
@@ -252,21 +231,8 @@ static bool crear_sesiones_prueba() {
     Sesion sesion4 = {0};
     sesion4.pelicula_id = 4;
     sesion4.sala_id = 1;
-    
-    // Configurar para mañana a las 17:00
-    tm_hoy->tm_mday += 1; // Día siguiente
-    tm_hoy->tm_hour = 17;
-    tm_hoy->tm_min = 0;
-    tm_hoy->tm_sec = 0;
-    
-    sesion_convertir_time_a_str(tm_hoy, sesion4.hora_inicio, sizeof(sesion4.hora_inicio));
-    
-    // Calcular hora de fin
-    tiempo_inicio = mktime(tm_hoy);
-    tiempo_fin = tiempo_inicio + (195 + 15) * 60; // Titanic: 195 min + 15 min limpieza
-    tm_fin = localtime(&tiempo_fin);
-    
-    sesion_convertir_time_a_str(tm_fin, sesion4.hora_fin, sizeof(sesion4.hora_fin));
+    sesion4.inicio = hoy + dia + 17 * hora;
+    sesion4.fin = sesion4.inicio + (195 + 15) * 60; // Titanic: 195 min + 15 min limpieza
     
     if (!sesion_crear(&sesion4)) {
         log_error("No se pudo crear sesion4");
@@ -277,20 +243,8 @@ static bool crear_sesiones_prueba() {
     Sesion sesion5 = {0};
     sesion5.pelicula_id = 5;
     sesion5.sala_id = 2;
-    
-    // Configurar para mañana a las 19:00
-    tm_hoy->tm_hour = 19;
-    tm_hoy->tm_min = 0;
-    tm_hoy->tm_sec = 0;
-    
-    sesion_convertir_time_a_str(tm_hoy, sesion5.hora_inicio, sizeof(sesion5.hora_inicio));
-    
-    // Calcular hora de fin
-    tiempo_inicio = mktime(tm_hoy);
-    tiempo_fin = tiempo_inicio + (121 + 15) * 60; // Star Wars: 121 min + 15 min limpieza
-    tm_fin = localtime(&tiempo_fin);
-    
-    sesion_convertir_time_a_str(tm_fin, sesion5.hora_fin, sizeof(sesion5.hora_fin));
+    sesion5.inicio = hoy + dia + 19 * hora;
+    sesion5.fin = sesion5.inicio + (121 + 15) * 60; // Star Wars: 121 min + 15 min limpieza
     
     if (!sesion_crear(&sesion5)) {
         log_error("No se pudo crear sesion5");
@@ -4,7 +4,44 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <time.h>
+#include <errno.h>
+#include <sched.h>
+#include <pthread.h>
+
+// Mensajes que caben en el búfer (potencia de 2)
+#define LOG_RING_SLOTS 4096
+
+// Longitud máxima de un mensaje; los más largos se recortan
+#define LOG_MAX_MESSAGE 488
+
+// Bytes que acumula el escritor antes de cada escritura en el archivo
+#define LOG_BATCH_BYTES 65536
+
+// Espera máxima del escritor entre dos vaciados del búfer
+#define LOG_FLUSH_MS 100
+
+// Casilla del búfer. sequence dice de quién es: vale la posición de la
+// casilla cuando está libre para esa vuelta y posición + 1 cuando ya tiene el
+// mensaje, que el escritor puede sacar
+typedef struct {
+    uint64_t sequence;
+    time_t time;
+    LogLevel level;
+    int length;
+    char message[LOG_MAX_MESSAGE];
+} LogSlot;
+
+static LogSlot log_ring[LOG_RING_SLOTS];
+
+// Siguiente posición que reservan los hilos que registran y siguiente que
+// escribe el escritor. Van en líneas de caché distintas para no competir
+static uint64_t log_head __attribute__((aligned(64))) = 0;
+static uint64_t log_tail __attribute__((aligned(64))) = 0;
+
+// Mensajes descartados con el búfer lleno desde el último aviso
+static uint64_t log_dropped = 0;
 
 // Archivo de log
 static FILE* log_file = NULL;
@@ -12,11 +49,124 @@ static FILE* log_file = NULL;
 // Nivel mínimo de log
 static LogLevel min_log_level = LOG_INFO;
 
+// Política con el búfer lleno
+static LogOverflow log_overflow = LOG_OVERFLOW_DROP;
+
+// Se aceptan mensajes mientras el escritor está en marcha
+static bool log_active = false;
+
+// Hilo escritor
+static pthread_t log_thread;
+static bool log_thread_stop = false;
+static pthread_mutex_t log_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t log_wakeup = PTHREAD_COND_INITIALIZER;
+
+// Lote que escribe el hilo escritor, y la hora formateada del último segundo
+// que ha escrito: solo se vuelve a formatear cuando cambia el segundo
+static char log_batch[LOG_BATCH_BYTES];
+static size_t log_batch_used = 0;
+static time_t log_batch_second = (time_t)-1;
+static char log_batch_time[20];
+
+// Escribir el lote acumulado en el archivo
+static void log_batch_flush() {
+    if (log_batch_used > 0) {
+        fwrite(log_batch, 1, log_batch_used, log_file);
+        fflush(log_file);
+        log_batch_used = 0;
+    }
+}
+
+// Añadir una línea al lote, escribiendo antes el lote si no cabe
+static void log_batch_add(time_t when, LogLevel level, const char* message, int length) {
+    if (when != log_batch_second) {
+        // localtime_r: los hilos de las peticiones también usan localtime
+        struct tm tm_info;
+        localtime_r(&when, &tm_info);
+        strftime(log_batch_time, sizeof(log_batch_time), "%Y-%m-%d %H:%M:%S", &tm_info);
+        log_batch_second = when;
+    }
+    
+    // "[hora] [NIVEL] mensaje\n"
+    const char* level_str = log_level_to_string(level);
+    size_t needed = strlen(log_batch_time) + strlen(level_str) + (size_t)length + 7;
+    if (log_batch_used + needed > sizeof(log_batch)) {
+        log_batch_flush();
+    }
+    
+    log_batch_used += (size_t)snprintf(log_batch + log_batch_used, sizeof(log_batch) - log_batch_used,
+                                       "[%s] [%s] %.*s\n", log_batch_time, level_str, length, message);
+}
+
+// Sacar del búfer todos los mensajes publicados y escribirlos
+static void log_drain() {
+    for (;;) {
+        LogSlot* slot = &log_ring[log_tail & (LOG_RING_SLOTS - 1)];
+        if (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != log_tail + 1) {
+            break;
+        }
+        
+        log_batch_add(slot->time, slot->level, slot->message, slot->length);
+        
+        // Devolver la casilla para la siguiente vuelta
+        __atomic_store_n(&slot->sequence, log_tail + LOG_RING_SLOTS, __ATOMIC_RELEASE);
+        __atomic_store_n(&log_tail, log_tail + 1, __ATOMIC_RELEASE);
+    }
+    
+    uint64_t dropped = __atomic_exchange_n(&log_dropped, 0, __ATOMIC_RELAXED);
+    if (dropped > 0) {
+        char aviso[96];
+        int length = snprintf(aviso, sizeof(aviso),
+                              "Se descartaron %llu mensajes de log con el búfer lleno",
+                              (unsigned long long)dropped);
+        log_batch_add(time(NULL), LOG_WARNING, aviso, length);
+    }
+    
+    log_batch_flush();
+}
+
+static void* log_thread_main(void* arg) {
+    (void)arg;
+    
+    pthread_mutex_lock(&log_mutex);
+    
+    while (!log_thread_stop) {
+        pthread_mutex_unlock(&log_mutex);
+        log_drain();
+        pthread_mutex_lock(&log_mutex);
+        
+        if (log_thread_stop) {
+            break;
+        }
+        
+        struct timespec limite;
+        clock_gettime(CLOCK_REALTIME, &limite);
+        limite.tv_nsec += LOG_FLUSH_MS * 1000000L;
+        if (limite.tv_nsec >= 1000000000L) {
+            limite.tv_sec += 1;
+            limite.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&log_wakeup, &log_mutex, &limite);
+    }
+    
+    pthread_mutex_unlock(&log_mutex);
+    
+    // Lo que quede pendiente al cerrar
+    log_drain();
+    return NULL;
+}
+
+// Despertar al escritor. No toma el mutex: si el aviso llega mientras el
+// escritor está vaciando el búfer, lo verá en la siguiente espera
+static void log_wake_writer() {
+    pthread_cond_signal(&log_wakeup);
+}
+
 // Inicializar el sistema de logging
 bool log_init(const char* log_path, LogLevel min_level) {
     // Cerrar el archivo si ya está abierto
     if (log_file) {
-        fclose(log_file);
+        log_close();
     }
     
     // Abrir el archivo de log en modo append
@@ -28,6 +178,26 @@ bool log_init(const char* log_path, LogLevel min_level) {
     
     min_log_level = min_level;
     
+    // Búfer vacío: cada casilla espera su posición de la primera vuelta
+    for (uint64_t i = 0; i < LOG_RING_SLOTS; i++) {
+        log_ring[i].sequence = i;
+    }
+    log_head = 0;
+    log_tail = 0;
+    log_dropped = 0;
+    log_batch_used = 0;
+    log_batch_second = (time_t)-1;
+    
+    log_thread_stop = false;
+    if (pthread_create(&log_thread, NULL, log_thread_main, NULL) != 0) {
+        fprintf(stderr, "Error: No se pudo crear el hilo de escritura del log\n");
+        fclose(log_file);
+        log_file = NULL;
+        return false;
+    }
+    
+    __atomic_store_n(&log_active, true, __ATOMIC_RELEASE);
+    
     // Registrar inicio del sistema
     log_info("Sistema de logging inicializado");
     
@@ -40,142 +210,128 @@ void log_close() {
         // Registrar cierre del sistema
         log_info("Sistema de logging cerrado");
         
+        __atomic_store_n(&log_active, false, __ATOMIC_RELEASE);
+        
+        // El escritor vacía el búfer antes de terminar
+        pthread_mutex_lock(&log_mutex);
+        log_thread_stop = true;
+        pthread_cond_signal(&log_wakeup);
+        pthread_mutex_unlock(&log_mutex);
+        pthread_join(log_thread, NULL);
+        
         fclose(log_file);
         log_file = NULL;
     }
 }
 
-// Función interna para obtener la hora actual formateada
-static void get_current_time(char* buffer, size_t size) {
-    time_t now = time(NULL);
-    struct tm* tm_info = localtime(&now);
-    strftime(buffer, size, "%Y-%m-%d %H:%M:%S", tm_info);
+// Elegir la política con el búfer lleno
+void log_set_overflow(LogOverflow overflow) {
+    __atomic_store_n(&log_overflow, overflow, __ATOMIC_RELAXED);
 }
 
-// Registrar un mensaje con nivel personalizado
-void log_message(LogLevel level, const char* format, ...) {
+// Copiar un mensaje en el búfer. Reserva una casilla avanzando log_head con
+// CAS, escribe en ella sin que nadie más la toque y la publica con sequence
+static void log_write(LogLevel level, const char* format, va_list args) {
     // Verificar si el nivel de log es suficiente
-    if (level < min_log_level || !log_file) {
+    if (level < min_log_level || !__atomic_load_n(&log_active, __ATOMIC_ACQUIRE)) {
         return;
     }
     
-    // Obtener la hora actual
-    char time_buffer[20];
-    get_current_time(time_buffer, sizeof(time_buffer));
+    uint64_t pos = __atomic_load_n(&log_head, __ATOMIC_RELAXED);
+    LogSlot* slot;
     
-    // Obtener el nivel como cadena
-    const char* level_str = log_level_to_string(level);
+    for (;;) {
+        slot = &log_ring[pos & (LOG_RING_SLOTS - 1)];
+        uint64_t sequence = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        int64_t diff = (int64_t)(sequence - pos);
+        
+        if (diff == 0) {
+            // Casilla libre: intentar quedársela
+            if (__atomic_compare_exchange_n(&log_head, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // El escritor aún no ha sacado el mensaje de la vuelta anterior:
+            // el búfer está lleno
+            if (__atomic_load_n(&log_overflow, __ATOMIC_RELAXED) == LOG_OVERFLOW_DROP ||
+                !__atomic_load_n(&log_active, __ATOMIC_ACQUIRE)) {
+                __atomic_fetch_add(&log_dropped, 1, __ATOMIC_RELAXED);
+                return;
+            }
+            
+            log_wake_writer();
+            sched_yield();
+            pos = __atomic_load_n(&log_head, __ATOMIC_RELAXED);
+        } else {
+            // Otro hilo se quedó la casilla; probar con la siguiente posición
+            pos = __atomic_load_n(&log_head, __ATOMIC_RELAXED);
+        }
+    }
     
-    // Escribir el encabezado del mensaje
-    fprintf(log_file, "[%s] [%s] ", time_buffer, level_str);
+    slot->time = time(NULL);
+    slot->level = level;
     
-    // Escribir el mensaje formateado
+    int length = vsnprintf(slot->message, sizeof(slot->message), format, args);
+    if (length < 0) {
+        length = 0;
+    } else if (length >= (int)sizeof(slot->message)) {
+        length = (int)sizeof(slot->message) - 1;
+    }
+    slot->length = length;
+    
+    __atomic_store_n(&slot->sequence, pos + 1, __ATOMIC_RELEASE);
+    
+    // Los errores se escriben cuanto antes, y el escritor no espera a su
+    // siguiente vaciado si el búfer va por la mitad
+    if (level >= LOG_ERROR ||
+        pos - __atomic_load_n(&log_tail, __ATOMIC_RELAXED) >= LOG_RING_SLOTS / 2) {
+        log_wake_writer();
+    }
+}
+
+// Registrar un mensaje con nivel personalizado
+void log_message(LogLevel level, const char* format, ...) {
     va_list args;
     va_start(args, format);
-    vfprintf(log_file, format, args);
+    log_write(level, format, args);
     va_end(args);
-    
-    // Añadir salto de línea
-    fprintf(log_file, "\n");
-    
-    // Forzar escritura inmediata
-    fflush(log_file);
 }
 
 // Funciones para los diferentes niveles de log
 void log_debug(const char* format, ...) {
-    if (LOG_DEBUG < min_log_level || !log_file) {
-        return;
-    }
-    
-    char time_buffer[20];
-    get_current_time(time_buffer, sizeof(time_buffer));
-    
-    fprintf(log_file, "[%s] [DEBUG] ", time_buffer);
-    
     va_list args;
     va_start(args, format);
-    vfprintf(log_file, format, args);
+    log_write(LOG_DEBUG, format, args);
     va_end(args);
-    
-    fprintf(log_file, "\n");
-    fflush(log_file);
 }
 
 void log_info(const char* format, ...) {
-    if (LOG_INFO < min_log_level || !log_file) {
-        return;
-    }
-    
-    char time_buffer[20];
-    get_current_time(time_buffer, sizeof(time_buffer));
-    
-    fprintf(log_file, "[%s] [INFO] ", time_buffer);
-    
     va_list args;
     va_start(args, format);
-    vfprintf(log_file, format, args);
+    log_write(LOG_INFO, format, args);
     va_end(args);
-    
-    fprintf(log_file, "\n");
-    fflush(log_file);
 }
 
 void log_warning(const char* format, ...) {
-    if (LOG_WARNING < min_log_level || !log_file) {
-        return;
-    }
-    
-    char time_buffer[20];
-    get_current_time(time_buffer, sizeof(time_buffer));
-    
-    fprintf(log_file, "[%s] [WARNING] ", time_buffer);
-    
     va_list args;
     va_start(args, format);
-    vfprintf(log_file, format, args);
+    log_write(LOG_WARNING, format, args);
     va_end(args);
-    
-    fprintf(log_file, "\n");
-    fflush(log_file);
 }
 
 void log_error(const char* format, ...) {
-    if (LOG_ERROR < min_log_level || !log_file) {
-        return;
-    }
-    
-    char time_buffer[20];
-    get_current_time(time_buffer, sizeof(time_buffer));
-    
-    fprintf(log_file, "[%s] [ERROR] ", time_buffer);
-    
     va_list args;
     va_start(args, format);
-    vfprintf(log_file, format, args);
+    log_write(LOG_ERROR, format, args);
     va_end(args);
-    
-    fprintf(log_file, "\n");
-    fflush(log_file);
 }
 
 void log_critical(const char* format, ...) {
-    if (LOG_CRITICAL < min_log_level || !log_file) {
-        return;
-    }
-    
-    char time_buffer[20];
-    get_current_time(time_buffer, sizeof(time_buffer));
-    
-    fprintf(log_file, "[%s] [CRITICAL] ", time_buffer);
-    
     va_list args;
     va_start(args, format);
-    vfprintf(log_file, format, args);
+    log_write(LOG_CRITICAL, format, args);
     va_end(args);
-    
-    fprintf(log_file, "\n");
-    fflush(log_file);
 }
 
 // Convertir cadena de nivel de log a enum
@@ -215,4 +371,13 @@ const char* log_level_to_string(LogLevel level) {
         default:
             return "UNKNOWN";
     }
+}
+
+// Convertir cadena de política de desbordamiento a enum
+LogOverflow log_overflow_from_string(const char* overflow_str) {
+    if (overflow_str && strcmp(overflow_str, "BLOCK") == 0) {
+        return LOG_OVERFLOW_BLOCK;
+    }
+    
+    return LOG_OVERFLOW_DROP; // Valor por defecto
 }
\ No newline at end of file
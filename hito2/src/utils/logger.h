@@ -3,6 +3,11 @@
 
 #include <stdbool.h>
 
+// Registro asíncrono. Los hilos que registran solo copian el mensaje en un
+// búfer circular sin cerrojos y siguen; un hilo escritor los saca en orden,
+// les pone la hora y los escribe en el archivo por lotes. Así ninguna
+// petición espera a que el disco termine de escribir
+
 // Niveles de log
 typedef enum {
     LOG_DEBUG,
@@ -12,12 +17,21 @@ typedef enum {
     LOG_CRITICAL
 } LogLevel;
 
+// Qué hacer con un mensaje cuando el búfer está lleno
+typedef enum {
+    LOG_OVERFLOW_DROP,      // Descartarlo; el escritor avisa de cuántos se perdieron
+    LOG_OVERFLOW_BLOCK      // Esperar a que el escritor haga sitio
+} LogOverflow;
+
 // Inicializar el sistema de logging
 bool log_init(const char* log_path, LogLevel min_level);
 
-// Cerrar el sistema de logging
+// Cerrar el sistema de logging. Escribe antes los mensajes pendientes
 void log_close();
 
+// Elegir la política cuando el búfer está lleno (por defecto, descartar)
+void log_set_overflow(LogOverflow overflow);
+
 // Funciones para registrar eventos
 void log_debug(const char* format, ...);
 void log_info(const char* format, ...);
@@ -34,4 +48,7 @@ LogLevel log_level_from_string(const char* level_str);
 // Convertir enum de nivel de log a cadena
 const char* log_level_to_string(LogLevel level);
 
+// Convertir cadena de política de desbordamiento (DROP o BLOCK) a enum
+LogOverflow log_overflow_from_string(const char* overflow_str);
+
 #endif // LOGGER_H
\ No newline at end of file
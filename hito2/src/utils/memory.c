@@ -2,6 +2,8 @@
 #include "logger.h"
 #include <stdio.h>
 #include <string.h>
+#include <pthread.h>
+#include <stdint.h>
 
 // Estructura para rastrear la memoria asignada
 struct MemoryBlock {
@@ -9,11 +11,18 @@ struct MemoryBlock {
     size_t size;            // Tamaño de la memoria asignada
     const char* file;       // Archivo donde se asignó
     int line;               // Línea donde se asignó
-    MemoryBlock* next;      // Siguiente bloque en la lista
+    MemoryBlock* next;      // Siguiente bloque del mismo cubo
 };
 
-// Lista enlazada de bloques de memoria
-static MemoryBlock* memory_blocks = NULL;
+// Tabla hash de bloques indexada por puntero (potencia de dos). Cada grupo de
+// cubos tiene su propio mutex, así que los hilos que asignan y liberan a la
+// vez casi nunca compiten, y buscar un bloque no recorre todos los demás
+#define MEMORY_NUM_CUBOS 4096
+#define MEMORY_NUM_CERROJOS 64
+
+static MemoryBlock* memory_blocks[MEMORY_NUM_CUBOS];
+static pthread_mutex_t memory_mutex[MEMORY_NUM_CERROJOS];
+static pthread_once_t memory_mutex_once = PTHREAD_ONCE_INIT;
 
 // Contador de bloques
 static int block_count = 0;
@@ -21,9 +30,31 @@ static int block_count = 0;
 // Memoria total asignada
 static size_t total_allocated = 0;
 
+static void memory_mutex_init(void) {
+    for (int i = 0; i < MEMORY_NUM_CERROJOS; i++) {
+        pthread_mutex_init(&memory_mutex[i], NULL);
+    }
+}
+
+// Cubo de un puntero. Los bits bajos siempre son cero por la alineación de
+// malloc, así que se mezclan todos con una multiplicación
+static size_t memory_bucket(const void* ptr) {
+    uint64_t hash = (uint64_t)(uintptr_t)ptr * 0x9E3779B97F4A7C15ULL;
+    return (size_t)(hash >> 52) & (MEMORY_NUM_CUBOS - 1);
+}
+
+static pthread_mutex_t* memory_lock(size_t bucket) {
+    pthread_once(&memory_mutex_once, memory_mutex_init);
+    pthread_mutex_t* mutex = &memory_mutex[bucket % MEMORY_NUM_CERROJOS];
+    pthread_mutex_lock(mutex);
+    return mutex;
+}
+
 // Inicializar el sistema de gestión de memoria
 void memory_init() {
-    memory_blocks = NULL;
+    for (int i = 0; i < MEMORY_NUM_CUBOS; i++) {
+        memory_blocks[i] = NULL;
+    }
     block_count = 0;
     total_allocated = 0;
     log_debug("Sistema de gestión de memoria inicializado");
@@ -32,88 +63,70 @@ void memory_init() {
 // Liberar todos los recursos del sistema de gestión de memoria
 void memory_cleanup() {
     // Verificar si hay fugas de memoria
-    if (block_count > 0) {
-        log_warning("Se detectaron %d bloques de memoria sin liberar", block_count);
+    if (memory_block_count() > 0) {
+        log_warning("Se detectaron %d bloques de memoria sin liberar", memory_block_count());
         memory_leaks_report();
     } else {
         log_debug("No se detectaron fugas de memoria");
     }
     
     // Liberar todos los bloques de memoria
-    MemoryBlock* current = memory_blocks;
-    while (current) {
-        MemoryBlock* next = current->next;
-        free(current->ptr);
-        free(current);
-        current = next;
+    for (int i = 0; i < MEMORY_NUM_CUBOS; i++) {
+        pthread_mutex_t* mutex = memory_lock(i);
+        MemoryBlock* current = memory_blocks[i];
+        while (current) {
+            MemoryBlock* next = current->next;
+            free(current->ptr);
+            free(current);
+            current = next;
+        }
+        memory_blocks[i] = NULL;
+        pthread_mutex_unlock(mutex);
     }
     
-    memory_blocks = NULL;
-    block_count = 0;
-    total_allocated = 0;
+    __atomic_store_n(&block_count, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&total_allocated, 0, __ATOMIC_RELAXED);
     
     log_debug("Sistema de gestión de memoria liberado");
 }
 
-// Añadir un bloque a la lista de bloques
-static void add_block(void* ptr, size_t size, const char* file, int line) {
-    MemoryBlock* block = (MemoryBlock*)malloc(sizeof(MemoryBlock));
-    if (!block) {
-        log_critical("No se pudo asignar memoria para el bloque de seguimiento");
-        return;
-    }
-    
-    block->ptr = ptr;
-    block->size = size;
-    block->file = file;
-    block->line = line;
-    block->next = memory_blocks;
+// Añadir un bloque a la tabla
+static void add_block(MemoryBlock* block) {
+    size_t bucket = memory_bucket(block->ptr);
     
-    memory_blocks = block;
-    block_count++;
-    total_allocated += size;
+    pthread_mutex_t* mutex = memory_lock(bucket);
+    block->next = memory_blocks[bucket];
+    memory_blocks[bucket] = block;
+    pthread_mutex_unlock(mutex);
     
-    log_debug("Memoria asignada: %zu bytes en %s:%d", size, file, line);
+    __atomic_fetch_add(&block_count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&total_allocated, block->size, __ATOMIC_RELAXED);
 }
 
-// Eliminar un bloque de la lista de bloques
-static void remove_block(void* ptr) {
-    MemoryBlock** current = &memory_blocks;
+// Sacar un bloque de la tabla. Devuelve NULL si el puntero no está asignado
+static MemoryBlock* remove_block(void* ptr) {
+    size_t bucket = memory_bucket(ptr);
+    MemoryBlock* found = NULL;
+    
+    pthread_mutex_t* mutex = memory_lock(bucket);
+    MemoryBlock** current = &memory_blocks[bucket];
     
     while (*current) {
         if ((*current)->ptr == ptr) {
-            MemoryBlock* to_remove = *current;
-            *current = to_remove->next;
-            
-            total_allocated -= to_remove->size;
-            block_count--;
-            
-            log_debug("Memoria liberada: %zu bytes desde %s:%d", 
-                     to_remove->size, to_remove->file, to_remove->line);
-            
-            free(to_remove);
-            return;
+            found = *current;
+            *current = found->next;
+            break;
         }
         
         current = &((*current)->next);
     }
+    pthread_mutex_unlock(mutex);
     
-    log_error("Intento de liberar memoria no asignada: %p", ptr);
-}
-
-// Encontrar un bloque en la lista
-static MemoryBlock* find_block(void* ptr) {
-    MemoryBlock* current = memory_blocks;
-    
-    while (current) {
-        if (current->ptr == ptr) {
-            return current;
-        }
-        
-        current = current->next;
+    if (found) {
+        __atomic_fetch_sub(&block_count, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_sub(&total_allocated, found->size, __ATOMIC_RELAXED);
     }
-    
-    return NULL;
+    return found;
 }
 
 // Asignar memoria con seguimiento
@@ -125,7 +138,19 @@ void* memory_alloc(size_t size, const char* file, int line) {
         return NULL;
     }
     
-    add_block(ptr, size, file, line);
+    MemoryBlock* block = (MemoryBlock*)malloc(sizeof(MemoryBlock));
+    if (!block) {
+        log_critical("No se pudo asignar memoria para el bloque de seguimiento");
+        return ptr;
+    }
+    
+    block->ptr = ptr;
+    block->size = size;
+    block->file = file;
+    block->line = line;
+    add_block(block);
+    
+    log_debug("Memoria asignada: %zu bytes en %s:%d", size, file, line);
     return ptr;
 }
 
@@ -136,7 +161,13 @@ void memory_free(void* ptr) {
         return;
     }
     
-    remove_block(ptr);
+    MemoryBlock* block = remove_block(ptr);
+    if (!block) {
+        log_error("Intento de liberar memoria no asignada: %p", ptr);
+    } else {
+        log_debug("Memoria liberada: %zu bytes desde %s:%d", block->size, block->file, block->line);
+        free(block);
+    }
     free(ptr);
 }
 
@@ -146,7 +177,9 @@ void* memory_realloc(void* ptr, size_t size, const char* file, int line) {
         return memory_alloc(size, file, line);
     }
     
-    MemoryBlock* block = find_block(ptr);
+    // Sacar el bloque antes de reasignar: realloc puede liberar ptr y otro
+    // hilo recibir la misma dirección antes de que se vuelva a registrar
+    MemoryBlock* block = remove_block(ptr);
     if (!block) {
         log_error("Intento de reasignar memoria no asignada: %p en %s:%d", ptr, file, line);
         return NULL;
@@ -154,64 +187,65 @@ void* memory_realloc(void* ptr, size_t size, const char* file, int line) {
     
     void* new_ptr = realloc(ptr, size);
     if (!new_ptr) {
+        add_block(block);
         log_critical("Fallo al reasignar %zu bytes en %s:%d", size, file, line);
         return NULL;
     }
     
-    // Actualizar o reemplazar el bloque
-    if (new_ptr == ptr) {
-        // Solo cambió el tamaño
-        total_allocated = total_allocated - block->size + size;
-        block->size = size;
-        log_debug("Memoria reasignada (mismo puntero): %zu bytes en %s:%d", size, file, line);
-    } else {
-        // Cambió el puntero, eliminar el bloque antiguo y añadir uno nuevo
-        remove_block(ptr);
-        add_block(new_ptr, size, file, line);
-        log_debug("Memoria reasignada (nuevo puntero): %zu bytes en %s:%d", size, file, line);
-    }
+    // Registrar el bloque con el puntero y el tamaño nuevos
+    block->ptr = new_ptr;
+    block->size = size;
+    block->file = file;
+    block->line = line;
+    add_block(block);
     
+    log_debug("Memoria reasignada: %zu bytes en %s:%d", size, file, line);
     return new_ptr;
 }
 
 // Obtener el número actual de bloques asignados
 int memory_block_count() {
-    return block_count;
+    return __atomic_load_n(&block_count, __ATOMIC_RELAXED);
 }
 
 // Obtener el total de memoria asignada actualmente
 size_t memory_total_allocated() {
-    return total_allocated;
+    return __atomic_load_n(&total_allocated, __ATOMIC_RELAXED);
 }
 
 // Imprimir informe de memoria actual
 void memory_report() {
     printf("===== Informe de Memoria =====\n");
-    printf("Bloques asignados: %d\n", block_count);
-    printf("Memoria total: %zu bytes\n", total_allocated);
+    printf("Bloques asignados: %d\n", memory_block_count());
+    printf("Memoria total: %zu bytes\n", memory_total_allocated());
     printf("=============================\n");
 }
 
 // Imprimir fugas de memoria (bloques que no han sido liberados)
 void memory_leaks_report() {
-    if (block_count == 0) {
+    int count = memory_block_count();
+    if (count == 0) {
         printf("No se detectaron fugas de memoria.\n");
         return;
     }
     
     printf("===== Informe de Fugas de Memoria =====\n");
-    printf("Se encontraron %d bloques sin liberar:\n", block_count);
+    printf("Se encontraron %d bloques sin liberar:\n", count);
     
     int i = 1;
-    MemoryBlock* current = memory_blocks;
-    
-    while (current) {
-        printf("%d. %zu bytes en %s:%d (ptr: %p)\n", 
-               i++, current->size, current->file, current->line, current->ptr);
+    for (int bucket = 0; bucket < MEMORY_NUM_CUBOS; bucket++) {
+        pthread_mutex_t* mutex = memory_lock(bucket);
+        MemoryBlock* current = memory_blocks[bucket];
         
-        current = current->next;
+        while (current) {
+            printf("%d. %zu bytes en %s:%d (ptr: %p)\n", 
+                   i++, current->size, current->file, current->line, current->ptr);
+            
+            current = current->next;
+        }
+        pthread_mutex_unlock(mutex);
     }
     
-    printf("Total: %zu bytes\n", total_allocated);
+    printf("Total: %zu bytes\n", memory_total_allocated());
     printf("=====================================\n");
 }
\ No newline at end of file
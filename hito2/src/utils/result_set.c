@@ -0,0 +1,65 @@
+#include "result_set.h"
+#include "logger.h"
+#include "memory.h"
+#include <string.h>
+
+// Capacidad con la que se reserva el array en la primera fila
+#define RESULT_SET_INITIAL_CAPACITY 16
+
+// Inicializar un resultado vacío
+void result_set_init(ResultSet* result, size_t row_size) {
+    result->rows = NULL;
+    result->row_size = row_size;
+    result->count = 0;
+    result->capacity = 0;
+}
+
+// Añadir una fila a cero al final
+void* result_set_add_row(ResultSet* result) {
+    if (result->count == result->capacity) {
+        int capacity = result->capacity > 0 ? result->capacity * 2 : RESULT_SET_INITIAL_CAPACITY;
+        void* rows = MEM_REALLOC(result->rows, (size_t)capacity * result->row_size);
+        
+        if (!rows) {
+            log_error("Error al ampliar el resultado a %d filas", capacity);
+            return NULL;
+        }
+        
+        result->rows = rows;
+        result->capacity = capacity;
+    }
+    
+    char* row = (char*)result->rows + (size_t)result->count * result->row_size;
+    memset(row, 0, result->row_size);
+    result->count++;
+    
+    return row;
+}
+
+// Entregar el array de filas al llamador
+void* result_set_take(ResultSet* result, int* count) {
+    void* rows = result->rows;
+    *count = result->count;
+    
+    if (result->count == 0 && rows) {
+        MEM_FREE(rows);
+        rows = NULL;
+    }
+    
+    result->rows = NULL;
+    result->count = 0;
+    result->capacity = 0;
+    
+    return rows;
+}
+
+// Liberar las filas de un resultado
+void result_set_free(ResultSet* result) {
+    if (result->rows) {
+        MEM_FREE(result->rows);
+    }
+    
+    result->rows = NULL;
+    result->count = 0;
+    result->capacity = 0;
+}
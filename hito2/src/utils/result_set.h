@@ -0,0 +1,28 @@
+#ifndef RESULT_SET_H
+#define RESULT_SET_H
+
+#include <stddef.h>
+
+// Array de filas de tamaño desconocido de antemano. Se rellena en una sola
+// pasada sobre la consulta y duplica su capacidad cada vez que se llena
+typedef struct {
+    void* rows;
+    size_t row_size;
+    int count;
+    int capacity;
+} ResultSet;
+
+// Inicializar un resultado vacío para filas de row_size bytes
+void result_set_init(ResultSet* result, size_t row_size);
+
+// Añadir una fila a cero al final. Devuelve NULL si no hay memoria
+void* result_set_add_row(ResultSet* result);
+
+// Entregar el array de filas (NULL si está vacío). El resultado queda vacío
+// y el array pasa a ser del llamador, que lo libera con MEM_FREE
+void* result_set_take(ResultSet* result, int* count);
+
+// Liberar las filas de un resultado que no se ha entregado
+void result_set_free(ResultSet* result);
+
+#endif // RESULT_SET_H
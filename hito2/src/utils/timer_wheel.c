@@ -0,0 +1,128 @@
+#include "timer_wheel.h"
+#include <string.h>
+
+// Bits de tick que abarca cada nivel (64 casillas)
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1)
+
+void timer_wheel_init(TimerWheel* wheel, uint64_t now) {
+    memset(wheel, 0, sizeof(TimerWheel));
+    wheel->now = now;
+}
+
+// Enlazar un temporizador en la casilla que le toca según el tick actual.
+// Si ya ha vencido va a la casilla del tick earliest
+static void timer_wheel_link(TimerWheel* wheel, TimerWheelEntry* entry, uint64_t earliest) {
+    uint64_t expires = entry->expires;
+    if (expires < earliest) {
+        expires = earliest;
+    }
+    
+    // El nivel es el más bajo en el que el tick de vencimiento y el actual
+    // comparten los bits superiores; así la casilla se procesa antes de que
+    // el temporizador venza
+    int level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 &&
+           (expires >> (TIMER_WHEEL_BITS * (level + 1))) != (wheel->now >> (TIMER_WHEEL_BITS * (level + 1)))) {
+        level++;
+    }
+    
+    int slot;
+    uint64_t limit = wheel->now + ((uint64_t)1 << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS));
+    if (level == TIMER_WHEEL_LEVELS - 1 && expires >= limit) {
+        // Más allá del alcance de la rueda: se aparca en la última casilla
+        // alcanzable del nivel superior y se recoloca al bajar
+        slot = (int)(((limit - 1) >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK);
+    } else {
+        slot = (int)((expires >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK);
+    }
+    
+    TimerWheelEntry** head = &wheel->slots[level][slot];
+    entry->next = *head;
+    entry->pprev = head;
+    if (*head) {
+        (*head)->pprev = &entry->next;
+    }
+    *head = entry;
+}
+
+static void timer_wheel_unlink(TimerWheelEntry* entry) {
+    *entry->pprev = entry->next;
+    if (entry->next) {
+        entry->next->pprev = entry->pprev;
+    }
+    entry->next = NULL;
+    entry->pprev = NULL;
+}
+
+void timer_wheel_add(TimerWheel* wheel, TimerWheelEntry* entry, uint64_t expires) {
+    entry->expires = expires;
+    
+    // La casilla del tick actual ya se procesó
+    timer_wheel_link(wheel, entry, wheel->now + 1);
+    wheel->count++;
+}
+
+void timer_wheel_remove(TimerWheel* wheel, TimerWheelEntry* entry) {
+    if (entry->pprev) {
+        timer_wheel_unlink(entry);
+        wheel->count--;
+    }
+}
+
+// Bajar los temporizadores de una casilla a los niveles inferiores
+static void timer_wheel_cascade(TimerWheel* wheel, int level) {
+    int slot = (int)((wheel->now >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK);
+    TimerWheelEntry* entry = wheel->slots[level][slot];
+    wheel->slots[level][slot] = NULL;
+    
+    while (entry) {
+        TimerWheelEntry* next = entry->next;
+        
+        // Los que vencen en este mismo tick van a la casilla que se procesa
+        // justo después de bajar
+        timer_wheel_link(wheel, entry, wheel->now);
+        entry = next;
+    }
+}
+
+int timer_wheel_advance(TimerWheel* wheel, uint64_t now, TimerWheelCallback callback, void* context) {
+    int expired = 0;
+    
+    while (wheel->now < now) {
+        if (wheel->count == 0) {
+            // Nada pendiente: saltar directamente al tick pedido
+            wheel->now = now;
+            break;
+        }
+        
+        wheel->now++;
+        
+        // Al completar una vuelta de un nivel se baja la casilla que empieza
+        // del nivel siguiente, empezando por el más alto que haya cambiado
+        int top = 0;
+        while (top < TIMER_WHEEL_LEVELS - 1 &&
+               ((wheel->now >> (TIMER_WHEEL_BITS * top)) & TIMER_WHEEL_MASK) == 0) {
+            top++;
+        }
+        for (int level = top; level > 0; level--) {
+            timer_wheel_cascade(wheel, level);
+        }
+        
+        int slot = (int)(wheel->now & TIMER_WHEEL_MASK);
+        TimerWheelEntry* entry = wheel->slots[0][slot];
+        wheel->slots[0][slot] = NULL;
+        
+        while (entry) {
+            TimerWheelEntry* next = entry->next;
+            entry->next = NULL;
+            entry->pprev = NULL;
+            wheel->count--;
+            expired++;
+            callback(entry, context);
+            entry = next;
+        }
+    }
+    
+    return expired;
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+
+// Rueda jerárquica de temporizadores. Cada nivel tiene 64 casillas y cada
+// casilla del nivel n abarca 64^n ticks: un temporizador se guarda en el nivel
+// más bajo que lo contiene y, al acercarse su vencimiento, baja al siguiente.
+// Añadir y quitar cuestan O(1) y avanzar un tick solo toca una casilla, así
+// que miles de temporizadores vencen sin recorrerlos todos.
+// No tiene bloqueos: quien la usa desde varios hilos debe protegerla.
+
+#define TIMER_WHEEL_LEVELS 4
+#define TIMER_WHEEL_SLOTS 64
+
+// Temporizador. Va dentro de la estructura de quien lo usa
+typedef struct TimerWheelEntry {
+    uint64_t expires;                   // Tick en el que vence
+    struct TimerWheelEntry* next;
+    struct TimerWheelEntry** pprev;     // Enlace que apunta a este temporizador
+} TimerWheelEntry;
+
+typedef struct {
+    uint64_t now;                       // Último tick procesado
+    int count;                          // Temporizadores pendientes
+    TimerWheelEntry* slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+} TimerWheel;
+
+// Función llamada con cada temporizador vencido, ya fuera de la rueda
+typedef void (*TimerWheelCallback)(TimerWheelEntry* entry, void* context);
+
+// Inicializar una rueda vacía en el tick indicado
+void timer_wheel_init(TimerWheel* wheel, uint64_t now);
+
+// Programar un temporizador. Si el tick ya pasó, vence en el siguiente avance
+void timer_wheel_add(TimerWheel* wheel, TimerWheelEntry* entry, uint64_t expires);
+
+// Cancelar un temporizador pendiente
+void timer_wheel_remove(TimerWheel* wheel, TimerWheelEntry* entry);
+
+// Avanzar hasta el tick indicado llamando a callback con cada temporizador
+// vencido. Devuelve cuántos han vencido
+int timer_wheel_advance(TimerWheel* wheel, uint64_t now, TimerWheelCallback callback, void* context);
+
+#endif // TIMER_WHEEL_H
\ No newline at end of file
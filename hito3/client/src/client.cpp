@@ -2,11 +2,13 @@
 #include "client.h"
 #include <iostream>
 #include <sstream>
+#include <algorithm>
+#include <stdexcept>
 #include <ws2tcpip.h>
 
 Client::Client(const std::string& serverIp, int serverPort)
     : clientSocket(-1), serverIp(serverIp), serverPort(serverPort), 
-      connected(false), loggedIn(false), userId(-1), userType(-1) {
+      connected(false), wireFormat(WIRE_TEXT), loggedIn(false), userId(-1), userType(-1) {
 }
 
 Client::~Client() {
@@ -59,9 +61,31 @@ bool Client::connect() {
     }
     
     connected = true;
+    receiveBuffer.clear();
+    negotiateWireFormat();
     return true;
 }
 
+void Client::negotiateWireFormat() {
+    wireFormat = WIRE_TEXT;
+    
+    // La negociación siempre viaja en texto
+    Message request(OP_NEGOTIATE);
+    request.addInt(MAX_WIRE_FORMAT);
+    
+    if (!sendMessage(clientSocket, request)) {
+        return;
+    }
+    
+    Message response = receiveMessage(clientSocket, receiveBuffer, WIRE_TEXT);
+    if (response.getOpCode() == OP_OK && response.hasMoreData()) {
+        int agreed = response.getInt();
+        if (agreed == WIRE_BINARY) {
+            wireFormat = WIRE_BINARY;
+        }
+    }
+}
+
 void Client::disconnect() {
     if (connected) {
         closesocket(clientSocket);
@@ -86,7 +110,7 @@ bool Client::login(const std::string& email, const std::string& password) {
     }
     
     // Crear mensaje de solicitud
-    Message request(OP_LOGIN);
+    Message request = createRequest(OP_LOGIN);
     request.addString(email);
     request.addString(password);
     
@@ -167,7 +191,7 @@ Pelicula Client::getPelicula(int id) {
     }
     
     // Crear mensaje de solicitud
-    Message request(OP_PELICULA_GET);
+    Message request = createRequest(OP_PELICULA_GET);
     request.addInt(id);
     
     // Enviar solicitud y recibir respuesta
@@ -194,7 +218,7 @@ bool Client::createPelicula(Pelicula& pelicula) {
     }
     
     // Crear mensaje de solicitud
-    Message request(OP_PELICULA_CREATE);
+    Message request = createRequest(OP_PELICULA_CREATE);
     pelicula.serialize(request);
     
     // Enviar solicitud y recibir respuesta
@@ -221,7 +245,7 @@ bool Client::updatePelicula(const Pelicula& pelicula) {
     }
     
     // Crear mensaje de solicitud
-    Message request(OP_PELICULA_UPDATE);
+    Message request = createRequest(OP_PELICULA_UPDATE);
     pelicula.serialize(request);
     
     // Enviar solicitud y recibir respuesta
@@ -247,7 +271,7 @@ bool Client::deletePelicula(int id) {
     }
     
     // Crear mensaje de solicitud
-    Message request(OP_PELICULA_DELETE);
+    Message request = createRequest(OP_PELICULA_DELETE);
     request.addInt(id);
     
     // Enviar solicitud y recibir respuesta
@@ -270,7 +294,7 @@ std::vector<Pelicula> Client::searchPeliculasByTitulo(const std::string& titulo)
     }
     
     // Crear mensaje de solicitud
-    Message request(OP_PELICULA_SEARCH_TITULO);
+    Message request = createRequest(OP_PELICULA_SEARCH_TITULO);
     request.addString(titulo);
     
     // Enviar solicitud y recibir respuesta
@@ -294,7 +318,7 @@ std::vector<Pelicula> Client::searchPeliculasByGenero(const std::string& genero)
     }
     
     // Crear mensaje de solicitud
-    Message request(OP_PELICULA_SEARCH_GENERO);
+    Message request = createRequest(OP_PELICULA_SEARCH_GENERO);
     request.addString(genero);
     
     // Enviar solicitud y recibir respuesta
@@ -309,6 +333,41 @@ std::vector<Pelicula> Client::searchPeliculasByGenero(const std::string& genero)
     return result;
 }
 
+std::vector<Pelicula> Client::searchPeliculasByGeneros(const std::vector<std::string>& generos, bool todos,
+                                                       int desde, int limite, int* total) {
+    std::vector<Pelicula> result;
+    
+    if (!connected) {
+        lastError = "No conectado al servidor";
+        return result;
+    }
+    
+    // Crear mensaje de solicitud
+    Message request = createRequest(OP_PELICULA_SEARCH_GENEROS);
+    request.addBool(todos);
+    request.addInt(desde);
+    request.addInt(limite);
+    request.addInt(static_cast<int>(generos.size()));
+    for (const auto& genero : generos) {
+        request.addString(genero);
+    }
+    
+    // Enviar solicitud y recibir respuesta
+    Message response = sendRequest(OP_PELICULA_SEARCH_GENEROS, request);
+    
+    if (response.getOpCode() == OP_OK) {
+        int numTotal = response.getInt();
+        if (total) {
+            *total = numTotal;
+        }
+        result = deserializePeliculaList(response);
+    } else {
+        lastError = response.getData();
+    }
+    
+    return result;
+}
+
 // Implementar las funciones de Sesiones
 std::vector<Sesion> Client::getSesiones() {
     std::vector<Sesion> result;
@@ -330,6 +389,35 @@ std::vector<Sesion> Client::getSesiones() {
     return result;
 }
 
+std::vector<Sesion> Client::getSesionesByRango(int64_t desde, int64_t hasta, int salaId,
+                                               int peliculaId, int limite) {
+    std::vector<Sesion> result;
+    
+    if (!connected) {
+        lastError = "No conectado al servidor";
+        return result;
+    }
+    
+    // Crear mensaje de solicitud
+    Message request = createRequest(OP_SESION_SEARCH_RANGO);
+    request.addInt64(desde);
+    request.addInt64(hasta);
+    request.addInt(salaId);
+    request.addInt(peliculaId);
+    request.addInt(limite);
+    
+    // Enviar solicitud y recibir respuesta
+    Message response = sendRequest(OP_SESION_SEARCH_RANGO, request);
+    
+    if (response.getOpCode() == OP_OK) {
+        result = deserializeSesionList(response);
+    } else {
+        lastError = response.getData();
+    }
+    
+    return result;
+}
+
 Sesion Client::getSesion(int id) {
     Sesion result;
     
@@ -339,7 +427,7 @@ Sesion Client::getSesion(int id) {
     }
     
     // Crear mensaje de solicitud
-    Message request(OP_SESION_GET);
+    Message request = createRequest(OP_SESION_GET);
     request.addInt(id);
     
     // Enviar solicitud y recibir respuesta
@@ -354,9 +442,250 @@ Sesion Client::getSesion(int id) {
     return result;
 }
 
+std::vector<Client::Sala> Client::getSalas() {
+    std::vector<Sala> result;
+    
+    if (!connected) {
+        lastError = "No conectado al servidor";
+        return result;
+    }
+    
+    // Enviar solicitud y recibir respuesta
+    Message response = sendRequest(OP_SALA_LIST);
+    
+    if (response.getOpCode() == OP_OK) {
+        int count = response.getCount();
+        result.reserve(count);
+        
+        for (int i = 0; i < count; i++) {
+            Sala sala;
+            sala.id = response.getInt();
+            sala.numAsientos = response.getInt();
+            result.push_back(sala);
+        }
+    } else {
+        lastError = response.getData();
+    }
+    
+    return result;
+}
+
+Client::Sala Client::getSala(int id) {
+    Sala result;
+    result.id = -1;
+    result.numAsientos = 0;
+    
+    if (!connected) {
+        lastError = "No conectado al servidor";
+        return result;
+    }
+    
+    // Crear mensaje de solicitud
+    Message request = createRequest(OP_SALA_GET);
+    request.addInt(id);
+    
+    // Enviar solicitud y recibir respuesta
+    Message response = sendRequest(OP_SALA_GET, request);
+    
+    if (response.getOpCode() == OP_OK) {
+        result.id = response.getInt();
+        result.numAsientos = response.getInt();
+    } else {
+        lastError = response.getData();
+    }
+    
+    return result;
+}
+
+bool Client::checkAsientoDisponible(int sesionId, int asientoId) {
+    if (!connected) {
+        lastError = "No conectado al servidor";
+        return false;
+    }
+    
+    // Crear mensaje de solicitud
+    Message request = createRequest(OP_BILLETE_DISPONIBILIDAD);
+    request.addInt(sesionId);
+    request.addInt(asientoId);
+    
+    // Enviar solicitud y recibir respuesta
+    Message response = sendRequest(OP_BILLETE_DISPONIBILIDAD, request);
+    
+    if (response.getOpCode() == OP_OK) {
+        return response.getBool();
+    } else {
+        lastError = response.getData();
+        return false;
+    }
+}
+
+std::vector<bool> Client::checkAsientosDisponibles(int sesionId, const std::vector<int>& asientoIds) {
+    std::vector<Message> requests;
+    requests.reserve(asientoIds.size());
+    
+    for (int asientoId : asientoIds) {
+        Message request = createRequest(OP_BILLETE_DISPONIBILIDAD);
+        request.addInt(sesionId);
+        request.addInt(asientoId);
+        requests.push_back(request);
+    }
+    
+    std::vector<Message> responses = sendBatch(requests);
+    std::vector<bool> result(asientoIds.size(), false);
+    
+    for (size_t i = 0; i < responses.size() && i < result.size(); i++) {
+        if (responses[i].getOpCode() == OP_OK) {
+            result[i] = responses[i].getBool();
+        }
+    }
+    
+    return result;
+}
+
+Client::MapaOcupacion Client::getMapaOcupacion(int sesionId) {
+    MapaOcupacion result;
+    result.salaId = -1;
+    
+    if (!connected) {
+        lastError = "No conectado al servidor";
+        return result;
+    }
+    
+    // Crear mensaje de solicitud
+    Message request = createRequest(OP_BILLETE_MAPA_OCUPACION);
+    request.addInt(sesionId);
+    
+    // Enviar solicitud y recibir respuesta
+    Message response = sendRequest(OP_BILLETE_MAPA_OCUPACION, request);
+    
+    if (response.getOpCode() == OP_OK) {
+        result.salaId = response.getInt();
+        int numAsientos = response.getInt();
+        std::string mapa = response.getBytes();
+        
+        result.ocupados.resize(numAsientos > 0 ? numAsientos : 0, false);
+        for (int i = 0; i < numAsientos && static_cast<size_t>(i / 8) < mapa.size(); i++) {
+            result.ocupados[i] = (static_cast<unsigned char>(mapa[i / 8]) >> (i % 8)) & 1;
+        }
+    } else {
+        lastError = response.getData();
+    }
+    
+    return result;
+}
+
+int Client::holdAsientos(int sesionId, const std::vector<int>& asientoIds, int segundos, int64_t* vence) {
+    if (!connected) {
+        lastError = "No conectado al servidor";
+        return -1;
+    }
+    
+    // Crear mensaje de solicitud
+    Message request = createRequest(OP_SEAT_HOLD);
+    request.addInt(sesionId);
+    request.addInt(segundos);
+    request.addInt(static_cast<int>(asientoIds.size()));
+    for (int asientoId : asientoIds) {
+        request.addInt(asientoId);
+    }
+    
+    // Enviar solicitud y recibir respuesta
+    Message response = sendRequest(OP_SEAT_HOLD, request);
+    
+    if (response.getOpCode() == OP_OK) {
+        int retencionId = response.getInt();
+        int64_t caduca = response.getInt64();
+        if (vence) {
+            *vence = caduca;
+        }
+        return retencionId;
+    }
+    
+    lastError = response.getData();
+    return -1;
+}
+
+bool Client::releaseHold(int retencionId) {
+    if (!connected) {
+        lastError = "No conectado al servidor";
+        return false;
+    }
+    
+    Message request = createRequest(OP_SEAT_RELEASE);
+    request.addInt(retencionId);
+    
+    Message response = sendRequest(OP_SEAT_RELEASE, request);
+    
+    if (response.getOpCode() != OP_OK) {
+        lastError = response.getData();
+        return false;
+    }
+    return true;
+}
+
+std::vector<int> Client::getMejoresAsientos(int sesionId, int numAsientos, int* fila) {
+    std::vector<int> result;
+    
+    if (!connected) {
+        lastError = "No conectado al servidor";
+        return result;
+    }
+    
+    Message request = createRequest(OP_SEAT_BEST);
+    request.addInt(sesionId);
+    request.addInt(numAsientos);
+    
+    Message response = sendRequest(OP_SEAT_BEST, request);
+    
+    if (response.getOpCode() == OP_OK) {
+        int filaAsientos = response.getInt();
+        int n = response.getInt();
+        for (int i = 0; i < n; i++) {
+            result.push_back(response.getInt());
+        }
+        if (fila) {
+            *fila = filaAsientos;
+        }
+    } else {
+        lastError = response.getData();
+    }
+    
+    return result;
+}
+
+int Client::createVentaFromHold(int retencionId, double descuento) {
+    if (!connected) {
+        lastError = "No conectado al servidor";
+        return -1;
+    }
+    
+    // Venta sin billetes: los asientos son los de la retención
+    Message request = createRequest(OP_VENTA_CREATE);
+    request.addInt(0);
+    request.addDouble(descuento);
+    request.addInt(retencionId);
+    
+    Message response = sendRequest(OP_VENTA_CREATE, request);
+    
+    if (response.getOpCode() == OP_OK) {
+        return response.getInt();
+    }
+    
+    lastError = response.getData();
+    return -1;
+}
+
 // Implementar las demás funciones de manera similar...
 
 // Funciones de utilidad
+Message Client::createRequest(OperationCode opCode) const {
+    return Message(opCode, "", wireFormat);
+}
+
+Message Client::sendRequest(OperationCode opCode) {
+    return sendRequest(opCode, createRequest(opCode));
+}
+
 Message Client::sendRequest(OperationCode opCode, const Message& request) {
     if (!connected) {
         return Message(OP_ERROR, "No conectado al servidor");
@@ -369,7 +698,7 @@ Message Client::sendRequest(OperationCode opCode, const Message& request) {
     }
     
     // Recibir la respuesta
-    Message response = receiveMessage(clientSocket);
+    Message response = receiveMessage(clientSocket, receiveBuffer, wireFormat);
     
     if (response.getOpCode() == OP_ERROR) {
         lastError = response.getData();
@@ -378,6 +707,67 @@ Message Client::sendRequest(OperationCode opCode, const Message& request) {
     return response;
 }
 
+std::vector<Message> Client::sendBatch(const std::vector<Message>& requests) {
+    std::vector<Message> responses;
+    responses.reserve(requests.size());
+    
+    if (!connected) {
+        lastError = "No conectado al servidor";
+        return responses;
+    }
+    
+    // Los lotes grandes se parten en tramas de como mucho MAX_BATCH_SIZE
+    for (size_t first = 0; first < requests.size(); first += MAX_BATCH_SIZE) {
+        size_t count = std::min(requests.size() - first, static_cast<size_t>(MAX_BATCH_SIZE));
+        
+        Message batch = createRequest(OP_BATCH);
+        batch.addInt(static_cast<int>(count));
+        for (size_t i = first; i < first + count; i++) {
+            batch.addMessage(requests[i]);
+        }
+        
+        Message response = sendRequest(OP_BATCH, batch);
+        
+        if (response.getOpCode() == OP_ERROR && response.getData() == ERROR_UNSUPPORTED_OPERATION) {
+            // Servidor sin soporte para lotes: se envían una a una
+            for (size_t i = first; i < first + count; i++) {
+                responses.push_back(sendRequest(requests[i].getOpCode(), requests[i]));
+            }
+            continue;
+        }
+        
+        if (response.getOpCode() != OP_OK) {
+            // Cualquier otro error es un fallo del lote, no de cada petición
+            if (response.getOpCode() != OP_ERROR) {
+                lastError = "Respuesta inesperada al lote";
+            }
+            responses.clear();
+            return responses;
+        }
+        
+        // Debe haber exactamente una respuesta por petición: si sobran o
+        // faltan, no se sabe a qué petición corresponde cada una
+        try {
+            int numRespuestas = response.getInt();
+            if (numRespuestas != static_cast<int>(count)) {
+                lastError = "El número de respuestas del lote no coincide con el de peticiones";
+                responses.clear();
+                return responses;
+            }
+            
+            for (int i = 0; i < numRespuestas; i++) {
+                responses.push_back(response.getMessage());
+            }
+        } catch (const std::exception&) {
+            lastError = "Respuesta al lote mal formada";
+            responses.clear();
+            return responses;
+        }
+    }
+    
+    return responses;
+}
+
 std::string Client::getLastError() const {
     return lastError;
 }
@@ -17,6 +17,12 @@ private:
     int serverPort;
     bool connected;
     
+    // Formato de trama acordado con el servidor al conectar
+    WireFormat wireFormat;
+    
+    // Bytes recibidos que aún no se han entregado como respuesta
+    ReceiveBuffer receiveBuffer;
+    
     // Información de la sesión
     bool loggedIn;
     int userId;
@@ -25,6 +31,9 @@ private:
     
     // Inicialización de WinSock
     bool initializeWinsock();
+    
+    // Pedir al servidor el formato binario; si no lo soporta se sigue en texto
+    void negotiateWireFormat();
 
 public:
     Client(const std::string& serverIp = "127.0.0.1", int serverPort = 8080);
@@ -52,6 +61,10 @@ public:
     bool deletePelicula(int id);
     std::vector<Pelicula> searchPeliculasByTitulo(const std::string& titulo);
     std::vector<Pelicula> searchPeliculasByGenero(const std::string& genero);
+    // Página [desde, desde + limite) de las películas con todos (o alguno) de
+    // los géneros; en total se deja el número de películas de todas las páginas
+    std::vector<Pelicula> searchPeliculasByGeneros(const std::vector<std::string>& generos, bool todos,
+                                                   int desde, int limite, int* total = nullptr);
     
     // Sesiones
     // Sesiones
@@ -63,6 +76,10 @@ public:
     std::vector<Sesion> getSesionesByPelicula(int peliculaId);
     std::vector<Sesion> getSesionesBySala(int salaId);
     std::vector<Sesion> getSesionesByFecha(const std::string& fecha);
+    // Sesiones que empiezan en [desde, hasta), por hora de inicio. salaId,
+    // peliculaId y limite a 0 no filtran
+    std::vector<Sesion> getSesionesByRango(int64_t desde, int64_t hasta, int salaId = 0,
+                                           int peliculaId = 0, int limite = 0);
     
     // Salas y asientos
     struct Sala {
@@ -87,6 +104,13 @@ public:
         double total;
     };
     
+    // Ocupación de los asientos de una sesión, por posición en la sala
+    // (ordenada por número de asiento)
+    struct MapaOcupacion {
+        int salaId;
+        std::vector<bool> ocupados;
+    };
+    
     struct VentaDetalle {
         int id;
         int usuarioId;
@@ -98,10 +122,29 @@ public:
     
     bool createBillete(int sesionId, int asientoId, double precio);
     bool checkAsientoDisponible(int sesionId, int asientoId);
+    MapaOcupacion getMapaOcupacion(int sesionId);
     int createVenta(const std::vector<std::pair<int, int>>& billetes, double descuento = 0.0);
+    
+    // Retener asientos de una sesión mientras se paga. segundos a 0 usa el
+    // plazo del servidor; en vence queda la hora a la que caduca (segundos
+    // desde la época). Devuelve el ID de la retención o -1
+    int holdAsientos(int sesionId, const std::vector<int>& asientoIds, int segundos = 0, int64_t* vence = nullptr);
+    bool releaseHold(int retencionId);
+    // Mejores asientos contiguos libres de una sesión, en una misma fila y lo
+    // más centrados posible. En fila queda la fila (desde 0). Vacío si no hay
+    std::vector<int> getMejoresAsientos(int sesionId, int numAsientos, int* fila = nullptr);
+    // Comprar los asientos de una retención sin volver a comprobarlos
+    int createVentaFromHold(int retencionId, double descuento = 0.0);
     std::vector<Venta> getVentasByUser();
     VentaDetalle getVentaDetalle(int ventaId);
     
+    // Peticiones agrupadas: se envían en una sola trama OP_BATCH y se reciben
+    // las respuestas en el mismo orden, con un único viaje de ida y vuelta.
+    // Si el lote falla devuelve un vector vacío y el motivo en getLastError()
+    Message createRequest(OperationCode opCode) const;
+    std::vector<Message> sendBatch(const std::vector<Message>& requests);
+    std::vector<bool> checkAsientosDisponibles(int sesionId, const std::vector<int>& asientoIds);
+    
     // Mensajes de error
     std::string getLastError() const;
 
@@ -109,7 +152,8 @@ private:
     std::string lastError;
     
     // Métodos auxiliares para comunicación
-    Message sendRequest(OperationCode opCode, const Message& request = Message(OP_OK));
+    Message sendRequest(OperationCode opCode);
+    Message sendRequest(OperationCode opCode, const Message& request);
 };
 
 #endif // CLIENT_H
\ No newline at end of file
@@ -331,11 +331,11 @@ void Menu::clienteVerCartelera() {
                 }
                 
                 // Formatear hora (quitar los segundos y la fecha completa)
-                std::string horaInicio = sesiones[j].getHoraInicio().substr(11, 5);
-                std::string horaFin = sesiones[j].getHoraFin().substr(11, 5);
+                std::string horaInicio = sesiones[j].getHoraInicioTexto().substr(11, 5);
+                std::string horaFin = sesiones[j].getHoraFinTexto().substr(11, 5);
                 
                 // Extraer solo la fecha (YYYY-MM-DD)
-                std::string fecha = sesiones[j].getHoraInicio().substr(0, 10);
+                std::string fecha = sesiones[j].getHoraInicioTexto().substr(0, 10);
                 
                 std::cout << "     - Sesión ID: " << sesiones[j].getId() 
                           << " | Fecha: " << fecha 
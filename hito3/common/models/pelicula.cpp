@@ -49,9 +49,9 @@ void Pelicula::serialize(Message& msg) const {
 Pelicula Pelicula::deserialize(Message& msg) {
     Pelicula p;
     p.id = msg.getInt();
-    p.titulo = msg.getString();
+    p.titulo.assign(msg.getStringView());
     p.duracion = msg.getInt();
-    p.genero = msg.getString();
+    p.genero.assign(msg.getStringView());
     return p;
 }
 
@@ -64,7 +64,8 @@ std::string Pelicula::toString() const {
 
 std::vector<Pelicula> deserializePeliculaList(Message& msg) {
     std::vector<Pelicula> result;
-    int count = msg.getInt();
+    int count = msg.getCount();
+    result.reserve(count);
     
     for (int i = 0; i < count; i++) {
         result.push_back(Pelicula::deserialize(msg));
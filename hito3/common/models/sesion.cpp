@@ -1,11 +1,13 @@
 // sesion.cpp
 #include "sesion.h"
 #include <sstream>
+#include <cstdio>
+#include <stdexcept>
 
-Sesion::Sesion() : id(0), pelicula_id(0), sala_id(0) {}
+Sesion::Sesion() : id(0), pelicula_id(0), sala_id(0), hora_inicio(0), hora_fin(0) {}
 
 Sesion::Sesion(int id, int pelicula_id, int sala_id, 
-               const std::string& hora_inicio, const std::string& hora_fin)
+               int64_t hora_inicio, int64_t hora_fin)
     : id(id), pelicula_id(pelicula_id), sala_id(sala_id), 
       hora_inicio(hora_inicio), hora_fin(hora_fin) {}
 
@@ -21,14 +23,22 @@ int Sesion::getSalaId() const {
     return sala_id;
 }
 
-std::string Sesion::getHoraInicio() const {
+int64_t Sesion::getHoraInicio() const {
     return hora_inicio;
 }
 
-std::string Sesion::getHoraFin() const {
+int64_t Sesion::getHoraFin() const {
     return hora_fin;
 }
 
+std::string Sesion::getHoraInicioTexto() const {
+    return formatHora(hora_inicio);
+}
+
+std::string Sesion::getHoraFinTexto() const {
+    return formatHora(hora_fin);
+}
+
 void Sesion::setId(int id) {
     this->id = id;
 }
@@ -41,11 +51,11 @@ void Sesion::setSalaId(int sala_id) {
     this->sala_id = sala_id;
 }
 
-void Sesion::setHoraInicio(const std::string& hora_inicio) {
+void Sesion::setHoraInicio(int64_t hora_inicio) {
     this->hora_inicio = hora_inicio;
 }
 
-void Sesion::setHoraFin(const std::string& hora_fin) {
+void Sesion::setHoraFin(int64_t hora_fin) {
     this->hora_fin = hora_fin;
 }
 
@@ -53,8 +63,16 @@ void Sesion::serialize(Message& msg) const {
     msg.addInt(id);
     msg.addInt(pelicula_id);
     msg.addInt(sala_id);
-    msg.addString(hora_inicio);
-    msg.addString(hora_fin);
+    
+    // El formato texto (v1) mantiene las horas como "YYYY-MM-DD HH:MM:SS"
+    // para que los clientes anteriores sigan funcionando
+    if (msg.getWireFormat() == WIRE_BINARY) {
+        msg.addInt64(hora_inicio);
+        msg.addInt64(hora_fin);
+    } else {
+        msg.addString(formatHora(hora_inicio));
+        msg.addString(formatHora(hora_fin));
+    }
 }
 
 Sesion Sesion::deserialize(Message& msg) {
@@ -62,8 +80,14 @@ Sesion Sesion::deserialize(Message& msg) {
     s.id = msg.getInt();
     s.pelicula_id = msg.getInt();
     s.sala_id = msg.getInt();
-    s.hora_inicio = msg.getString();
-    s.hora_fin = msg.getString();
+    
+    if (msg.getWireFormat() == WIRE_BINARY) {
+        s.hora_inicio = msg.getInt64();
+        s.hora_fin = msg.getInt64();
+    } else if (!parseHora(msg.getStringView(), &s.hora_inicio) ||
+               !parseHora(msg.getStringView(), &s.hora_fin)) {
+        throw std::invalid_argument("Hora de sesión inválida");
+    }
     return s;
 }
 
@@ -72,14 +96,70 @@ std::string Sesion::toString() const {
     ss << "ID: " << id 
        << " | Película ID: " << pelicula_id 
        << " | Sala ID: " << sala_id 
-       << " | Inicio: " << hora_inicio 
-       << " | Fin: " << hora_fin;
+       << " | Inicio: " << formatHora(hora_inicio) 
+       << " | Fin: " << formatHora(hora_fin);
     return ss.str();
 }
 
+std::string Sesion::formatHora(int64_t hora) {
+    const int64_t SEGUNDOS_DIA = 86400;
+    int64_t dias = hora / SEGUNDOS_DIA;
+    int64_t segundos = hora % SEGUNDOS_DIA;
+    if (segundos < 0) {
+        segundos += SEGUNDOS_DIA;
+        dias--;
+    }
+    
+    // Fecha del calendario gregoriano a partir de los días desde 1970-01-01,
+    // contando los años desde marzo
+    dias += 719468;
+    int64_t era = (dias >= 0 ? dias : dias - 146096) / 146097;
+    int64_t diaEra = dias - era * 146097;
+    int64_t anioEra = (diaEra - diaEra / 1460 + diaEra / 36524 - diaEra / 146096) / 365;
+    int64_t diaAnio = diaEra - (365 * anioEra + anioEra / 4 - anioEra / 100);
+    int64_t mesMarzo = (5 * diaAnio + 2) / 153;
+    int dia = static_cast<int>(diaAnio - (153 * mesMarzo + 2) / 5 + 1);
+    int mes = static_cast<int>(mesMarzo < 10 ? mesMarzo + 3 : mesMarzo - 9);
+    long long anio = anioEra + era * 400 + (mes <= 2 ? 1 : 0);
+    
+    char texto[32];
+    snprintf(texto, sizeof(texto), "%04lld-%02d-%02d %02d:%02d:%02d",
+             anio, mes, dia,
+             static_cast<int>(segundos / 3600),
+             static_cast<int>(segundos / 60 % 60),
+             static_cast<int>(segundos % 60));
+    return texto;
+}
+
+bool Sesion::parseHora(std::string_view texto, int64_t* hora) {
+    int anio, mes, dia, horas, minutos, segundos;
+    std::string campo(texto);
+    
+    if (sscanf(campo.c_str(), "%4d-%2d-%2d %2d:%2d:%2d",
+               &anio, &mes, &dia, &horas, &minutos, &segundos) != 6 ||
+        mes < 1 || mes > 12) {
+        return false;
+    }
+    
+    // Días desde 1970-01-01: el cálculo inverso al de formatHora
+    int64_t a = anio - (mes <= 2 ? 1 : 0);
+    int64_t era = (a >= 0 ? a : a - 399) / 400;
+    int64_t anioEra = a - era * 400;
+    int64_t diaAnio = (153 * (mes > 2 ? mes - 3 : mes + 9) + 2) / 5 + dia - 1;
+    int64_t diaEra = anioEra * 365 + anioEra / 4 - anioEra / 100 + diaAnio;
+    int64_t dias = era * 146097 + diaEra - 719468;
+    
+    *hora = dias * 86400 + horas * 3600 + minutos * 60 + segundos;
+    
+    // Volver a formatearla descarta fechas imposibles (31 de febrero, 25:00)
+    // y cualquier texto que no tenga exactamente el formato esperado
+    return formatHora(*hora) == texto;
+}
+
 std::vector<Sesion> deserializeSesionList(Message& msg) {
     std::vector<Sesion> result;
-    int count = msg.getInt();
+    int count = msg.getCount();
+    result.reserve(count);
     
     for (int i = 0; i < count; i++) {
         result.push_back(Sesion::deserialize(msg));
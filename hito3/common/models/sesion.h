@@ -3,7 +3,9 @@
 #define SESION_CPP_H
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <cstdint>
 #include "protocol.h"
 
 class Sesion {
@@ -11,28 +13,30 @@ private:
     int id;
     int pelicula_id;
     int sala_id;
-    std::string hora_inicio;
-    std::string hora_fin;
+    int64_t hora_inicio;    // Segundos desde 1970-01-01 00:00:00, hora local sin zona
+    int64_t hora_fin;
 
 public:
     // Constructores
     Sesion();
     Sesion(int id, int pelicula_id, int sala_id, 
-           const std::string& hora_inicio, const std::string& hora_fin);
+           int64_t hora_inicio, int64_t hora_fin);
     
     // Getters
     int getId() const;
     int getPeliculaId() const;
     int getSalaId() const;
-    std::string getHoraInicio() const;
-    std::string getHoraFin() const;
+    int64_t getHoraInicio() const;
+    int64_t getHoraFin() const;
+    std::string getHoraInicioTexto() const;    // "YYYY-MM-DD HH:MM:SS"
+    std::string getHoraFinTexto() const;
     
     // Setters
     void setId(int id);
     void setPeliculaId(int pelicula_id);
     void setSalaId(int sala_id);
-    void setHoraInicio(const std::string& hora_inicio);
-    void setHoraFin(const std::string& hora_fin);
+    void setHoraInicio(int64_t hora_inicio);
+    void setHoraFin(int64_t hora_fin);
     
     // Serialización para el protocolo
     void serialize(Message& msg) const;
@@ -40,6 +44,11 @@ public:
     
     // Impresión
     std::string toString() const;
+    static std::string formatHora(int64_t hora);
+    
+    // Leer una hora "YYYY-MM-DD HH:MM:SS". Devuelve false si el texto no
+    // tiene exactamente ese formato o la fecha no es válida
+    static bool parseHora(std::string_view texto, int64_t* hora);
 };
 
 // Funciones para trabajar con colecciones de sesiones
@@ -1,76 +1,329 @@
 // protocol.cpp
 #include "protocol.h"
-#include <winsock2.h>
-#include <ws2tcpip.h>
+#include "socket_compat.h"
 #include <iostream>
 #include <cstring>
 #include <vector>
+#include <stdexcept>
+#include <charconv>
+#include <algorithm>
 
-Message::Message(OperationCode code, const std::string& content) : opCode(code), data(content) {}
+// Codificación little-endian de los campos del formato binario
+
+static void appendUint16(std::string& out, uint16_t value) {
+    out.push_back(static_cast<char>(value & 0xFF));
+    out.push_back(static_cast<char>((value >> 8) & 0xFF));
+}
+
+static void appendUint32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+static void appendUint64(std::string& out, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+static uint16_t readUint16(const char* p) {
+    const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+    return static_cast<uint16_t>(u[0] | (u[1] << 8));
+}
+
+static uint32_t readUint32(const char* p) {
+    const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; i--) {
+        value = (value << 8) | u[i];
+    }
+    return value;
+}
+
+static uint64_t readUint64(const char* p) {
+    const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--) {
+        value = (value << 8) | u[i];
+    }
+    return value;
+}
+
+// Convertir un campo de texto completo en un número. Un campo que solo empieza
+// por un número (p. ej. "2024-05-01 18:00:00" leído como entero) es inválido
+template <typename T>
+static bool parseNumber(std::string_view field, T& value) {
+    const char* end = field.data() + field.size();
+    std::from_chars_result result = std::from_chars(field.data(), end, value);
+    return result.ec == std::errc() && result.ptr == end;
+}
+
+Message::Message(OperationCode code, const std::string& content, WireFormat format)
+    : opCode(code), data(content), format(format), readPos(0) {}
+
+Message Message::createResponse(OperationCode code, const std::string& content) const {
+    return Message(code, content, format);
+}
 
 void Message::addString(const std::string& str) {
+    if (format == WIRE_BINARY) {
+        appendUint32(data, static_cast<uint32_t>(str.size()));
+        data += str;
+        return;
+    }
     data += str + SEPARATOR;
 }
 
 void Message::addInt(int value) {
+    if (format == WIRE_BINARY) {
+        appendUint32(data, static_cast<uint32_t>(value));
+        return;
+    }
+    data += std::to_string(value) + SEPARATOR;
+}
+
+void Message::addInt64(int64_t value) {
+    if (format == WIRE_BINARY) {
+        appendUint64(data, static_cast<uint64_t>(value));
+        return;
+    }
     data += std::to_string(value) + SEPARATOR;
 }
 
 void Message::addDouble(double value) {
+    if (format == WIRE_BINARY) {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        appendUint64(data, bits);
+        return;
+    }
     data += std::to_string(value) + SEPARATOR;
 }
 
 void Message::addBool(bool value) {
+    if (format == WIRE_BINARY) {
+        data.push_back(value ? 1 : 0);
+        return;
+    }
     data += (value ? "1" : "0") + std::string(1, SEPARATOR);
 }
 
-std::string Message::getString() {
-    size_t pos = data.find(SEPARATOR);
-    if (pos == std::string::npos) {
-        std::string result = data;
-        data.clear();
+void Message::addBytes(const std::string& bytes) {
+    if (format == WIRE_BINARY) {
+        addString(bytes);
+        return;
+    }
+    
+    static const char HEX[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(bytes.size() * 2);
+    for (unsigned char byte : bytes) {
+        hex.push_back(HEX[byte >> 4]);
+        hex.push_back(HEX[byte & 0x0F]);
+    }
+    addString(hex);
+}
+
+void Message::addMessage(const Message& msg) {
+    // El payload anidado va precedido de su longitud, así que puede contener
+    // separadores sin romper el mensaje exterior
+    addInt(static_cast<int>(msg.opCode));
+    addInt(static_cast<int>(msg.data.size() - msg.readPos));
+    data.append(msg.data, msg.readPos, std::string::npos);
+    if (format == WIRE_TEXT) {
+        data += SEPARATOR;
+    }
+}
+
+bool Message::takeBytes(size_t count, std::string_view& out) {
+    if (data.size() - readPos < count) {
+        readPos = data.size();
+        return false;
+    }
+    
+    out = std::string_view(data.data() + readPos, count);
+    readPos += count;
+    return true;
+}
+
+std::string_view Message::getStringView() {
+    if (format == WIRE_BINARY) {
+        std::string_view header;
+        std::string_view result;
+        if (!takeBytes(4, header) || !takeBytes(readUint32(header.data()), result)) {
+            return std::string_view();
+        }
         return result;
     }
     
-    std::string result = data.substr(0, pos);
-    data = data.substr(pos + 1);
-    return result;
+    std::string_view pending(data.data() + readPos, data.size() - readPos);
+    size_t pos = pending.find(SEPARATOR);
+    if (pos == std::string_view::npos) {
+        readPos = data.size();
+        return pending;
+    }
+    
+    readPos += pos + 1;
+    return pending.substr(0, pos);
+}
+
+std::string Message::getString() {
+    return std::string(getStringView());
 }
 
 int Message::getInt() {
-    return std::stoi(getString());
+    if (format == WIRE_BINARY) {
+        std::string_view bytes;
+        if (!takeBytes(4, bytes)) {
+            throw std::invalid_argument("Campo entero incompleto");
+        }
+        return static_cast<int32_t>(readUint32(bytes.data()));
+    }
+    
+    std::string_view field = getStringView();
+    int value = 0;
+    if (!parseNumber(field, value)) {
+        throw std::invalid_argument("Campo entero inválido");
+    }
+    return value;
+}
+
+int Message::getCount() {
+    int count = getInt();
+    if (count <= 0) {
+        return 0;
+    }
+    return static_cast<int>(std::min(static_cast<size_t>(count), remainingBytes()));
+}
+
+int64_t Message::getInt64() {
+    if (format == WIRE_BINARY) {
+        std::string_view bytes;
+        if (!takeBytes(8, bytes)) {
+            throw std::invalid_argument("Campo entero incompleto");
+        }
+        return static_cast<int64_t>(readUint64(bytes.data()));
+    }
+    
+    std::string_view field = getStringView();
+    int64_t value = 0;
+    if (!parseNumber(field, value)) {
+        throw std::invalid_argument("Campo entero inválido");
+    }
+    return value;
 }
 
 double Message::getDouble() {
-    return std::stod(getString());
+    if (format == WIRE_BINARY) {
+        std::string_view bytes;
+        if (!takeBytes(8, bytes)) {
+            throw std::invalid_argument("Campo decimal incompleto");
+        }
+        uint64_t bits = readUint64(bytes.data());
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    
+    std::string_view field = getStringView();
+    double value = 0.0;
+    if (!parseNumber(field, value)) {
+        throw std::invalid_argument("Campo decimal inválido");
+    }
+    return value;
 }
 
 bool Message::getBool() {
-    return getString() == "1";
+    if (format == WIRE_BINARY) {
+        std::string_view bytes;
+        return takeBytes(1, bytes) && bytes[0] != 0;
+    }
+    return getStringView() == "1";
+}
+
+std::string Message::getBytes() {
+    std::string_view field = getStringView();
+    if (format == WIRE_BINARY) {
+        return std::string(field);
+    }
+    
+    std::string bytes;
+    bytes.reserve(field.size() / 2);
+    for (size_t i = 0; i + 1 < field.size(); i += 2) {
+        unsigned int value = 0;
+        std::from_chars(field.data() + i, field.data() + i + 2, value, 16);
+        bytes.push_back(static_cast<char>(value));
+    }
+    return bytes;
+}
+
+Message Message::getMessage() {
+    OperationCode code = static_cast<OperationCode>(getInt());
+    int length = getInt();
+    
+    std::string_view payload;
+    if (length < 0 || !takeBytes(length, payload)) {
+        return Message(OP_ERROR, "Malformed message", format);
+    }
+    
+    if (format == WIRE_TEXT && readPos < data.size() && data[readPos] == SEPARATOR) {
+        readPos++;
+    }
+    
+    return Message(code, std::string(payload), format);
 }
 
 std::string Message::serialize() const {
+    if (format == WIRE_BINARY) {
+        std::string frame;
+        frame.reserve(BINARY_HEADER_SIZE + data.size());
+        appendUint16(frame, static_cast<uint16_t>(opCode));
+        appendUint16(frame, 0);
+        appendUint32(frame, static_cast<uint32_t>(data.size()));
+        frame += data;
+        return frame;
+    }
     return std::to_string(static_cast<int>(opCode)) + SEPARATOR + data + END_MESSAGE;
 }
 
-Message Message::deserialize(const std::string& serialized) {
+Message Message::deserialize(std::string_view serialized, WireFormat format) {
+    if (format == WIRE_BINARY) {
+        if (serialized.size() < BINARY_HEADER_SIZE) {
+            return Message(OP_ERROR, "Malformed message");
+        }
+        
+        OperationCode opCode = static_cast<OperationCode>(readUint16(serialized.data()));
+        uint32_t length = readUint32(serialized.data() + 4);
+        if (serialized.size() - BINARY_HEADER_SIZE < length) {
+            return Message(OP_ERROR, "Malformed message");
+        }
+        
+        return Message(opCode, std::string(serialized.substr(BINARY_HEADER_SIZE, length)), WIRE_BINARY);
+    }
+    
     size_t pos = serialized.find(SEPARATOR);
     if (pos == std::string::npos) {
         return Message(OP_ERROR, "Malformed message");
     }
     
-    OperationCode opCode = static_cast<OperationCode>(std::stoi(serialized.substr(0, pos)));
-    std::string content;
+    int code = 0;
+    if (!parseNumber(serialized.substr(0, pos), code)) {
+        return Message(OP_ERROR, "Malformed message");
+    }
+    
+    OperationCode opCode = static_cast<OperationCode>(code);
+    std::string_view content;
     
     if (pos + 1 < serialized.length()) {
         content = serialized.substr(pos + 1);
         // Eliminar el END_MESSAGE si existe
         if (!content.empty() && content.back() == END_MESSAGE) {
-            content.pop_back();
+            content.remove_suffix(1);
         }
     }
     
-    return Message(opCode, content);
+    return Message(opCode, std::string(content));
 }
 
 OperationCode Message::getOpCode() const {
@@ -78,25 +331,37 @@ OperationCode Message::getOpCode() const {
 }
 
 std::string Message::getData() const {
-    return data;
+    return data.substr(readPos);
+}
+
+WireFormat Message::getWireFormat() const {
+    return format;
 }
 
 void Message::clear() {
     data.clear();
+    readPos = 0;
 }
 
 bool Message::hasMoreData() const {
-    return !data.empty();
+    return readPos < data.size();
+}
+
+size_t Message::remainingBytes() const {
+    return data.size() - readPos;
 }
 
 bool sendMessage(int socket, const Message& msg) {
-    std::string serialized = msg.serialize();
+    return sendFrame(socket, msg.serialize());
+}
+
+bool sendFrame(int socket, const std::string& serialized) {
     int total = 0;
     int bytesLeft = serialized.length();
     int n;
 
     while (total < serialized.length()) {
-        n = send(socket, serialized.c_str() + total, bytesLeft, 0);
+        n = send(socket, serialized.c_str() + total, bytesLeft, MSG_NOSIGNAL);
         if (n == -1) { break; }
         total += n;
         bytesLeft -= n;
@@ -105,26 +370,124 @@ bool sendMessage(int socket, const Message& msg) {
     return n != -1;
 }
 
-Message receiveMessage(int socket) {
-    char buffer[BUFFER_SIZE];
-    std::string receivedData;
-    bool messageComplete = false;
+size_t frameLength(const char* buffer, size_t available, WireFormat format, size_t scanned) {
+    if (format == WIRE_BINARY) {
+        if (available < BINARY_HEADER_SIZE) {
+            return 0;
+        }
+        
+        uint32_t length = readUint32(buffer + 4);
+        if (length > MAX_BINARY_PAYLOAD) {
+            return std::string::npos;
+        }
+        
+        size_t total = BINARY_HEADER_SIZE + length;
+        return available >= total ? total : 0;
+    }
+    
+    // Solo se busca hasta el máximo de una trama: más allá ya sería inválida
+    size_t limit = std::min(available, MAX_TEXT_FRAME);
+    scanned = std::min(scanned, limit);
+    
+    const void* end = memchr(buffer + scanned, END_MESSAGE, limit - scanned);
+    if (end == nullptr) {
+        return available >= MAX_TEXT_FRAME ? std::string::npos : 0;
+    }
+    return static_cast<const char*>(end) - buffer + 1;
+}
+
+ReceiveBuffer::ReceiveBuffer() : readPos(0), scanned(0) {}
+
+void ReceiveBuffer::append(const char* bytes, size_t count) {
+    // Descartar lo ya entregado antes de crecer, para que el buffer no
+    // aumente indefinidamente en conexiones largas
+    if (readPos > 0 && (readPos == buffer.size() || readPos >= RECEIVE_CHUNK_SIZE)) {
+        buffer.erase(0, readPos);
+        readPos = 0;
+    }
+    buffer.append(bytes, count);
+}
+
+FrameStatus ReceiveBuffer::nextFrame(WireFormat format, Message& frame) {
+    size_t length = frameLength(buffer.data() + readPos, buffer.size() - readPos, format, scanned);
     
-    while (!messageComplete) {
-        memset(buffer, 0, BUFFER_SIZE);
-        int bytesReceived = recv(socket, buffer, BUFFER_SIZE - 1, 0);
+    if (length == 0) {
+        // La próxima búsqueda empieza donde acaba esta: cada byte de una
+        // trama de texto larga se revisa una sola vez
+        scanned = buffer.size() - readPos;
+        return FRAME_INCOMPLETE;
+    }
+    
+    if (length == std::string::npos) {
+        return FRAME_INVALID;
+    }
+    
+    frame = Message::deserialize(std::string_view(buffer).substr(readPos, length), format);
+    readPos += length;
+    scanned = 0;
+    
+    if (readPos == buffer.size()) {
+        buffer.clear();
+        readPos = 0;
+    }
+    
+    return FRAME_READY;
+}
+
+size_t ReceiveBuffer::pending() const {
+    return buffer.size() - readPos;
+}
+
+void ReceiveBuffer::clear() {
+    buffer.clear();
+    readPos = 0;
+    scanned = 0;
+}
+
+Message receiveMessage(int socket, ReceiveBuffer& buffer, WireFormat format) {
+    Message frame(OP_ERROR);
+    char chunk[RECEIVE_CHUNK_SIZE];
+    
+    while (true) {
+        // Primero se entregan las tramas que ya estuvieran en el buffer
+        FrameStatus status = buffer.nextFrame(format, frame);
+        if (status == FRAME_READY) {
+            return frame;
+        }
+        if (status == FRAME_INVALID) {
+            return Message(OP_ERROR, "Malformed message");
+        }
         
+        int bytesReceived = recv(socket, chunk, sizeof(chunk), 0);
         if (bytesReceived <= 0) {
             return Message(OP_ERROR, "Connection closed or error");
         }
         
-        receivedData.append(buffer, bytesReceived);
-        
-        // Comprobar si hemos recibido el mensaje completo
-        if (receivedData.find(END_MESSAGE) != std::string::npos) {
-            messageComplete = true;
+        buffer.append(chunk, bytesReceived);
+    }
+}
+
+Message negotiateWireFormat(Message& request, WireFormat* agreed) {
+    // Una versión ilegible se trata como la del formato texto
+    int requested = WIRE_TEXT;
+    try {
+        if (request.hasMoreData()) {
+            requested = request.getInt();
         }
+    } catch (const std::invalid_argument&) {
+        requested = WIRE_TEXT;
+    }
+    
+    WireFormat chosen = WIRE_TEXT;
+    if (requested >= WIRE_BINARY) {
+        chosen = MAX_WIRE_FORMAT;
+    }
+    
+    if (agreed != nullptr) {
+        *agreed = chosen;
     }
     
-    return Message::deserialize(receivedData);
+    Message response(OP_OK);
+    response.addInt(chosen);
+    return response;
 }
\ No newline at end of file
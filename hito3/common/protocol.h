@@ -3,12 +3,28 @@
 #define PROTOCOL_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <sstream>
 #include <cstring>
+#include <cstdint>
+
+// Formatos de trama del protocolo
+//   WIRE_TEXT   (v1): "opcode|campo|campo|...\n", todo como texto
+//   WIRE_BINARY (v2): cabecera fija + campos binarios little-endian
+enum WireFormat {
+    WIRE_TEXT = 1,
+    WIRE_BINARY = 2
+};
 
 // Códigos de operación para el protocolo
 enum OperationCode {
+    // Negociación del protocolo (siempre en formato texto)
+    OP_NEGOTIATE = 10,
+    
+    // Varias peticiones en una sola trama
+    OP_BATCH = 20,
+    
     // Operaciones de autenticación
     OP_LOGIN = 100,
     OP_LOGOUT = 101,
@@ -21,6 +37,7 @@ enum OperationCode {
     OP_PELICULA_DELETE = 204,
     OP_PELICULA_SEARCH_TITULO = 205,
     OP_PELICULA_SEARCH_GENERO = 206,
+    OP_PELICULA_SEARCH_GENEROS = 207,   // todos (AND) o alguno (OR), desde, límite, géneros
     
     // Operaciones de sesiones
     OP_SESION_LIST = 300,
@@ -31,6 +48,7 @@ enum OperationCode {
     OP_SESION_SEARCH_PELICULA = 305,
     OP_SESION_SEARCH_SALA = 306,
     OP_SESION_SEARCH_FECHA = 307,
+    OP_SESION_SEARCH_RANGO = 308,   // desde, hasta (int64), sala, película, límite (0 = sin filtro)
     
     // Operaciones de salas y asientos
     OP_SALA_LIST = 400,
@@ -44,6 +62,10 @@ enum OperationCode {
     OP_VENTA_LIST_BY_USER = 503,
     OP_VENTA_GET = 504,
     OP_VENTA_GET_BILLETES = 505,
+    OP_BILLETE_MAPA_OCUPACION = 506,
+    OP_SEAT_HOLD = 507,         // sesión, segundos (0 = por defecto), asientos
+    OP_SEAT_RELEASE = 508,      // retención
+    OP_SEAT_BEST = 509,         // sesión, asientos contiguos -> fila, asientos
     
     // Respuestas y errores
     OP_OK = 900,
@@ -55,42 +77,136 @@ class Message {
 private:
     OperationCode opCode;
     std::string data;
+    WireFormat format;
+    size_t readPos;     // Posición de lectura dentro de data
+    
+    // Extraer los siguientes bytes del payload binario
+    bool takeBytes(size_t count, std::string_view& out);
 
 public:
-    Message(OperationCode code, const std::string& content = "");
+    Message(OperationCode code, const std::string& content = "", WireFormat format = WIRE_TEXT);
+    
+    // Crear una respuesta en el mismo formato de trama que este mensaje
+    Message createResponse(OperationCode code, const std::string& content = "") const;
     
     // Métodos para añadir datos al mensaje
     void addString(const std::string& str);
     void addInt(int value);
+    void addInt64(int64_t value);
     void addDouble(double value);
     void addBool(bool value);
     
-    // Métodos para leer datos del mensaje
+    // Bytes arbitrarios (p. ej. mapas de bits). En binario van tal cual con
+    // su longitud; en texto se codifican en hexadecimal para no chocar con
+    // los separadores
+    void addBytes(const std::string& bytes);
+    
+    // Anidar un mensaje completo (código + payload) dentro de este, en el
+    // mismo formato de trama. Se usa para las peticiones agrupadas
+    void addMessage(const Message& msg);
+    
+    // Métodos para leer datos del mensaje. Avanzan un cursor sobre el
+    // payload sin copiarlo; la vista de getStringView solo es válida
+    // mientras el mensaje no se modifique ni se destruya
+    std::string_view getStringView();
     std::string getString();
     int getInt();
+    int64_t getInt64();
     double getDouble();
     bool getBool();
+    std::string getBytes();
+    Message getMessage();
+    
+    // Leer el número de elementos de una lista que sigue en el mensaje.
+    // Cada elemento ocupa al menos un byte, así que el resultado se limita a
+    // los bytes que quedan: un contador negativo o corrupto no puede
+    // provocar una reserva desproporcionada
+    int getCount();
     
     // Métodos para serializar/deserializar
     std::string serialize() const;
-    static Message deserialize(const std::string& data);
+    static Message deserialize(std::string_view data, WireFormat format = WIRE_TEXT);
     
     // Getters
     OperationCode getOpCode() const;
-    std::string getData() const;
+    std::string getData() const;        // Datos aún no leídos
+    WireFormat getWireFormat() const;
     
     // Utilidades
     void clear();
     bool hasMoreData() const;
+    size_t remainingBytes() const;
+};
+
+// Resultado de intentar extraer una trama del buffer de recepción
+enum FrameStatus {
+    FRAME_INCOMPLETE,   // Faltan bytes para completar la siguiente trama
+    FRAME_READY,        // Se ha extraído una trama completa
+    FRAME_INVALID       // La cabecera es inválida; la conexión debe cerrarse
+};
+
+// Buffer de recepción de una conexión. Se conserva entre llamadas para que
+// los bytes recibidos después de una trama (peticiones encadenadas o tramas
+// partidas entre varios recv) no se pierdan: cada recv puede dar lugar a
+// cero, una o varias tramas completas
+class ReceiveBuffer {
+private:
+    std::string buffer;
+    size_t readPos;     // Bytes del buffer ya entregados como tramas
+    size_t scanned;     // Bytes pendientes ya revisados sin encontrar el fin de trama
+
+public:
+    ReceiveBuffer();
+    
+    // Añadir bytes recibidos del socket
+    void append(const char* bytes, size_t count);
+    
+    // Extraer la siguiente trama completa, si la hay
+    FrameStatus nextFrame(WireFormat format, Message& frame);
+    
+    // Bytes recibidos que aún no forman una trama
+    size_t pending() const;
+    
+    void clear();
 };
 
 // Funciones de comunicación
 bool sendMessage(int socket, const Message& msg);
-Message receiveMessage(int socket);
+bool sendFrame(int socket, const std::string& frame);      // Trama ya serializada
+Message receiveMessage(int socket, ReceiveBuffer& buffer, WireFormat format = WIRE_TEXT);
+
+// Longitud de la primera trama completa de un buffer, o 0 si aún está incompleta.
+// Devuelve std::string::npos si la cabecera binaria es inválida o la trama
+// supera el tamaño máximo. En texto, los primeros scanned bytes ya se
+// revisaron en una llamada anterior y no se vuelven a buscar
+size_t frameLength(const char* buffer, size_t available, WireFormat format, size_t scanned = 0);
+
+// Atender una petición OP_NEGOTIATE: elige la versión más alta que soportan
+// ambos extremos. La respuesta se envía en texto y, a partir de ella, la
+// conexión usa el formato acordado
+Message negotiateWireFormat(Message& request, WireFormat* agreed);
 
 // Constantes
 const int BUFFER_SIZE = 4096;
+const size_t RECEIVE_CHUNK_SIZE = 64 * 1024;    // Bytes pedidos en cada recv
 const char SEPARATOR = '|';
 const char END_MESSAGE = '\n';
 
+// Trama binaria: opcode (u16) + flags (u16) + longitud del payload (u32)
+const size_t BINARY_HEADER_SIZE = 8;
+const uint32_t MAX_BINARY_PAYLOAD = 64 * 1024 * 1024;
+
+// Trama de texto más larga que se acepta, fin de trama incluido. Sin este
+// límite, un extremo que nunca envía '\n' haría crecer el buffer sin fin
+const size_t MAX_TEXT_FRAME = 64 * 1024 * 1024;
+const WireFormat MAX_WIRE_FORMAT = WIRE_BINARY;
+
+// Máximo de peticiones en una trama OP_BATCH
+const int MAX_BATCH_SIZE = 1024;
+
+// Texto del OP_ERROR con el que el servidor responde a un código de
+// operación que no conoce. El cliente lo usa para detectar servidores sin
+// soporte para OP_BATCH
+const char* const ERROR_UNSUPPORTED_OPERATION = "Operación no soportada";
+
 #endif // PROTOCOL_H
\ No newline at end of file
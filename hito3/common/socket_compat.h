@@ -0,0 +1,107 @@
+// socket_compat.h
+#ifndef SOCKET_COMPAT_H
+#define SOCKET_COMPAT_H
+
+// Capa mínima de compatibilidad de sockets.
+// En Windows se usa Winsock directamente. En Linux/POSIX se definen los
+// equivalentes de las llamadas de Winsock que usa el proyecto, de modo que
+// el resto del código pueda seguir escrito con los mismos nombres.
+
+#ifdef _WIN32
+
+// WSAPoll necesita Windows Vista o posterior
+#ifndef _WIN32_WINNT
+#define _WIN32_WINNT 0x0600
+#endif
+
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+typedef WSAPOLLFD pollfd;
+
+inline int poll(pollfd* fds, unsigned long count, int timeout) {
+    return WSAPoll(fds, count, timeout);
+}
+
+#else
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+
+#ifndef INVALID_SOCKET
+#define INVALID_SOCKET (-1)
+#endif
+
+#ifndef SOCKET_ERROR
+#define SOCKET_ERROR (-1)
+#endif
+
+#ifndef SD_BOTH
+#define SD_BOTH SHUT_RDWR
+#endif
+
+inline int closesocket(int socket) {
+    return close(socket);
+}
+
+inline int WSAGetLastError() {
+    return errno;
+}
+
+inline int WSACleanup() {
+    return 0;
+}
+
+#endif // _WIN32
+
+// Poner un socket en modo no bloqueante
+inline bool setSocketNonBlocking(int socket) {
+#ifdef _WIN32
+    u_long mode = 1;
+    return ioctlsocket(socket, FIONBIO, &mode) == 0;
+#else
+    int flags = fcntl(socket, F_GETFL, 0);
+    if (flags == -1) {
+        return false;
+    }
+    return fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+// Volver a poner un socket en modo bloqueante (en Windows los sockets
+// aceptados heredan el modo del socket de escucha)
+inline bool setSocketBlocking(int socket) {
+#ifdef _WIN32
+    u_long mode = 0;
+    return ioctlsocket(socket, FIONBIO, &mode) == 0;
+#else
+    int flags = fcntl(socket, F_GETFL, 0);
+    if (flags == -1) {
+        return false;
+    }
+    return fcntl(socket, F_SETFL, flags & ~O_NONBLOCK) == 0;
+#endif
+}
+
+// Indicar si la última llamada sobre un socket no bloqueante falló solo
+// porque no había nada que hacer todavía
+inline bool socketWouldBlock() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+}
+
+#endif // SOCKET_COMPAT_H
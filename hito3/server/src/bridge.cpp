@@ -10,6 +10,7 @@
 
 // Incluir las cabeceras de C necesarias
 extern "C" {
+    #include "../../hito2/src/config.h"
     #include "../../hito2/src/database.h"
     #include "../../hito2/src/models/pelicula.h"
     #include "../../hito2/src/models/sesion.h"
@@ -17,19 +18,62 @@ extern "C" {
     #include "../../hito2/src/models/asiento.h"
     #include "../../hito2/src/models/billete.h"
     #include "../../hito2/src/models/venta.h"
+    #include "../../hito2/src/models/ocupacion.h"
+    #include "../../hito2/src/models/retencion.h"
+    #include "../../hito2/src/models/horario.h"
+    #include "../../hito2/src/models/titulos.h"
+    #include "../../hito2/src/models/generos.h"
     #include "../../hito2/src/models/usuario.h"
     #include "../../hito2/src/auth.h"
     #include "../../hito2/src/utils/logger.h"
 }
 
+// La capa C usa un pool de conexiones: cada hilo trabajador lee con su
+// propia conexión de solo lectura y las escrituras se envían al hilo escritor
+
+// Asociar al hilo actual su conexión de lectura
+static bool useReader() {
+    if (!db_reader_attach()) {
+        log_error("No se pudo abrir la conexión de lectura del hilo");
+        return false;
+    }
+    return true;
+}
+
+// Ejecutar una operación de escritura en el hilo escritor de la capa C
+template <typename Operation>
+static bool runWrite(Operation operation) {
+    return db_write([](void* arg) -> bool {
+        return (*static_cast<Operation*>(arg))();
+    }, &operation);
+}
+
+// Como runWrite, pero la operación puede compartir transacción con otras
+// que lleguen a la vez. undo se llama si la transacción del grupo no llega
+// a confirmarse después de que la operación terminase bien
+template <typename Operation, typename Undo>
+static bool runGroupedWrite(Operation operation, Undo undo) {
+    struct Task {
+        Operation& operation;
+        Undo& undo;
+    } task{operation, undo};
+    
+    return db_write_grouped([](void* arg) -> bool {
+        return static_cast<Task*>(arg)->operation();
+    }, [](void* arg) {
+        static_cast<Task*>(arg)->undo();
+    }, &task);
+}
+
 // Inicialización y cierre
 bool bridge_init_db(const char* db_path) {
     // Inicialización de log
     log_init("logs/server.log", LOG_INFO);
+    log_set_overflow(log_overflow_from_string(get_config()->log_overflow));
     log_info("Inicializando la base de datos: %s", db_path);
     
     // Inicialización de base de datos
-    bool result = db_init(db_path);
+    bool result = db_init(db_path) && db_pool_start();
     
     if (!result) {
         log_error("Error al inicializar la base de datos");
@@ -44,12 +88,32 @@ bool bridge_init_db(const char* db_path) {
 }
 
 void bridge_close_db() {
+    retencion_limpiar();
+    ocupacion_limpiar();
+    horario_limpiar();
+    titulos_limpiar();
+    generos_limpiar();
     db_close();
     log_close();
 }
 
+bool bridge_get_server_config(int* port, int* worker_threads) {
+    Config* config = get_config();
+    if (!config || !validate_config(config)) {
+        return false;
+    }
+    
+    *port = config->server_port;
+    *worker_threads = config->worker_threads;
+    return true;
+}
+
 // Autenticación
 int bridge_login(const char* email, const char* password) {
+    if (!useReader()) {
+        return -1;
+    }
+    
     Usuario usuario;
     if (usuario_autenticar(email, password, &usuario)) {
         return usuario.id;
@@ -58,6 +122,10 @@ int bridge_login(const char* email, const char* password) {
 }
 
 int bridge_user_get_type(int userId) {
+    if (!useReader()) {
+        return -1;
+    }
+    
     Usuario usuario;
     if (usuario_obtener_por_id(userId, &usuario)) {
         return static_cast<int>(usuario.tipo);
@@ -66,6 +134,10 @@ int bridge_user_get_type(int userId) {
 }
 
 std::string bridge_user_get_name(int userId) {
+    if (!useReader()) {
+        return "";
+    }
+    
     Usuario usuario;
     if (usuario_obtener_por_id(userId, &usuario)) {
         return usuario.nombre;
@@ -79,6 +151,10 @@ bool bridge_user_is_admin(int userId) {
 
 // Películas
 bool bridge_pelicula_list(std::vector<Pelicula>* peliculas, int* num_peliculas) {
+    if (!useReader()) {
+        return false;
+    }
+    
     Pelicula* c_peliculas = nullptr;
     int c_num_peliculas = 0;
     
@@ -107,6 +183,10 @@ bool bridge_pelicula_list(std::vector<Pelicula>* peliculas, int* num_peliculas)
 }
 
 bool bridge_pelicula_get_by_id(int id, Pelicula* pelicula) {
+    if (!useReader()) {
+        return false;
+    }
+    
     Pelicula c_pelicula;
     bool result = pelicula_obtener_por_id(id, &c_pelicula);
     
@@ -127,7 +207,7 @@ bool bridge_pelicula_create(Pelicula* pelicula) {
     c_pelicula.duracion = pelicula->getDuracion();
     strncpy(c_pelicula.genero, pelicula->getGenero().c_str(), sizeof(c_pelicula.genero) - 1);
     
-    bool result = pelicula_crear(&c_pelicula);
+    bool result = runWrite([&] { return pelicula_crear(&c_pelicula); });
     
     if (result) {
         pelicula->setId(c_pelicula.id);
@@ -143,14 +223,18 @@ bool bridge_pelicula_update(Pelicula* pelicula) {
     c_pelicula.duracion = pelicula->getDuracion();
     strncpy(c_pelicula.genero, pelicula->getGenero().c_str(), sizeof(c_pelicula.genero) - 1);
     
-    return pelicula_actualizar(&c_pelicula);
+    return runWrite([&] { return pelicula_actualizar(&c_pelicula); });
 }
 
 bool bridge_pelicula_delete(int id) {
-    return pelicula_eliminar(id);
+    return runWrite([&] { return pelicula_eliminar(id); });
 }
 
 bool bridge_pelicula_search_by_titulo(const char* titulo, std::vector<Pelicula>* peliculas, int* num_peliculas) {
+    if (!useReader()) {
+        return false;
+    }
+    
     Pelicula* c_peliculas = nullptr;
     int c_num_peliculas = 0;
     
@@ -180,6 +264,10 @@ bool bridge_pelicula_search_by_titulo(const char* titulo, std::vector<Pelicula>*
 }
 
 bool bridge_pelicula_search_by_genero(const char* genero, std::vector<Pelicula>* peliculas, int* num_peliculas) {
+    if (!useReader()) {
+        return false;
+    }
+    
     Pelicula* c_peliculas = nullptr;
     int c_num_peliculas = 0;
     
@@ -208,8 +296,51 @@ bool bridge_pelicula_search_by_genero(const char* genero, std::vector<Pelicula>*
     return result;
 }
 
+bool bridge_pelicula_search_by_generos(const std::vector<std::string>& generos, bool todos, int desde, int limite,
+                                       std::vector<Pelicula>* peliculas, int* total) {
+    if (!useReader()) {
+        return false;
+    }
+    
+    std::vector<const char*> c_generos;
+    c_generos.reserve(generos.size());
+    for (const auto& genero : generos) {
+        c_generos.push_back(genero.c_str());
+    }
+    
+    Pelicula* c_peliculas = nullptr;
+    int c_num_peliculas = 0;
+    
+    bool result = generos_buscar(c_generos.data(), static_cast<int>(c_generos.size()),
+                                 todos ? GENEROS_TODOS : GENEROS_ALGUNO, desde, limite,
+                                 &c_peliculas, &c_num_peliculas, total);
+    
+    peliculas->clear();
+    
+    if (result && c_num_peliculas > 0) {
+        peliculas->reserve(c_num_peliculas);
+        
+        for (int i = 0; i < c_num_peliculas; i++) {
+            peliculas->emplace_back(
+                c_peliculas[i].id,
+                c_peliculas[i].titulo,
+                c_peliculas[i].duracion,
+                c_peliculas[i].genero
+            );
+        }
+        
+        pelicula_liberar_lista(c_peliculas, c_num_peliculas);
+    }
+    
+    return result;
+}
+
 // Sesiones
 bool bridge_sesion_list(std::vector<Sesion>* sesiones, int* num_sesiones) {
+    if (!useReader()) {
+        return false;
+    }
+    
     Sesion* c_sesiones = nullptr;
     int c_num_sesiones = 0;
     
@@ -223,8 +354,8 @@ bool bridge_sesion_list(std::vector<Sesion>* sesiones, int* num_sesiones) {
                 c_sesiones[i].id,
                 c_sesiones[i].pelicula_id,
                 c_sesiones[i].sala_id,
-                c_sesiones[i].hora_inicio,
-                c_sesiones[i].hora_fin
+                c_sesiones[i].inicio,
+                c_sesiones[i].fin
             );
             
             sesiones->push_back(sesion);
@@ -243,6 +374,10 @@ bool bridge_sesion_list(std::vector<Sesion>* sesiones, int* num_sesiones) {
 // Por ejemplo:
 
 bool bridge_sesion_get_by_id(int id, Sesion* sesion) {
+    if (!useReader()) {
+        return false;
+    }
+    
     Sesion c_sesion;
     bool result = sesion_obtener_por_id(id, &c_sesion);
     
@@ -250,17 +385,121 @@ bool bridge_sesion_get_by_id(int id, Sesion* sesion) {
         sesion->setId(c_sesion.id);
         sesion->setPeliculaId(c_sesion.pelicula_id);
         sesion->setSalaId(c_sesion.sala_id);
-        sesion->setHoraInicio(c_sesion.hora_inicio);
-        sesion->setHoraFin(c_sesion.hora_fin);
+        sesion->setHoraInicio(c_sesion.inicio);
+        sesion->setHoraFin(c_sesion.fin);
+    }
+    
+    return result;
+}
+
+bool bridge_sesion_search_by_rango(int64_t desde, int64_t hasta, int sala_id, int pelicula_id, int limite,
+                                   std::vector<Sesion>* sesiones, int* num_sesiones) {
+    if (!useReader()) {
+        return false;
+    }
+    
+    Sesion* c_sesiones = nullptr;
+    int c_num_sesiones = 0;
+    
+    bool result = sesion_buscar_por_rango(desde, hasta, sala_id, pelicula_id, limite,
+                                          &c_sesiones, &c_num_sesiones);
+    
+    sesiones->clear();
+    *num_sesiones = 0;
+    
+    if (result && c_num_sesiones > 0) {
+        sesiones->reserve(c_num_sesiones);
+        
+        for (int i = 0; i < c_num_sesiones; i++) {
+            sesiones->emplace_back(
+                c_sesiones[i].id,
+                c_sesiones[i].pelicula_id,
+                c_sesiones[i].sala_id,
+                c_sesiones[i].inicio,
+                c_sesiones[i].fin
+            );
+        }
+        
+        *num_sesiones = c_num_sesiones;
+        sesion_liberar_lista(c_sesiones, c_num_sesiones);
+    }
+    
+    return result;
+}
+
+// Salas
+bool bridge_sala_list(std::vector<int>* salaIds, std::vector<int>* numAsientos, int* num_salas) {
+    if (!useReader()) {
+        return false;
+    }
+    
+    Sala* c_salas = nullptr;
+    int c_num_salas = 0;
+    
+    bool result = sala_listar(&c_salas, &c_num_salas);
+    
+    salaIds->clear();
+    numAsientos->clear();
+    *num_salas = 0;
+    
+    if (result && c_num_salas > 0) {
+        salaIds->reserve(c_num_salas);
+        numAsientos->reserve(c_num_salas);
+        
+        for (int i = 0; i < c_num_salas; i++) {
+            salaIds->push_back(c_salas[i].id);
+            numAsientos->push_back(c_salas[i].numero_asientos);
+        }
+        
+        *num_salas = c_num_salas;
+        sala_liberar_lista(c_salas, c_num_salas);
+    }
+    
+    return result;
+}
+
+bool bridge_sala_get_by_id(int id, int* numAsientos) {
+    if (!useReader()) {
+        return false;
+    }
+    
+    Sala c_sala;
+    bool result = sala_obtener_por_id(id, &c_sala);
+    
+    if (result) {
+        *numAsientos = c_sala.numero_asientos;
     }
     
     return result;
 }
 
 bool bridge_billete_esta_disponible(int sesion_id, int asiento_id) {
+    if (!useReader()) {
+        return false;
+    }
+    
     return billete_esta_disponible(sesion_id, asiento_id);
 }
 
+bool bridge_billete_mapa_ocupacion(int sesion_id, int* sala_id, int* num_asientos, std::string* mapa) {
+    if (!useReader()) {
+        return false;
+    }
+    
+    
+    MapaOcupacion c_mapa;
+    if (!ocupacion_obtener_mapa(sesion_id, &c_mapa)) {
+        return false;
+    }
+    
+    *sala_id = c_mapa.sala_id;
+    *num_asientos = c_mapa.num_asientos;
+    mapa->assign(reinterpret_cast<const char*>(c_mapa.mapa), (c_mapa.num_asientos + 7) / 8);
+    
+    ocupacion_liberar_mapa(&c_mapa);
+    return true;
+}
+
 int bridge_venta_create(int usuario_id, int* sesion_ids, int* asiento_ids, int num_billetes, double descuento) {
     // Crear los billetes
     Billete* billetes = (Billete*)malloc(num_billetes * sizeof(Billete));
@@ -285,8 +524,17 @@ int bridge_venta_create(int usuario_id, int* sesion_ids, int* asiento_ids, int n
     // La hora actual se establece en venta_crear
     venta.fecha[0] = '\0';
     
-    // Crear la venta con los billetes
-    if (venta_crear(&venta, billetes, num_billetes)) {
+    // Crear la venta con los billetes. Las ventas simultáneas se confirman
+    // juntas; si el grupo falla, los asientos reservados vuelven al inventario
+    bool created = runGroupedWrite([&] {
+        return venta_crear(&venta, billetes, num_billetes);
+    }, [&] {
+        for (int i = 0; i < num_billetes; i++) {
+            ocupacion_liberar_asientos(billetes[i].sesion_id, &billetes[i].asiento_id, 1);
+        }
+    });
+    
+    if (created) {
         free(billetes);
         return venta.id;
     }
@@ -295,4 +543,82 @@ int bridge_venta_create(int usuario_id, int* sesion_ids, int* asiento_ids, int n
     return -1;
 }
 
+bool bridge_seat_hold(int usuario_id, int sesion_id, const std::vector<int>& asiento_ids, int segundos,
+                      int* retencion_id, int64_t* vence) {
+    // El inventario de la sesión puede tener que cargarse de la base de datos
+    if (!useReader()) {
+        return false;
+    }
+    
+    return retencion_crear(usuario_id, sesion_id, asiento_ids.data(), static_cast<int>(asiento_ids.size()),
+                           segundos, retencion_id, vence);
+}
+
+bool bridge_seat_hold_fits(int usuario_id, int num_asientos) {
+    return retencion_cabe(usuario_id, num_asientos);
+}
+
+bool bridge_seat_release(int usuario_id, int retencion_id) {
+    return retencion_liberar(retencion_id, usuario_id);
+}
+
+bool bridge_seat_best(int sesion_id, int num_asientos, std::vector<int>* asiento_ids, int* fila) {
+    if (!useReader()) {
+        return false;
+    }
+    
+    asiento_ids->resize(num_asientos);
+    if (!ocupacion_mejores_asientos(sesion_id, num_asientos, asiento_ids->data(), fila)) {
+        asiento_ids->clear();
+        return false;
+    }
+    
+    return true;
+}
+
+int bridge_venta_create_from_hold(int usuario_id, int retencion_id, double descuento) {
+    // Al retirarla ya no puede vencer: sus asientos siguen retenidos para esta venta
+    Retencion retencion;
+    if (!retencion_tomar(retencion_id, usuario_id, &retencion)) {
+        return -1;
+    }
+    
+    Billete billetes[RETENCION_MAX_ASIENTOS];
+    for (int i = 0; i < retencion.num_asientos; i++) {
+        billetes[i].id = 0;  // Será asignado por la base de datos
+        billetes[i].sesion_id = retencion.sesion_id;
+        billetes[i].asiento_id = retencion.asiento_ids[i];
+        billetes[i].precio = billete_calcular_precio_base(retencion.sesion_id);
+    }
+    
+    Venta venta;
+    venta.id = 0;  // Será asignado por la base de datos
+    venta.usuario_id = usuario_id;
+    venta.descuento = descuento;
+    venta.fecha[0] = '\0';
+    
+    // Los asientos se validaron y reservaron al retenerlos, así que la venta
+    // solo escribe. Si no llega a confirmarse, vuelven a quedar libres
+    bool liberados = false;
+    auto liberar = [&] {
+        if (!liberados) {
+            ocupacion_soltar_retenidos(retencion.sesion_id, retencion.asiento_ids, retencion.num_asientos);
+            liberados = true;
+        }
+    };
+    
+    bool created = runGroupedWrite([&] {
+        return venta_crear_reservada(&venta, billetes, retencion.num_asientos);
+    }, liberar);
+    
+    if (!created) {
+        liberar();
+        return -1;
+    }
+    
+    // Ya hay billetes: los asientos dejan de depender de la retención
+    ocupacion_confirmar_retenidos(retencion.sesion_id, retencion.asiento_ids, retencion.num_asientos);
+    return venta.id;
+}
+
 // Continúa implementando el resto de funciones del bridge...
\ No newline at end of file
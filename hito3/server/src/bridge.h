@@ -11,6 +11,9 @@
 bool bridge_init_db(const char* db_path);
 void bridge_close_db();
 
+// Configuración del servidor (sección [server] de config.ini)
+bool bridge_get_server_config(int* port, int* worker_threads);
+
 // Funciones de autenticación
 int bridge_login(const char* email, const char* password);
 int bridge_user_get_type(int userId);
@@ -25,6 +28,8 @@ bool bridge_pelicula_update(Pelicula* pelicula);
 bool bridge_pelicula_delete(int id);
 bool bridge_pelicula_search_by_titulo(const char* titulo, std::vector<Pelicula>* peliculas, int* num_peliculas);
 bool bridge_pelicula_search_by_genero(const char* genero, std::vector<Pelicula>* peliculas, int* num_peliculas);
+bool bridge_pelicula_search_by_generos(const std::vector<std::string>& generos, bool todos, int desde, int limite,
+                                       std::vector<Pelicula>* peliculas, int* total);
 
 // Funciones de sesiones
 bool bridge_sesion_list(std::vector<Sesion>* sesiones, int* num_sesiones);
@@ -35,6 +40,8 @@ bool bridge_sesion_delete(int id);
 bool bridge_sesion_search_by_pelicula(int pelicula_id, std::vector<Sesion>* sesiones, int* num_sesiones);
 bool bridge_sesion_search_by_sala(int sala_id, std::vector<Sesion>* sesiones, int* num_sesiones);
 bool bridge_sesion_search_by_fecha(const char* fecha, std::vector<Sesion>* sesiones, int* num_sesiones);
+bool bridge_sesion_search_by_rango(int64_t desde, int64_t hasta, int sala_id, int pelicula_id, int limite,
+                                   std::vector<Sesion>* sesiones, int* num_sesiones);
 
 // Funciones de salas
 bool bridge_sala_list(std::vector<int>* salaIds, std::vector<int>* numAsientos, int* num_salas);
@@ -44,9 +51,18 @@ bool bridge_asiento_list_by_sala(int sala_id, std::vector<int>* asientoIds, std:
 // Funciones de billetes y ventas
 bool bridge_billete_create(int sesion_id, int asiento_id, double precio);
 bool bridge_billete_esta_disponible(int sesion_id, int asiento_id);
+bool bridge_billete_mapa_ocupacion(int sesion_id, int* sala_id, int* num_asientos, std::string* mapa);
 int bridge_venta_create(int usuario_id, int* sesion_ids, int* asiento_ids, int num_billetes, double descuento);
 bool bridge_venta_list_by_user(int usuario_id, std::vector<int>* venta_ids, std::vector<std::string>* fechas, std::vector<double>* totales, int* num_ventas);
 bool bridge_venta_get(int venta_id, int* usuario_id, std::string* fecha, double* descuento, double* total);
 bool bridge_venta_get_billetes(int venta_id, std::vector<int>* sesion_ids, std::vector<int>* asiento_ids, std::vector<double>* precios, int* num_billetes);
 
+// Retenciones temporales de asientos
+bool bridge_seat_hold(int usuario_id, int sesion_id, const std::vector<int>& asiento_ids, int segundos,
+                      int* retencion_id, int64_t* vence);
+bool bridge_seat_hold_fits(int usuario_id, int num_asientos);
+bool bridge_seat_release(int usuario_id, int retencion_id);
+bool bridge_seat_best(int sesion_id, int num_asientos, std::vector<int>* asiento_ids, int* fila);
+int bridge_venta_create_from_hold(int usuario_id, int retencion_id, double descuento);
+
 #endif // BRIDGE_H
\ No newline at end of file
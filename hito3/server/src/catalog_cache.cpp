@@ -0,0 +1,148 @@
+// catalog_cache.cpp
+#include "catalog_cache.h"
+#include "bridge.h"
+
+static int catalogId(const Pelicula& pelicula) {
+    return pelicula.getId();
+}
+
+static int catalogId(const Sesion& sesion) {
+    return sesion.getId();
+}
+
+static int catalogId(const SalaInfo& sala) {
+    return sala.id;
+}
+
+CatalogCache::CatalogCache() : catalogVersion(0) {
+    for (auto& version : partVersions) {
+        version.store(0);
+    }
+}
+
+template <typename T, typename Loader>
+std::shared_ptr<const CatalogSnapshot<T>> CatalogCache::acquire(std::shared_ptr<const CatalogSnapshot<T>>& slot,
+                                                                CatalogPart part, Loader load) {
+    std::shared_ptr<const CatalogSnapshot<T>> snapshot = std::atomic_load(&slot);
+    if (snapshot && snapshot->version == partVersions[part].load(std::memory_order_acquire)) {
+        return snapshot;
+    }
+    
+    std::lock_guard<std::mutex> lock(loadMutexes[part]);
+    
+    // Otro lector puede haberla cargado mientras se esperaba el turno
+    uint64_t version = partVersions[part].load(std::memory_order_acquire);
+    snapshot = std::atomic_load(&slot);
+    if (snapshot && snapshot->version == version) {
+        return snapshot;
+    }
+    
+    auto fresh = std::make_shared<CatalogSnapshot<T>>();
+    fresh->version = version;
+    if (!load(fresh->items)) {
+        return nullptr;
+    }
+    
+    fresh->byId.reserve(fresh->items.size());
+    for (size_t i = 0; i < fresh->items.size(); i++) {
+        fresh->byId[catalogId(fresh->items[i])] = i;
+    }
+    
+    // Si hubo una escritura durante la carga puede que la copia no la
+    // incluya: sirve para esta lectura, pero no se publica
+    if (partVersions[part].load(std::memory_order_acquire) == version) {
+        std::atomic_store(&slot, std::shared_ptr<const CatalogSnapshot<T>>(fresh));
+    }
+    
+    return fresh;
+}
+
+std::shared_ptr<const CatalogCache::PeliculaSnapshot> CatalogCache::peliculas() {
+    return acquire(peliculaSnapshot, CATALOG_PELICULAS, [](std::vector<Pelicula>& items) {
+        int numPeliculas = 0;
+        return bridge_pelicula_list(&items, &numPeliculas);
+    });
+}
+
+std::shared_ptr<const CatalogCache::SesionSnapshot> CatalogCache::sesiones() {
+    return acquire(sesionSnapshot, CATALOG_SESIONES, [](std::vector<Sesion>& items) {
+        int numSesiones = 0;
+        return bridge_sesion_list(&items, &numSesiones);
+    });
+}
+
+std::shared_ptr<const CatalogCache::SalaSnapshot> CatalogCache::salas() {
+    return acquire(salaSnapshot, CATALOG_SALAS, [](std::vector<SalaInfo>& items) {
+        std::vector<int> salaIds;
+        std::vector<int> numAsientos;
+        int numSalas = 0;
+        
+        if (!bridge_sala_list(&salaIds, &numAsientos, &numSalas)) {
+            return false;
+        }
+        
+        items.reserve(numSalas);
+        for (int i = 0; i < numSalas; i++) {
+            items.push_back({salaIds[i], numAsientos[i]});
+        }
+        return true;
+    });
+}
+
+bool CatalogCache::getPelicula(int id, Pelicula* pelicula) {
+    auto snapshot = peliculas();
+    if (!snapshot) {
+        return false;
+    }
+    
+    auto it = snapshot->byId.find(id);
+    if (it == snapshot->byId.end()) {
+        return false;
+    }
+    
+    *pelicula = snapshot->items[it->second];
+    return true;
+}
+
+bool CatalogCache::getSesion(int id, Sesion* sesion) {
+    auto snapshot = sesiones();
+    if (!snapshot) {
+        return false;
+    }
+    
+    auto it = snapshot->byId.find(id);
+    if (it == snapshot->byId.end()) {
+        return false;
+    }
+    
+    *sesion = snapshot->items[it->second];
+    return true;
+}
+
+bool CatalogCache::getSala(int id, SalaInfo* sala) {
+    auto snapshot = salas();
+    if (!snapshot) {
+        return false;
+    }
+    
+    auto it = snapshot->byId.find(id);
+    if (it == snapshot->byId.end()) {
+        return false;
+    }
+    
+    *sala = snapshot->items[it->second];
+    return true;
+}
+
+void CatalogCache::invalidate(CatalogPart part) {
+    partVersions[part].fetch_add(1, std::memory_order_acq_rel);
+    catalogVersion.fetch_add(1, std::memory_order_acq_rel);
+}
+
+uint64_t CatalogCache::version(CatalogPart part) const {
+    return partVersions[part].load(std::memory_order_acquire);
+}
+
+uint64_t CatalogCache::version() const {
+    return catalogVersion.load(std::memory_order_acquire);
+}
\ No newline at end of file
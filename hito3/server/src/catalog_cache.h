@@ -0,0 +1,84 @@
+// catalog_cache.h
+#ifndef CATALOG_CACHE_H
+#define CATALOG_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "../common/models/pelicula.h"
+#include "../common/models/sesion.h"
+
+// Partes del catálogo que se invalidan por separado
+enum CatalogPart {
+    CATALOG_PELICULAS = 0,
+    CATALOG_SESIONES = 1,
+    CATALOG_SALAS = 2,
+    CATALOG_NUM_PARTS = 3
+};
+
+// Sala tal como se guarda en el catálogo
+struct SalaInfo {
+    int id;
+    int numAsientos;
+};
+
+// Copia inmutable de una parte del catálogo. Un lector que tenga el
+// shared_ptr puede seguir usándola aunque se publique otra más nueva
+template <typename T>
+struct CatalogSnapshot {
+    uint64_t version;
+    std::vector<T> items;
+    std::unordered_map<int, size_t> byId;   // id -> posición en items
+};
+
+// Caché en memoria de películas, sesiones y salas. Las lecturas se sirven de
+// la última copia publicada de cada parte; si falta o su versión ya no es la
+// actual, la primera lectura la vuelve a cargar de la base de datos y las
+// demás esperan a esa carga en vez de repetirla. Las escrituras solo suben la
+// versión de la parte que cambian, así que nunca esperan a los lectores
+class CatalogCache {
+public:
+    using PeliculaSnapshot = CatalogSnapshot<Pelicula>;
+    using SesionSnapshot = CatalogSnapshot<Sesion>;
+    using SalaSnapshot = CatalogSnapshot<SalaInfo>;
+    
+    CatalogCache();
+    
+    // Listas completas. Devuelven nullptr si no se pudieron cargar
+    std::shared_ptr<const PeliculaSnapshot> peliculas();
+    std::shared_ptr<const SesionSnapshot> sesiones();
+    std::shared_ptr<const SalaSnapshot> salas();
+    
+    // Buscar un elemento por id
+    bool getPelicula(int id, Pelicula* pelicula);
+    bool getSesion(int id, Sesion* sesion);
+    bool getSala(int id, SalaInfo* sala);
+    
+    // Marcar una parte como modificada después de escribir en la base de datos
+    void invalidate(CatalogPart part);
+    
+    // Versión de una parte y del catálogo completo (cambia con cualquier parte)
+    uint64_t version(CatalogPart part) const;
+    uint64_t version() const;
+
+private:
+    std::atomic<uint64_t> partVersions[CATALOG_NUM_PARTS];
+    std::atomic<uint64_t> catalogVersion;
+    
+    // Se leen y publican con std::atomic_load / std::atomic_store
+    std::shared_ptr<const PeliculaSnapshot> peliculaSnapshot;
+    std::shared_ptr<const SesionSnapshot> sesionSnapshot;
+    std::shared_ptr<const SalaSnapshot> salaSnapshot;
+    
+    // Una sola carga a la vez por parte
+    std::mutex loadMutexes[CATALOG_NUM_PARTS];
+    
+    template <typename T, typename Loader>
+    std::shared_ptr<const CatalogSnapshot<T>> acquire(std::shared_ptr<const CatalogSnapshot<T>>& slot,
+                                                      CatalogPart part, Loader load);
+};
+
+#endif // CATALOG_CACHE_H
\ No newline at end of file
@@ -0,0 +1,369 @@
+// epoll_reactor.cpp
+#include "epoll_reactor.h"
+#include "../common/socket_compat.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <iostream>
+#include <cstring>
+
+// Máximo de eventos que se recogen en cada epoll_wait
+static const int MAX_EVENTS = 256;
+
+// Si una conexión acumula más salida pendiente que esto se deja de leer de
+// ella hasta que el cliente consuma las respuestas
+static const size_t MAX_PENDING_OUTPUT = 4 * 1024 * 1024;
+
+// Marcas para distinguir los descriptores especiales en epoll_event.data
+static const uint64_t LISTEN_TOKEN = static_cast<uint64_t>(-1);
+static const uint64_t WAKE_TOKEN = static_cast<uint64_t>(-2);
+
+EpollReactor::EpollReactor(int listenSocket, size_t numThreads,
+                           const RequestHandler& onRequest, const CloseHandler& onClose)
+    : listenSocket(listenSocket), numThreads(numThreads > 0 ? numThreads : 1),
+      onRequest(onRequest), onClose(onClose), loops(this->numThreads), stopping(false), openConnections(0) {
+}
+
+EpollReactor::~EpollReactor() {
+    requestStop();
+    for (auto& thread : threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    for (auto& loop : loops) {
+        teardownLoop(loop);
+    }
+}
+
+bool EpollReactor::run() {
+    if (!setSocketNonBlocking(listenSocket)) {
+        std::cerr << "Error al poner el socket de escucha en modo no bloqueante: " << errno << std::endl;
+        return false;
+    }
+    
+    // La tabla de bucles se reserva en el constructor y no cambia de tamaño,
+    // así que requestStop puede recorrerla en cualquier momento
+    for (auto& loop : loops) {
+        if (!setupLoop(loop)) {
+            for (auto& created : loops) {
+                teardownLoop(created);
+            }
+            return false;
+        }
+    }
+    
+    for (size_t i = 0; i < loops.size(); i++) {
+        threads.push_back(std::thread(&EpollReactor::runLoop, this, std::ref(loops[i])));
+    }
+    
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    threads.clear();
+    
+    for (auto& loop : loops) {
+        teardownLoop(loop);
+    }
+    
+    return true;
+}
+
+void EpollReactor::requestStop() {
+    stopping = true;
+    
+    uint64_t one = 1;
+    for (auto& loop : loops) {
+        if (loop.wakeFd >= 0) {
+            ssize_t written = write(loop.wakeFd, &one, sizeof(one));
+            (void)written;
+        }
+    }
+}
+
+size_t EpollReactor::connectionCount() const {
+    return openConnections;
+}
+
+bool EpollReactor::setupLoop(Loop& loop) {
+    loop.epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (loop.epollFd < 0) {
+        std::cerr << "Error al crear la instancia de epoll: " << errno << std::endl;
+        return false;
+    }
+    
+    loop.wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (loop.wakeFd < 0) {
+        std::cerr << "Error al crear el eventfd del reactor: " << errno << std::endl;
+        return false;
+    }
+    
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u64 = WAKE_TOKEN;
+    if (epoll_ctl(loop.epollFd, EPOLL_CTL_ADD, loop.wakeFd, &event) < 0) {
+        return false;
+    }
+    
+    // Todos los hilos escuchan el mismo socket; EPOLLEXCLUSIVE evita que una
+    // conexión entrante despierte a todos a la vez
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLEXCLUSIVE;
+    event.data.u64 = LISTEN_TOKEN;
+    if (epoll_ctl(loop.epollFd, EPOLL_CTL_ADD, listenSocket, &event) < 0) {
+        std::cerr << "Error al registrar el socket de escucha en epoll: " << errno << std::endl;
+        return false;
+    }
+    
+    return true;
+}
+
+void EpollReactor::teardownLoop(Loop& loop) {
+    while (!loop.connections.empty()) {
+        closeConnection(loop, loop.connections.begin()->first);
+    }
+    
+    if (loop.wakeFd >= 0) {
+        close(loop.wakeFd);
+        loop.wakeFd = -1;
+    }
+    
+    if (loop.epollFd >= 0) {
+        close(loop.epollFd);
+        loop.epollFd = -1;
+    }
+}
+
+void EpollReactor::runLoop(Loop& loop) {
+    epoll_event events[MAX_EVENTS];
+    
+    while (!stopping) {
+        int ready = epoll_wait(loop.epollFd, events, MAX_EVENTS, -1);
+        
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Error en epoll_wait: " << errno << std::endl;
+            break;
+        }
+        
+        for (int i = 0; i < ready; i++) {
+            uint64_t token = events[i].data.u64;
+            
+            if (token == WAKE_TOKEN) {
+                continue;
+            }
+            
+            if (token == LISTEN_TOKEN) {
+                acceptConnections(loop);
+                continue;
+            }
+            
+            int socket = static_cast<int>(token);
+            auto it = loop.connections.find(socket);
+            if (it == loop.connections.end()) {
+                continue;
+            }
+            
+            Connection& conn = it->second;
+            bool alive = true;
+            
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                alive = false;
+            }
+            
+            if (alive && (events[i].events & EPOLLIN)) {
+                alive = readFromConnection(loop, conn);
+            }
+            
+            if (alive && (events[i].events & EPOLLOUT)) {
+                alive = flushConnection(loop, conn);
+            }
+            
+            if (!alive) {
+                closeConnection(loop, socket);
+            }
+        }
+    }
+}
+
+void EpollReactor::acceptConnections(Loop& loop) {
+    while (true) {
+        sockaddr_in clientAddr;
+        socklen_t clientAddrSize = sizeof(clientAddr);
+        int clientSocket = accept4(listenSocket, (sockaddr*)&clientAddr, &clientAddrSize,
+                                   SOCK_NONBLOCK | SOCK_CLOEXEC);
+        
+        if (clientSocket < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                std::cerr << "Error al aceptar conexión: " << errno << std::endl;
+            }
+            return;
+        }
+        
+        int noDelay = 1;
+        setsockopt(clientSocket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+        
+        epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+        event.data.u64 = static_cast<uint64_t>(clientSocket);
+        
+        if (epoll_ctl(loop.epollFd, EPOLL_CTL_ADD, clientSocket, &event) < 0) {
+            std::cerr << "Error al registrar el cliente en epoll: " << errno << std::endl;
+            close(clientSocket);
+            continue;
+        }
+        
+        Connection& conn = loop.connections[clientSocket];
+        conn.socket = clientSocket;
+        openConnections++;
+    }
+}
+
+bool EpollReactor::readFromConnection(Loop& loop, Connection& conn) {
+    if (conn.readPaused || conn.peerClosed) {
+        return true;
+    }
+    
+    char buffer[RECEIVE_CHUNK_SIZE];
+    
+    // Modo edge-triggered: hay que vaciar el socket hasta EAGAIN
+    while (true) {
+        ssize_t bytesReceived = recv(conn.socket, buffer, sizeof(buffer), 0);
+        
+        if (bytesReceived > 0) {
+            conn.input.append(buffer, bytesReceived);
+            continue;
+        }
+        
+        if (bytesReceived == 0) {
+            // El cliente cerró su lado: se responde a lo que quedara completo y
+            // la conexión sigue registrada para EPOLLOUT hasta vaciar la salida.
+            // flushConnection la da por terminada cuando ya no queda nada
+            conn.peerClosed = true;
+            if (!processFrames(conn)) {
+                return false;
+            }
+            return flushConnection(loop, conn);
+        }
+        
+        if (errno == EINTR) {
+            continue;
+        }
+        
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        }
+        
+        return false;
+    }
+    
+    if (!processFrames(conn)) {
+        return false;
+    }
+    return flushConnection(loop, conn);
+}
+
+bool EpollReactor::processFrames(Connection& conn) {
+    Message request(OP_ERROR);
+    FrameStatus status;
+    
+    // El formato se consulta en cada trama porque una negociación cambia
+    // cómo deben interpretarse las que vienen detrás en el mismo buffer
+    while ((status = conn.input.nextFrame(conn.format, request)) == FRAME_READY) {
+        if (request.getOpCode() == OP_NEGOTIATE) {
+            // La respuesta sale en el formato anterior; las tramas
+            // siguientes ya se interpretan con el formato acordado
+            conn.output += negotiateWireFormat(request, &conn.format).serialize();
+            continue;
+        }
+        
+        conn.output += *onRequest(request, conn.socket);
+    }
+    
+    // Cabecera binaria inválida: no se puede resincronizar la trama
+    return status != FRAME_INVALID;
+}
+
+bool EpollReactor::flushConnection(Loop& loop, Connection& conn) {
+    while (conn.outputOffset < conn.output.size()) {
+        ssize_t sent = send(conn.socket, conn.output.data() + conn.outputOffset,
+                            conn.output.size() - conn.outputOffset, MSG_NOSIGNAL);
+        
+        if (sent > 0) {
+            conn.outputOffset += sent;
+            continue;
+        }
+        
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        
+        return false;
+    }
+    
+    if (conn.outputOffset == conn.output.size()) {
+        conn.output.clear();
+        conn.outputOffset = 0;
+        
+        if (conn.peerClosed) {
+            return false;
+        }
+    }
+    
+    updateInterest(loop, conn);
+    return true;
+}
+
+void EpollReactor::updateInterest(Loop& loop, Connection& conn) {
+    size_t pending = conn.output.size() - conn.outputOffset;
+    bool wantWritable = pending > 0;
+    bool pauseRead = pending > MAX_PENDING_OUTPUT || conn.peerClosed;
+    
+    if (wantWritable == conn.waitingWritable && pauseRead == conn.readPaused) {
+        return;
+    }
+    
+    conn.waitingWritable = wantWritable;
+    conn.readPaused = pauseRead;
+    
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLRDHUP | EPOLLET;
+    if (!pauseRead) {
+        event.events |= EPOLLIN;
+    }
+    if (wantWritable) {
+        event.events |= EPOLLOUT;
+    }
+    event.data.u64 = static_cast<uint64_t>(conn.socket);
+    
+    // Con EPOLLET, volver a añadir EPOLLIN notifica de nuevo los datos que
+    // quedaron en el socket mientras la lectura estaba detenida
+    epoll_ctl(loop.epollFd, EPOLL_CTL_MOD, conn.socket, &event);
+}
+
+void EpollReactor::closeConnection(Loop& loop, int socket) {
+    auto it = loop.connections.find(socket);
+    if (it == loop.connections.end()) {
+        return;
+    }
+    
+    epoll_ctl(loop.epollFd, EPOLL_CTL_DEL, socket, nullptr);
+    loop.connections.erase(it);
+    openConnections--;
+    
+    if (onClose) {
+        onClose(socket);
+    }
+    close(socket);
+}
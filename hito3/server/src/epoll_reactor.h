@@ -0,0 +1,85 @@
+// epoll_reactor.h
+#ifndef EPOLL_REACTOR_H
+#define EPOLL_REACTOR_H
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <map>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include "../common/protocol.h"
+
+// Motor de red orientado a eventos para Linux (backend NET_BACKEND=epoll).
+// Cada hilo del reactor tiene su propia instancia de epoll y es dueño de las
+// conexiones que acepta, así que el estado de cada conexión no necesita
+// bloqueos. Los sockets son no bloqueantes: se lee hasta EAGAIN acumulando
+// en un buffer por conexión, se procesan todas las tramas completas y las
+// respuestas que no caben en el socket esperan a EPOLLOUT.
+class EpollReactor {
+public:
+    typedef std::function<std::shared_ptr<const std::string>(Message&, int)> RequestHandler;
+    typedef std::function<void(int)> CloseHandler;
+    
+    EpollReactor(int listenSocket, size_t numThreads,
+                 const RequestHandler& onRequest, const CloseHandler& onClose);
+    ~EpollReactor();
+    
+    // Arrancar los hilos y bloquear hasta que se pida la parada
+    bool run();
+    
+    // Pedir la parada de todos los hilos (no bloquea). Solo escribe en los
+    // eventfd, así que se puede llamar desde un manejador de señales, y la
+    // petición vale aunque llegue antes de run()
+    void requestStop();
+    
+    // Número de conexiones abiertas en todos los hilos
+    size_t connectionCount() const;
+
+private:
+    // Estado de una conexión de cliente
+    struct Connection {
+        int socket;
+        ReceiveBuffer input;        // Bytes recibidos pendientes de formar una trama
+        std::string output;         // Respuestas serializadas pendientes de enviar
+        size_t outputOffset;        // Bytes de output ya enviados
+        bool waitingWritable;       // Registrado para EPOLLOUT
+        bool readPaused;            // Lectura detenida por exceso de salida pendiente
+        bool peerClosed;            // El cliente cerró su lado; queda vaciar output
+        WireFormat format;          // Formato de trama acordado con el cliente
+        
+        Connection() : socket(-1), outputOffset(0), waitingWritable(false), readPaused(false),
+                       peerClosed(false), format(WIRE_TEXT) {}
+    };
+    
+    // Estado de cada hilo del reactor
+    struct Loop {
+        int epollFd;
+        int wakeFd;
+        std::map<int, Connection> connections;
+        
+        Loop() : epollFd(-1), wakeFd(-1) {}
+    };
+    
+    int listenSocket;
+    size_t numThreads;
+    RequestHandler onRequest;
+    CloseHandler onClose;
+    std::vector<Loop> loops;
+    std::vector<std::thread> threads;
+    std::atomic<bool> stopping;
+    std::atomic<size_t> openConnections;
+    
+    bool setupLoop(Loop& loop);
+    void runLoop(Loop& loop);
+    void acceptConnections(Loop& loop);
+    bool readFromConnection(Loop& loop, Connection& conn);
+    bool processFrames(Connection& conn);
+    bool flushConnection(Loop& loop, Connection& conn);
+    void updateInterest(Loop& loop, Connection& conn);
+    void closeConnection(Loop& loop, int socket);
+    void teardownLoop(Loop& loop);
+};
+
+#endif // EPOLL_REACTOR_H
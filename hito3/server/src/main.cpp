@@ -1,5 +1,6 @@
 // main.cpp (servidor)
 #include "server.h"
+#include "bridge.h"
 #include <iostream>
 #include <string>
 #include <signal.h>
@@ -7,13 +8,14 @@
 // Instancia global del servidor para poder cerrarlo en la señal de interrupción
 Server* g_server = nullptr;
 
-// Manejador de señales para un cierre limpio
+// Manejador de señales para un cierre limpio. Solo pide la parada, que es
+// segura dentro de una señal; start() vuelve cuando el servidor ha terminado
+// de cerrarse y main sale con normalidad
 void signalHandler(int signal) {
+    (void)signal;
     if (g_server) {
-        std::cout << "Recibida señal de interrupción, cerrando servidor..." << std::endl;
         g_server->stop();
     }
-    exit(0);
 }
 
 int main() {
@@ -21,18 +23,27 @@ int main() {
     
     // Configuración del servidor
     int port = 8080;
+    int workerThreads = 8;
     std::string dbPath = "../../data/cine.db";
     
+    // Leer el puerto y el tamaño del pool de hilos de config.ini
+    if (!bridge_get_server_config(&port, &workerThreads)) {
+        std::cerr << "No se pudo leer la configuración del servidor, usando valores por defecto" << std::endl;
+    }
+    
     // Configurar manejador de señales
     signal(SIGINT, signalHandler);
     
     // Crear e iniciar el servidor
-    Server server(port, dbPath);
+    Server server(port, dbPath, workerThreads);
     g_server = &server;
     
     std::cout << "Iniciando servidor en puerto " << port << "..." << std::endl;
     
-    if (!server.start()) {
+    bool started = server.start();
+    g_server = nullptr;
+    
+    if (!started) {
         std::cerr << "Error al iniciar el servidor" << std::endl;
         return 1;
     }
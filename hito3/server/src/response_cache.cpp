@@ -0,0 +1,51 @@
+// response_cache.cpp
+#include "response_cache.h"
+
+uint64_t ResponseCache::key(OperationCode op, int param, WireFormat format) {
+    return (static_cast<uint64_t>(op) << 40) |
+           (static_cast<uint64_t>(format) << 32) |
+           static_cast<uint32_t>(param);
+}
+
+ResponseCache::Frame ResponseCache::find(OperationCode op, int param, WireFormat format,
+                                         uint64_t version) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    auto it = entries.find(key(op, param, format));
+    if (it == entries.end() || it->second.version != version) {
+        return nullptr;
+    }
+    return it->second.frame;
+}
+
+void ResponseCache::store(OperationCode op, int param, WireFormat format, uint64_t version,
+                          const Frame& frame) {
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    uint64_t entryKey = key(op, param, format);
+    auto it = entries.find(entryKey);
+    if (it != entries.end()) {
+        // Una petición que empezó antes de una escritura no debe pisar la
+        // trama que otra ya generó con la versión nueva
+        if (it->second.version < version) {
+            it->second = {version, frame};
+        }
+        return;
+    }
+    
+    if (entries.size() >= MAX_RESPONSE_CACHE_ENTRIES) {
+        // Hacer sitio quitando las entradas de versiones anteriores
+        for (auto stale = entries.begin(); stale != entries.end(); ) {
+            if (stale->second.version < version) {
+                stale = entries.erase(stale);
+            } else {
+                ++stale;
+            }
+        }
+        if (entries.size() >= MAX_RESPONSE_CACHE_ENTRIES) {
+            return;
+        }
+    }
+    
+    entries.emplace(entryKey, Entry{version, frame});
+}
\ No newline at end of file
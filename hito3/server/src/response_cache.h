@@ -0,0 +1,43 @@
+// response_cache.h
+#ifndef RESPONSE_CACHE_H
+#define RESPONSE_CACHE_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "../common/protocol.h"
+
+// Tramas de respuesta ya codificadas de las lecturas más repetidas del
+// catálogo. Cada entrada se identifica por operación, parámetro (0 si no
+// tiene) y formato de trama, y guarda la versión del catálogo con la que se
+// generó: en cuanto una escritura sube esa versión la entrada deja de servir
+// y la siguiente petición la vuelve a generar
+class ResponseCache {
+public:
+    typedef std::shared_ptr<const std::string> Frame;
+    
+    // Trama guardada para la petición si se generó con la versión indicada,
+    // o nullptr si no hay ninguna o está anticuada
+    Frame find(OperationCode op, int param, WireFormat format, uint64_t version) const;
+    
+    // Guardar la trama generada con una versión del catálogo
+    void store(OperationCode op, int param, WireFormat format, uint64_t version, const Frame& frame);
+
+private:
+    struct Entry {
+        uint64_t version;
+        Frame frame;
+    };
+    
+    std::unordered_map<uint64_t, Entry> entries;
+    mutable std::mutex mutex;
+    
+    static uint64_t key(OperationCode op, int param, WireFormat format);
+};
+
+// Máximo de entradas guardadas (las búsquedas por sala crean una por sala)
+const size_t MAX_RESPONSE_CACHE_ENTRIES = 1024;
+
+#endif // RESPONSE_CACHE_H
\ No newline at end of file
@@ -6,23 +6,44 @@
 #include <iostream>
 #include <sstream>
 #include <thread>
+#include <stdexcept>
 
-Server::Server(int port, const std::string& dbPath) 
-    : serverSocket(-1), port(port), running(false), dbPath(dbPath) {
+// Tamaño máximo de una página de OP_PELICULA_SEARCH_GENEROS
+static const int MAX_PAGINA_GENEROS = 100;
+
+// Géneros que se aceptan en una búsqueda combinada
+static const int MAX_GENEROS_BUSQUEDA = 16;
+
+// Asientos que se aceptan en una retención (RETENCION_MAX_ASIENTOS en hito2).
+// También limita OP_SEAT_BEST, cuyo resultado se suele retener después
+static const int MAX_ASIENTOS_RETENCION = 16;
+
+// Billetes que se aceptan en una venta (VENTA_MAX_BILLETES en hito2)
+static const int MAX_BILLETES_VENTA = 256;
+
+Server::Server(int port, const std::string& dbPath, int numWorkers) 
+    : serverSocket(-1), port(port), stopRequested(false), dbPath(dbPath), numWorkers(numWorkers),
+      activePool(nullptr), closed(false) {
+#ifdef CINE_NET_EPOLL
+    activeReactor = nullptr;
+#endif
     initializeHandlers();
 }
 
 Server::~Server() {
     stop();
+    closeServer();
 }
 
 bool Server::initializeWinsock() {
+#ifdef _WIN32
     WSADATA wsaData;
     int result = WSAStartup(MAKEWORD(2, 2), &wsaData);
     if (result != 0) {
         std::cerr << "WSAStartup failed: " << result << std::endl;
         return false;
     }
+#endif
     return true;
 }
 
@@ -39,6 +60,7 @@ void Server::initializeHandlers() {
     handlers[OP_PELICULA_DELETE] = [this](Message& req, int client) { return handlePeliculaDelete(req, client); };
     handlers[OP_PELICULA_SEARCH_TITULO] = [this](Message& req, int client) { return handlePeliculaSearchTitulo(req, client); };
     handlers[OP_PELICULA_SEARCH_GENERO] = [this](Message& req, int client) { return handlePeliculaSearchGenero(req, client); };
+    handlers[OP_PELICULA_SEARCH_GENEROS] = [this](Message& req, int client) { return handlePeliculaSearchGeneros(req, client); };
     
     // Sesiones
     handlers[OP_SESION_LIST] = [this](Message& req, int client) { return handleSesionList(req, client); };
@@ -49,6 +71,7 @@ void Server::initializeHandlers() {
     handlers[OP_SESION_SEARCH_PELICULA] = [this](Message& req, int client) { return handleSesionSearchPelicula(req, client); };
     handlers[OP_SESION_SEARCH_SALA] = [this](Message& req, int client) { return handleSesionSearchSala(req, client); };
     handlers[OP_SESION_SEARCH_FECHA] = [this](Message& req, int client) { return handleSesionSearchFecha(req, client); };
+    handlers[OP_SESION_SEARCH_RANGO] = [this](Message& req, int client) { return handleSesionSearchRango(req, client); };
     
     // Salas y asientos
     handlers[OP_SALA_LIST] = [this](Message& req, int client) { return handleSalaList(req, client); };
@@ -58,10 +81,17 @@ void Server::initializeHandlers() {
     // Billetes y ventas
     handlers[OP_BILLETE_CREATE] = [this](Message& req, int client) { return handleBilleteCreate(req, client); };
     handlers[OP_BILLETE_DISPONIBILIDAD] = [this](Message& req, int client) { return handleBilleteDisponibilidad(req, client); };
+    handlers[OP_BILLETE_MAPA_OCUPACION] = [this](Message& req, int client) { return handleBilleteMapaOcupacion(req, client); };
     handlers[OP_VENTA_CREATE] = [this](Message& req, int client) { return handleVentaCreate(req, client); };
     handlers[OP_VENTA_LIST_BY_USER] = [this](Message& req, int client) { return handleVentaListByUser(req, client); };
     handlers[OP_VENTA_GET] = [this](Message& req, int client) { return handleVentaGet(req, client); };
     handlers[OP_VENTA_GET_BILLETES] = [this](Message& req, int client) { return handleVentaGetBilletes(req, client); };
+    handlers[OP_SEAT_HOLD] = [this](Message& req, int client) { return handleSeatHold(req, client); };
+    handlers[OP_SEAT_RELEASE] = [this](Message& req, int client) { return handleSeatRelease(req, client); };
+    handlers[OP_SEAT_BEST] = [this](Message& req, int client) { return handleSeatBest(req, client); };
+    
+    // Peticiones agrupadas
+    handlers[OP_BATCH] = [this](Message& req, int client) { return handleBatch(req, client); };
 }
 
 bool Server::start() {
@@ -90,6 +120,12 @@ bool Server::start() {
     serverAddr.sin_port = htons(port);
     serverAddr.sin_addr.s_addr = INADDR_ANY;
     
+#ifndef _WIN32
+    // Permitir reiniciar el servidor sin esperar a que expire TIME_WAIT
+    int reuse = 1;
+    setsockopt(serverSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+#endif
+    
     // Enlazar el socket
     if (bind(serverSocket, (sockaddr*)&serverAddr, sizeof(serverAddr)) == SOCKET_ERROR) {
         std::cerr << "Error al enlazar el socket: " << WSAGetLastError() << std::endl;
@@ -107,33 +143,86 @@ bool Server::start() {
     }
     
     std::cout << "Servidor iniciado en puerto " << port << std::endl;
-    running = true;
-    
-    // Bucle principal para aceptar conexiones
-    while (running) {
-        // Aceptar una conexión entrante
-        sockaddr_in clientAddr;
-        int clientAddrSize = sizeof(clientAddr);
-        int clientSocket = accept(serverSocket, (sockaddr*)&clientAddr, &clientAddrSize);
-        
-        if (clientSocket == INVALID_SOCKET) {
-            std::cerr << "Error al aceptar conexión: " << WSAGetLastError() << std::endl;
-            continue;
-        }
-        
-        // Obtener información del cliente
-        char* clientIP = inet_ntoa(clientAddr.sin_addr);
-        std::cout << "Nueva conexión desde " << clientIP << ":" << ntohs(clientAddr.sin_port) << std::endl;
-        
-        // Crear un hilo para manejar al cliente
-        handleClient(clientSocket);
+    
+#ifdef CINE_NET_EPOLL
+    return runReactor();
+#else
+    return runWorkerPool();
+#endif
+}
+
+bool Server::runWorkerPool() {
+    // Un bucle de espera vigila todas las conexiones y el pool de hilos
+    // atiende solo las que tienen peticiones recibidas
+    workerPool.reset(new WorkerPool(serverSocket, numWorkers,
+        [this](Message& request, int clientSocket) { return encodeResponse(request, clientSocket); },
+        [this](int clientSocket) { removeSession(clientSocket); }));
+    
+    // Si la parada se pidió antes de publicar el pool, se le pasa ahora
+    activePool = workerPool.get();
+    if (stopRequested) {
+        workerPool->requestStop();
     }
     
-    return true;
+    std::cout << "Atendiendo clientes con " << workerPool->size() << " hilos trabajadores" << std::endl;
+    
+    bool result = workerPool->run();
+    
+    // Ningún hilo del pool sigue dentro de un manejador. El pool no se
+    // destruye hasta el final para que stop() pueda seguir usándolo
+    closeServer();
+    return result;
 }
 
+#ifdef CINE_NET_EPOLL
+bool Server::runReactor() {
+    // Unos pocos hilos con epoll atienden todas las conexiones a la vez
+    reactor.reset(new EpollReactor(serverSocket, numWorkers,
+        [this](Message& request, int clientSocket) { return encodeResponse(request, clientSocket); },
+        [this](int clientSocket) { removeSession(clientSocket); }));
+    
+    activeReactor = reactor.get();
+    if (stopRequested) {
+        reactor->requestStop();
+    }
+    
+    std::cout << "Atendiendo clientes con epoll en " << numWorkers << " hilos" << std::endl;
+    
+    bool result = reactor->run();
+    
+    // Ningún hilo del reactor sigue dentro de un manejador
+    closeServer();
+    return result;
+}
+#endif
+
 void Server::stop() {
-    running = false;
+    // Se llama desde el manejador de SIGINT: solo variables atómicas y la
+    // petición de parada del bucle, que escribe en un socket o un eventfd.
+    // El cierre lo hace start() cuando el bucle termina
+    stopRequested = true;
+    
+    WorkerPool* pool = activePool;
+    if (pool) {
+        pool->requestStop();
+    }
+    
+#ifdef CINE_NET_EPOLL
+    EpollReactor* activeLoop = activeReactor;
+    if (activeLoop) {
+        activeLoop->requestStop();
+    }
+#endif
+}
+
+void Server::closeServer() {
+    std::lock_guard<std::mutex> closeLock(closeMutex);
+    if (closed) {
+        return;
+    }
+    closed = true;
+    
+    std::cout << "Cerrando servidor..." << std::endl;
     
     if (serverSocket != INVALID_SOCKET) {
         closesocket(serverSocket);
@@ -149,46 +238,85 @@ void Server::stop() {
     std::cout << "Servidor detenido" << std::endl;
 }
 
-void Server::handleClient(int clientSocket) {
-    while (running) {
-        Message request = receiveMessage(clientSocket);
-        
-        if (request.getOpCode() == OP_ERROR) {
-            std::cout << "Error al recibir mensaje o conexión cerrada" << std::endl;
-            break;
-        }
-        
-        // Buscar el manejador para el código de operación
-        auto it = handlers.find(request.getOpCode());
-        if (it == handlers.end()) {
-            // No hay manejador para esta operación
-            Message response(OP_ERROR, "Operación no soportada");
-            sendMessage(clientSocket, response);
-            continue;
-        }
-        
-        // Ejecutar el manejador
-        Message response = it->second(request, clientSocket);
-        
-        // Enviar la respuesta
-        if (!sendMessage(clientSocket, response)) {
-            std::cout << "Error al enviar respuesta" << std::endl;
-            break;
+Message Server::processRequest(Message& request, int clientSocket) {
+    // Buscar el manejador para el código de operación
+    auto it = handlers.find(request.getOpCode());
+    if (it == handlers.end()) {
+        // No hay manejador para esta operación
+        return request.createResponse(OP_ERROR, ERROR_UNSUPPORTED_OPERATION);
+    }
+    
+    // Ejecutar el manejador. Los campos truncados o mal formados hacen que
+    // Message lance una excepción: se responde con error y la conexión y el
+    // hilo que la atiende siguen funcionando
+    try {
+        return it->second(request, clientSocket);
+    } catch (const std::exception&) {
+        return request.createResponse(OP_ERROR, "Petición mal formada");
+    }
+}
+
+bool Server::cacheableRequest(const Message& request, int* param) const {
+    switch (request.getOpCode()) {
+        case OP_PELICULA_LIST:
+        case OP_SESION_LIST:
+        case OP_SALA_LIST:
+            *param = 0;
+            return true;
+        case OP_SESION_SEARCH_SALA: {
+            // Leer el id de sala de una copia para no mover el cursor de la petición
+            Message copy = request;
+            if (copy.remainingBytes() == 0) {
+                return false;
+            }
+            // Si el id está mal formado, el manejador responde con el error
+            try {
+                *param = copy.getInt();
+            } catch (const std::exception&) {
+                return false;
+            }
+            return true;
         }
+        default:
+            return false;
+    }
+}
+
+ResponseCache::Frame Server::encodeResponse(Message& request, int clientSocket) {
+    int param = 0;
+    if (!cacheableRequest(request, &param)) {
+        return std::make_shared<const std::string>(processRequest(request, clientSocket).serialize());
     }
     
-    // Cerrar la sesión y el socket
-    removeSession(clientSocket);
-    closesocket(clientSocket);
-    std::cout << "Conexión cerrada (socket " << clientSocket << ")" << std::endl;
+    // La versión se lee antes de generar la respuesta: si una escritura llega
+    // mientras tanto, la trama queda guardada con la versión vieja y no se usa
+    OperationCode op = request.getOpCode();
+    WireFormat format = request.getWireFormat();
+    uint64_t version = catalog.version();
+    
+    ResponseCache::Frame frame = responses.find(op, param, format, version);
+    if (frame) {
+        return frame;
+    }
+    
+    Message response = processRequest(request, clientSocket);
+    frame = std::make_shared<const std::string>(response.serialize());
+    
+    // Los errores (p. ej. la base de datos no disponible) no se guardan
+    if (response.getOpCode() == OP_OK) {
+        responses.store(op, param, format, version, frame);
+    }
+    return frame;
 }
 
 bool Server::isSessionActive(int clientSocket) const {
+    std::lock_guard<std::mutex> lock(sessionsMutex);
     return activeSessions.find(clientSocket) != activeSessions.end();
 }
 
 // server.cpp (continuación)
 int Server::getUserIdForSession(int clientSocket) const {
+    std::lock_guard<std::mutex> lock(sessionsMutex);
     auto it = activeSessions.find(clientSocket);
     if (it != activeSessions.end()) {
         return it->second;
@@ -197,10 +325,12 @@ int Server::getUserIdForSession(int clientSocket) const {
 }
 
 void Server::createSession(int clientSocket, int userId) {
+    std::lock_guard<std::mutex> lock(sessionsMutex);
     activeSessions[clientSocket] = userId;
 }
 
 void Server::removeSession(int clientSocket) {
+    std::lock_guard<std::mutex> lock(sessionsMutex);
     activeSessions.erase(clientSocket);
 }
 
@@ -216,7 +346,7 @@ Message Server::handleLogin(Message& request, int clientSocket) {
         // Login exitoso
         createSession(clientSocket, userId);
         
-        Message response(OP_OK);
+        Message response = request.createResponse(OP_OK);
         response.addInt(userId);
         
         // Obtener información del usuario
@@ -229,25 +359,24 @@ Message Server::handleLogin(Message& request, int clientSocket) {
         return response;
     } else {
         // Login fallido
-        return Message(OP_ERROR, "Credenciales incorrectas");
+        return request.createResponse(OP_ERROR, "Credenciales incorrectas");
     }
 }
 
 Message Server::handleLogout(Message& request, int clientSocket) {
     removeSession(clientSocket);
-    return Message(OP_OK);
+    return request.createResponse(OP_OK);
 }
 
 Message Server::handlePeliculaList(Message& request, int clientSocket) {
-    std::vector<Pelicula> peliculas;
-    int numPeliculas = 0;
+    auto peliculas = catalog.peliculas();
     
-    if (bridge_pelicula_list(&peliculas, &numPeliculas)) {
-        Message response(OP_OK);
-        serializePeliculaList(peliculas, response);
+    if (peliculas) {
+        Message response = request.createResponse(OP_OK);
+        serializePeliculaList(peliculas->items, response);
         return response;
     } else {
-        return Message(OP_ERROR, "Error al listar películas");
+        return request.createResponse(OP_ERROR, "Error al listar películas");
     }
 }
 
@@ -255,74 +384,77 @@ Message Server::handlePeliculaGet(Message& request, int clientSocket) {
     int id = request.getInt();
     
     Pelicula pelicula;
-    if (bridge_pelicula_get_by_id(id, &pelicula)) {
-        Message response(OP_OK);
+    if (catalog.getPelicula(id, &pelicula)) {
+        Message response = request.createResponse(OP_OK);
         pelicula.serialize(response);
         return response;
     } else {
-        return Message(OP_ERROR, "Película no encontrada");
+        return request.createResponse(OP_ERROR, "Película no encontrada");
     }
 }
 
 Message Server::handlePeliculaCreate(Message& request, int clientSocket) {
     if (!isSessionActive(clientSocket)) {
-        return Message(OP_ERROR, "No hay sesión activa");
+        return request.createResponse(OP_ERROR, "No hay sesión activa");
     }
     
     // Verificar si el usuario es administrador
     int userId = getUserIdForSession(clientSocket);
     if (!bridge_user_is_admin(userId)) {
-        return Message(OP_ERROR, "No tiene permisos para esta operación");
+        return request.createResponse(OP_ERROR, "No tiene permisos para esta operación");
     }
     
     Pelicula pelicula = Pelicula::deserialize(request);
     
     if (bridge_pelicula_create(&pelicula)) {
-        Message response(OP_OK);
+        catalog.invalidate(CATALOG_PELICULAS);
+        Message response = request.createResponse(OP_OK);
         response.addInt(pelicula.getId());
         return response;
     } else {
-        return Message(OP_ERROR, "Error al crear película");
+        return request.createResponse(OP_ERROR, "Error al crear película");
     }
 }
 
 Message Server::handlePeliculaUpdate(Message& request, int clientSocket) {
     if (!isSessionActive(clientSocket)) {
-        return Message(OP_ERROR, "No hay sesión activa");
+        return request.createResponse(OP_ERROR, "No hay sesión activa");
     }
     
     // Verificar si el usuario es administrador
     int userId = getUserIdForSession(clientSocket);
     if (!bridge_user_is_admin(userId)) {
-        return Message(OP_ERROR, "No tiene permisos para esta operación");
+        return request.createResponse(OP_ERROR, "No tiene permisos para esta operación");
     }
     
     Pelicula pelicula = Pelicula::deserialize(request);
     
     if (bridge_pelicula_update(&pelicula)) {
-        return Message(OP_OK);
+        catalog.invalidate(CATALOG_PELICULAS);
+        return request.createResponse(OP_OK);
     } else {
-        return Message(OP_ERROR, "Error al actualizar película");
+        return request.createResponse(OP_ERROR, "Error al actualizar película");
     }
 }
 
 Message Server::handlePeliculaDelete(Message& request, int clientSocket) {
     if (!isSessionActive(clientSocket)) {
-        return Message(OP_ERROR, "No hay sesión activa");
+        return request.createResponse(OP_ERROR, "No hay sesión activa");
     }
     
     // Verificar si el usuario es administrador
     int userId = getUserIdForSession(clientSocket);
     if (!bridge_user_is_admin(userId)) {
-        return Message(OP_ERROR, "No tiene permisos para esta operación");
+        return request.createResponse(OP_ERROR, "No tiene permisos para esta operación");
     }
     
     int id = request.getInt();
     
     if (bridge_pelicula_delete(id)) {
-        return Message(OP_OK);
+        catalog.invalidate(CATALOG_PELICULAS);
+        return request.createResponse(OP_OK);
     } else {
-        return Message(OP_ERROR, "Error al eliminar película");
+        return request.createResponse(OP_ERROR, "Error al eliminar película");
     }
 }
 
@@ -333,11 +465,11 @@ Message Server::handlePeliculaSearchTitulo(Message& request, int clientSocket) {
     int numPeliculas = 0;
     
     if (bridge_pelicula_search_by_titulo(titulo.c_str(), &peliculas, &numPeliculas)) {
-        Message response(OP_OK);
+        Message response = request.createResponse(OP_OK);
         serializePeliculaList(peliculas, response);
         return response;
     } else {
-        return Message(OP_ERROR, "Error en la búsqueda");
+        return request.createResponse(OP_ERROR, "Error en la búsqueda");
     }
 }
 
@@ -348,24 +480,60 @@ Message Server::handlePeliculaSearchGenero(Message& request, int clientSocket) {
     int numPeliculas = 0;
     
     if (bridge_pelicula_search_by_genero(genero.c_str(), &peliculas, &numPeliculas)) {
-        Message response(OP_OK);
+        Message response = request.createResponse(OP_OK);
+        serializePeliculaList(peliculas, response);
+        return response;
+    } else {
+        return request.createResponse(OP_ERROR, "Error en la búsqueda");
+    }
+}
+
+Message Server::handlePeliculaSearchGeneros(Message& request, int clientSocket) {
+    bool todos = request.getBool();
+    int desde = request.getInt();
+    int limite = request.getInt();
+    int numGeneros = request.getInt();
+    
+    if (numGeneros < 1 || numGeneros > MAX_GENEROS_BUSQUEDA) {
+        return request.createResponse(OP_ERROR, "Número de géneros inválido");
+    }
+    
+    std::vector<std::string> generos;
+    generos.reserve(numGeneros);
+    for (int i = 0; i < numGeneros; i++) {
+        generos.push_back(request.getString());
+    }
+    
+    // Las páginas tienen un tamaño acotado aunque se pidan sin límite
+    if (desde < 0) {
+        desde = 0;
+    }
+    if (limite <= 0 || limite > MAX_PAGINA_GENEROS) {
+        limite = MAX_PAGINA_GENEROS;
+    }
+    
+    std::vector<Pelicula> peliculas;
+    int total = 0;
+    
+    if (bridge_pelicula_search_by_generos(generos, todos, desde, limite, &peliculas, &total)) {
+        Message response = request.createResponse(OP_OK);
+        response.addInt(total);
         serializePeliculaList(peliculas, response);
         return response;
     } else {
-        return Message(OP_ERROR, "Error en la búsqueda");
+        return request.createResponse(OP_ERROR, "Error en la búsqueda");
     }
 }
 
 Message Server::handleSesionList(Message& request, int clientSocket) {
-    std::vector<Sesion> sesiones;
-    int numSesiones = 0;
+    auto sesiones = catalog.sesiones();
     
-    if (bridge_sesion_list(&sesiones, &numSesiones)) {
-        Message response(OP_OK);
-        serializeSesionList(sesiones, response);
+    if (sesiones) {
+        Message response = request.createResponse(OP_OK);
+        serializeSesionList(sesiones->items, response);
         return response;
     } else {
-        return Message(OP_ERROR, "Error al listar sesiones");
+        return request.createResponse(OP_ERROR, "Error al listar sesiones");
     }
 }
 
@@ -373,74 +541,77 @@ Message Server::handleSesionGet(Message& request, int clientSocket) {
     int id = request.getInt();
     
     Sesion sesion;
-    if (bridge_sesion_get_by_id(id, &sesion)) {
-        Message response(OP_OK);
+    if (catalog.getSesion(id, &sesion)) {
+        Message response = request.createResponse(OP_OK);
         sesion.serialize(response);
         return response;
     } else {
-        return Message(OP_ERROR, "Sesión no encontrada");
+        return request.createResponse(OP_ERROR, "Sesión no encontrada");
     }
 }
 
 Message Server::handleSesionCreate(Message& request, int clientSocket) {
     if (!isSessionActive(clientSocket)) {
-        return Message(OP_ERROR, "No hay sesión activa");
+        return request.createResponse(OP_ERROR, "No hay sesión activa");
     }
     
     // Verificar si el usuario es administrador
     int userId = getUserIdForSession(clientSocket);
     if (!bridge_user_is_admin(userId)) {
-        return Message(OP_ERROR, "No tiene permisos para esta operación");
+        return request.createResponse(OP_ERROR, "No tiene permisos para esta operación");
     }
     
     Sesion sesion = Sesion::deserialize(request);
     
     if (bridge_sesion_create(&sesion)) {
-        Message response(OP_OK);
+        catalog.invalidate(CATALOG_SESIONES);
+        Message response = request.createResponse(OP_OK);
         response.addInt(sesion.getId());
         return response;
     } else {
-        return Message(OP_ERROR, "Error al crear sesión");
+        return request.createResponse(OP_ERROR, "Error al crear sesión");
     }
 }
 
 Message Server::handleSesionUpdate(Message& request, int clientSocket) {
     if (!isSessionActive(clientSocket)) {
-        return Message(OP_ERROR, "No hay sesión activa");
+        return request.createResponse(OP_ERROR, "No hay sesión activa");
     }
     
     // Verificar si el usuario es administrador
     int userId = getUserIdForSession(clientSocket);
     if (!bridge_user_is_admin(userId)) {
-        return Message(OP_ERROR, "No tiene permisos para esta operación");
+        return request.createResponse(OP_ERROR, "No tiene permisos para esta operación");
     }
     
     Sesion sesion = Sesion::deserialize(request);
     
     if (bridge_sesion_update(&sesion)) {
-        return Message(OP_OK);
+        catalog.invalidate(CATALOG_SESIONES);
+        return request.createResponse(OP_OK);
     } else {
-        return Message(OP_ERROR, "Error al actualizar sesión");
+        return request.createResponse(OP_ERROR, "Error al actualizar sesión");
     }
 }
 
 Message Server::handleSesionDelete(Message& request, int clientSocket) {
     if (!isSessionActive(clientSocket)) {
-        return Message(OP_ERROR, "No hay sesión activa");
+        return request.createResponse(OP_ERROR, "No hay sesión activa");
     }
     
     // Verificar si el usuario es administrador
     int userId = getUserIdForSession(clientSocket);
     if (!bridge_user_is_admin(userId)) {
-        return Message(OP_ERROR, "No tiene permisos para esta operación");
+        return request.createResponse(OP_ERROR, "No tiene permisos para esta operación");
     }
     
     int id = request.getInt();
     
     if (bridge_sesion_delete(id)) {
-        return Message(OP_OK);
+        catalog.invalidate(CATALOG_SESIONES);
+        return request.createResponse(OP_OK);
     } else {
-        return Message(OP_ERROR, "Error al eliminar sesión");
+        return request.createResponse(OP_ERROR, "Error al eliminar sesión");
     }
 }
 
@@ -451,26 +622,33 @@ Message Server::handleSesionSearchPelicula(Message& request, int clientSocket) {
     int numSesiones = 0;
     
     if (bridge_sesion_search_by_pelicula(peliculaId, &sesiones, &numSesiones)) {
-        Message response(OP_OK);
+        Message response = request.createResponse(OP_OK);
         serializeSesionList(sesiones, response);
         return response;
     } else {
-        return Message(OP_ERROR, "Error en la búsqueda");
+        return request.createResponse(OP_ERROR, "Error en la búsqueda");
     }
 }
 
 Message Server::handleSesionSearchSala(Message& request, int clientSocket) {
     int salaId = request.getInt();
     
-    std::vector<Sesion> sesiones;
-    int numSesiones = 0;
+    // Las sesiones de la caché ya están ordenadas por hora de inicio
+    auto todas = catalog.sesiones();
     
-    if (bridge_sesion_search_by_sala(salaId, &sesiones, &numSesiones)) {
-        Message response(OP_OK);
+    if (todas) {
+        std::vector<Sesion> sesiones;
+        for (const auto& sesion : todas->items) {
+            if (sesion.getSalaId() == salaId) {
+                sesiones.push_back(sesion);
+            }
+        }
+        
+        Message response = request.createResponse(OP_OK);
         serializeSesionList(sesiones, response);
         return response;
     } else {
-        return Message(OP_ERROR, "Error en la búsqueda");
+        return request.createResponse(OP_ERROR, "Error en la búsqueda");
     }
 }
 
@@ -481,11 +659,64 @@ Message Server::handleSesionSearchFecha(Message& request, int clientSocket) {
     int numSesiones = 0;
     
     if (bridge_sesion_search_by_fecha(fecha.c_str(), &sesiones, &numSesiones)) {
-        Message response(OP_OK);
+        Message response = request.createResponse(OP_OK);
+        serializeSesionList(sesiones, response);
+        return response;
+    } else {
+        return request.createResponse(OP_ERROR, "Error en la búsqueda");
+    }
+}
+
+Message Server::handleSesionSearchRango(Message& request, int clientSocket) {
+    int64_t desde = request.getInt64();
+    int64_t hasta = request.getInt64();
+    int salaId = request.getInt();
+    int peliculaId = request.getInt();
+    int limite = request.getInt();
+    
+    if (hasta < desde) {
+        return request.createResponse(OP_ERROR, "Rango de horas inválido");
+    }
+    
+    std::vector<Sesion> sesiones;
+    int numSesiones = 0;
+    
+    if (bridge_sesion_search_by_rango(desde, hasta, salaId, peliculaId, limite, &sesiones, &numSesiones)) {
+        Message response = request.createResponse(OP_OK);
         serializeSesionList(sesiones, response);
         return response;
     } else {
-        return Message(OP_ERROR, "Error en la búsqueda");
+        return request.createResponse(OP_ERROR, "Error en la búsqueda");
+    }
+}
+
+Message Server::handleSalaList(Message& request, int clientSocket) {
+    auto salas = catalog.salas();
+    
+    if (salas) {
+        Message response = request.createResponse(OP_OK);
+        response.addInt(static_cast<int>(salas->items.size()));
+        for (const auto& sala : salas->items) {
+            response.addInt(sala.id);
+            response.addInt(sala.numAsientos);
+        }
+        return response;
+    } else {
+        return request.createResponse(OP_ERROR, "Error al listar salas");
+    }
+}
+
+Message Server::handleSalaGet(Message& request, int clientSocket) {
+    int id = request.getInt();
+    
+    SalaInfo sala;
+    if (catalog.getSala(id, &sala)) {
+        Message response = request.createResponse(OP_OK);
+        response.addInt(sala.id);
+        response.addInt(sala.numAsientos);
+        return response;
+    } else {
+        return request.createResponse(OP_ERROR, "Sala no encontrada");
     }
 }
 
@@ -498,20 +729,43 @@ Message Server::handleBilleteDisponibilidad(Message& request, int clientSocket)
     
     bool disponible = bridge_billete_esta_disponible(sesionId, asientoId);
     
-    Message response(OP_OK);
+    Message response = request.createResponse(OP_OK);
     response.addBool(disponible);
     return response;
 }
 
+Message Server::handleBilleteMapaOcupacion(Message& request, int clientSocket) {
+    int sesionId = request.getInt();
+    
+    int salaId = 0;
+    int numAsientos = 0;
+    std::string mapa;
+    
+    if (bridge_billete_mapa_ocupacion(sesionId, &salaId, &numAsientos, &mapa)) {
+        Message response = request.createResponse(OP_OK);
+        response.addInt(salaId);
+        response.addInt(numAsientos);
+        response.addBytes(mapa);
+        return response;
+    } else {
+        return request.createResponse(OP_ERROR, "Sesión no encontrada");
+    }
+}
+
 Message Server::handleVentaCreate(Message& request, int clientSocket) {
     if (!isSessionActive(clientSocket)) {
-        return Message(OP_ERROR, "No hay sesión activa");
+        return request.createResponse(OP_ERROR, "No hay sesión activa");
     }
     
     int userId = getUserIdForSession(clientSocket);
     
-    // Leer los datos de la venta
+    // Leer los datos de la venta. Sin billetes solo es válida si compra una
+    // retención, que se comprueba después de leerlos
     int numBilletes = request.getInt();
+    if (numBilletes < 0 || numBilletes > MAX_BILLETES_VENTA) {
+        return request.createResponse(OP_ERROR, "Número de billetes no válido");
+    }
+    
     std::vector<int> sesionIds(numBilletes);
     std::vector<int> asientoIds(numBilletes);
     
@@ -522,20 +776,118 @@ Message Server::handleVentaCreate(Message& request, int clientSocket) {
     
     double descuento = request.getDouble();
     
-    int ventaId = bridge_venta_create(userId, sesionIds.data(), asientoIds.data(), numBilletes, descuento);
+    // Opcionalmente, una retención del usuario cuyos asientos se compran
+    // (0 si no hay). Se compra o la retención o la lista de billetes, nunca
+    // las dos: los billetes no se descartan en silencio
+    int retencionId = request.hasMoreData() ? request.getInt() : 0;
+    
+    if (retencionId < 0) {
+        return request.createResponse(OP_ERROR, "Retención no válida");
+    }
+    if (numBilletes > 0 && retencionId > 0) {
+        return request.createResponse(OP_ERROR, "La venta lleva billetes y una retención a la vez");
+    }
+    if (numBilletes == 0 && retencionId == 0) {
+        return request.createResponse(OP_ERROR, "Número de billetes no válido");
+    }
+    
+    int ventaId;
+    if (retencionId > 0) {
+        ventaId = bridge_venta_create_from_hold(userId, retencionId, descuento);
+    } else {
+        ventaId = bridge_venta_create(userId, sesionIds.data(), asientoIds.data(), numBilletes, descuento);
+    }
     
     if (ventaId > 0) {
-        Message response(OP_OK);
+        Message response = request.createResponse(OP_OK);
         response.addInt(ventaId);
         return response;
     } else {
-        return Message(OP_ERROR, "Error al crear la venta");
+        return request.createResponse(OP_ERROR, "Error al crear la venta");
+    }
+}
+
+Message Server::handleSeatHold(Message& request, int clientSocket) {
+    if (!isSessionActive(clientSocket)) {
+        return request.createResponse(OP_ERROR, "No hay sesión activa");
+    }
+    
+    int userId = getUserIdForSession(clientSocket);
+    
+    int sesionId = request.getInt();
+    int segundos = request.getInt();
+    int numAsientos = request.getInt();
+    
+    if (numAsientos <= 0 || numAsientos > MAX_ASIENTOS_RETENCION) {
+        return request.createResponse(OP_ERROR, "Número de asientos no válido");
+    }
+    
+    std::vector<int> asientoIds(numAsientos);
+    for (int i = 0; i < numAsientos; i++) {
+        asientoIds[i] = request.getInt();
+    }
+    
+    // retencion_crear vuelve a comprobar el límite de forma atómica; esto
+    // solo distingue el motivo en el mensaje de error
+    if (!bridge_seat_hold_fits(userId, numAsientos)) {
+        return request.createResponse(OP_ERROR, "Demasiados asientos retenidos");
+    }
+    
+    int retencionId = 0;
+    int64_t vence = 0;
+    
+    if (bridge_seat_hold(userId, sesionId, asientoIds, segundos, &retencionId, &vence)) {
+        Message response = request.createResponse(OP_OK);
+        response.addInt(retencionId);
+        response.addInt64(vence);
+        return response;
+    } else {
+        return request.createResponse(OP_ERROR, "Los asientos no están disponibles");
+    }
+}
+
+Message Server::handleSeatRelease(Message& request, int clientSocket) {
+    if (!isSessionActive(clientSocket)) {
+        return request.createResponse(OP_ERROR, "No hay sesión activa");
+    }
+    
+    int userId = getUserIdForSession(clientSocket);
+    int retencionId = request.getInt();
+    
+    if (bridge_seat_release(userId, retencionId)) {
+        return request.createResponse(OP_OK);
+    } else {
+        return request.createResponse(OP_ERROR, "Retención no encontrada");
+    }
+}
+
+Message Server::handleSeatBest(Message& request, int clientSocket) {
+    int sesionId = request.getInt();
+    int numAsientos = request.getInt();
+    
+    if (numAsientos <= 0 || numAsientos > MAX_ASIENTOS_RETENCION) {
+        return request.createResponse(OP_ERROR, "Número de asientos no válido");
+    }
+    
+    std::vector<int> asientoIds;
+    int fila = 0;
+    
+    if (bridge_seat_best(sesionId, numAsientos, &asientoIds, &fila)) {
+        Message response = request.createResponse(OP_OK);
+        response.addInt(fila);
+        response.addInt(static_cast<int>(asientoIds.size()));
+        for (int asientoId : asientoIds) {
+            response.addInt(asientoId);
+        }
+        return response;
+    } else {
+        return request.createResponse(OP_ERROR, "No hay asientos contiguos disponibles");
     }
 }
 
 Message Server::handleVentaListByUser(Message& request, int clientSocket) {
     if (!isSessionActive(clientSocket)) {
-        return Message(OP_ERROR, "No hay sesión activa");
+        return request.createResponse(OP_ERROR, "No hay sesión activa");
     }
     
     int userId = getUserIdForSession(clientSocket);
@@ -547,7 +899,7 @@ Message Server::handleVentaListByUser(Message& request, int clientSocket) {
     int numVentas = 0;
     
     if (bridge_venta_list_by_user(userId, &ventaIds, &fechas, &totales, &numVentas)) {
-        Message response(OP_OK);
+        Message response = request.createResponse(OP_OK);
         
         response.addInt(numVentas);
         
@@ -559,6 +911,32 @@ Message Server::handleVentaListByUser(Message& request, int clientSocket) {
         
         return response;
     } else {
-        return Message(OP_ERROR, "Error al obtener las ventas");
+        return request.createResponse(OP_ERROR, "Error al obtener las ventas");
+    }
+}
+
+Message Server::handleBatch(Message& request, int clientSocket) {
+    int numPeticiones = request.getInt();
+    
+    if (numPeticiones < 0 || numPeticiones > MAX_BATCH_SIZE) {
+        return request.createResponse(OP_ERROR, "Número de peticiones agrupadas no válido");
     }
+    
+    // Cada petición se atiende con su manejador normal y su respuesta se
+    // anida en el mismo orden, dentro de una única trama de respuesta
+    Message response = request.createResponse(OP_OK);
+    response.addInt(numPeticiones);
+    
+    for (int i = 0; i < numPeticiones; i++) {
+        Message subRequest = request.getMessage();
+        
+        if (subRequest.getOpCode() == OP_BATCH || subRequest.getOpCode() == OP_NEGOTIATE) {
+            response.addMessage(subRequest.createResponse(OP_ERROR, "Operación no permitida dentro de un lote"));
+            continue;
+        }
+        
+        response.addMessage(processRequest(subRequest, clientSocket));
+    }
+    
+    return response;
 }
\ No newline at end of file
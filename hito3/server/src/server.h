@@ -2,31 +2,83 @@
 #ifndef SERVER_H
 #define SERVER_H
 
-#include <winsock2.h>
-#include <ws2tcpip.h>
+#include "../common/socket_compat.h"
 #include <string>
 #include <thread> 
 #include <vector>
 #include <map>
+#include <mutex>
+#include <atomic>
+#include <memory>
 #include <functional>
 #include "../common/protocol.h"
+#include "worker_pool.h"
+#include "catalog_cache.h"
+#include "response_cache.h"
+
+#ifdef CINE_NET_EPOLL
+#include "epoll_reactor.h"
+#endif
 
 class Server {
 private:
     int serverSocket;
     int port;
-    bool running;
+    std::atomic<bool> stopRequested;
     std::string dbPath;
-    
-    // Mapa de manejadores de operaciones
+    int numWorkers;
+    
+    // Bucle de espera con pool de hilos que atiende las peticiones recibidas
+    // (backend portable)
+    std::unique_ptr<WorkerPool> workerPool;
+    
+#ifdef CINE_NET_EPOLL
+    // Reactor epoll que multiplexa todas las conexiones (backend Linux)
+    std::unique_ptr<EpollReactor> reactor;
+#endif
+    
+    // Bucle en marcha, para que stop() le pida parar sin tocar los unique_ptr.
+    // Viven hasta que se destruye el servidor
+    std::atomic<WorkerPool*> activePool;
+#ifdef CINE_NET_EPOLL
+    std::atomic<EpollReactor*> activeReactor;
+#endif
+    
+    // El cierre de sockets y base de datos se hace una sola vez
+    bool closed;
+    std::mutex closeMutex;
+    
+    // Mapa de manejadores de operaciones. Se rellena en el constructor y después
+    // solo se consulta, por lo que los hilos trabajadores lo leen sin bloqueo
     std::map<OperationCode, std::function<Message(Message&, int)>> handlers;
     
+    // Caché de películas, sesiones y salas. Los manejadores de escritura la
+    // invalidan cuando la base de datos cambia
+    CatalogCache catalog;
+    
+    // Respuestas ya codificadas de las lecturas del catálogo más repetidas
+    ResponseCache responses;
+    
+    // Indicar si la respuesta a una petición se puede reutilizar y con qué
+    // parámetro se guarda
+    bool cacheableRequest(const Message& request, int* param) const;
+    
     // Inicialización de WinSock
     bool initializeWinsock();
     
     // Inicializar los manejadores de operaciones
     void initializeHandlers();
     
+    // Cerrar el socket de escucha y la base de datos cuando los hilos que
+    // atienden a los clientes ya han terminado
+    void closeServer();
+    
+    // Bucles de atención según el backend de red elegido al compilar
+    bool runWorkerPool();
+#ifdef CINE_NET_EPOLL
+    bool runReactor();
+#endif
+    
     // Manejadores de operaciones específicas
     Message handleLogin(Message& request, int clientSocket);
     Message handleLogout(Message& request, int clientSocket);
@@ -39,6 +91,7 @@ private:
     Message handlePeliculaDelete(Message& request, int clientSocket);
     Message handlePeliculaSearchTitulo(Message& request, int clientSocket);
     Message handlePeliculaSearchGenero(Message& request, int clientSocket);
+    Message handlePeliculaSearchGeneros(Message& request, int clientSocket);
     
     // Manejadores de sesiones
     Message handleSesionList(Message& request, int clientSocket);
@@ -49,6 +102,7 @@ private:
     Message handleSesionSearchPelicula(Message& request, int clientSocket);
     Message handleSesionSearchSala(Message& request, int clientSocket);
     Message handleSesionSearchFecha(Message& request, int clientSocket);
+    Message handleSesionSearchRango(Message& request, int clientSocket);
     
     // Manejadores de salas
     Message handleSalaList(Message& request, int clientSocket);
@@ -58,26 +112,40 @@ private:
     // Manejadores de billetes y ventas
     Message handleBilleteCreate(Message& request, int clientSocket);
     Message handleBilleteDisponibilidad(Message& request, int clientSocket);
+    Message handleBilleteMapaOcupacion(Message& request, int clientSocket);
     Message handleVentaCreate(Message& request, int clientSocket);
     Message handleVentaListByUser(Message& request, int clientSocket);
     Message handleVentaGet(Message& request, int clientSocket);
     Message handleVentaGetBilletes(Message& request, int clientSocket);
+    Message handleSeatHold(Message& request, int clientSocket);
+    Message handleSeatRelease(Message& request, int clientSocket);
+    Message handleSeatBest(Message& request, int clientSocket);
+    
+    // Manejador de peticiones agrupadas
+    Message handleBatch(Message& request, int clientSocket);
     
     // Registro de sesiones activas (ID cliente -> ID usuario)
     std::map<int, int> activeSessions;
+    mutable std::mutex sessionsMutex;
 
 public:
-    Server(int port = 8080, const std::string& dbPath = "../../data/cine.db");
+    Server(int port = 8080, const std::string& dbPath = "../../data/cine.db", int numWorkers = 8);
     ~Server();
     
     // Iniciar el servidor
     bool start();
     
-    // Detener el servidor
+    // Pedir que el servidor se detenga. No bloquea ni reserva memoria, así
+    // que se puede llamar desde un manejador de señales: start() vuelve y
+    // cierra todo cuando sus hilos terminan
     void stop();
     
-    // Manejar un cliente
-    void handleClient(int clientSocket);
+    // Procesar una petición con su manejador y devolver la respuesta
+    Message processRequest(Message& request, int clientSocket);
+    
+    // Obtener la trama de respuesta a una petición: la guardada si sigue
+    // siendo válida o la que genera su manejador
+    ResponseCache::Frame encodeResponse(Message& request, int clientSocket);
     
     // Verificar si hay una sesión activa para un cliente
     bool isSessionActive(int clientSocket) const;
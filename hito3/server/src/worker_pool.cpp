@@ -0,0 +1,299 @@
+// worker_pool.cpp
+#include "worker_pool.h"
+#include "../common/socket_compat.h"
+#include <iostream>
+
+WorkerPool::WorkerPool(int listenSocket, size_t numWorkers,
+                       const RequestHandler& onRequest, const CloseHandler& onClose)
+    : listenSocket(listenSocket), numWorkers(numWorkers > 0 ? numWorkers : 1),
+      onRequest(onRequest), onClose(onClose), stopping(false), wakeSocket(INVALID_SOCKET) {
+    // Se abre aquí y no en run() para que requestStop funcione desde el
+    // principio, aunque llegue antes de que arranque el bucle
+    openWakeSocket();
+}
+
+WorkerPool::~WorkerPool() {
+    requestStop();
+    closeAll();
+    if (wakeSocket != INVALID_SOCKET) {
+        closesocket(wakeSocket);
+    }
+}
+
+bool WorkerPool::openWakeSocket() {
+    wakeSocket = socket(AF_INET, SOCK_DGRAM, 0);
+    if (wakeSocket == INVALID_SOCKET) {
+        std::cerr << "Error al crear el socket de aviso del pool: " << WSAGetLastError() << std::endl;
+        return false;
+    }
+
+    // Enlazarlo a un puerto libre de loopback y conectarlo consigo mismo:
+    // send() sobre él despierta al poll que lo vigila, también en Windows
+    sockaddr_in addr;
+    addr.sin_family = AF_INET;
+    addr.sin_port = 0;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addrSize = sizeof(addr);
+    
+    if (bind(wakeSocket, (sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR ||
+        getsockname(wakeSocket, (sockaddr*)&addr, &addrSize) == SOCKET_ERROR ||
+        connect(wakeSocket, (sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR ||
+        !setSocketNonBlocking(wakeSocket)) {
+        std::cerr << "Error al preparar el socket de aviso del pool: " << WSAGetLastError() << std::endl;
+        closesocket(wakeSocket);
+        wakeSocket = INVALID_SOCKET;
+        return false;
+    }
+    
+    return true;
+}
+
+void WorkerPool::wake() {
+    // Si el buffer del socket está lleno ya hay avisos pendientes
+    char signal = 1;
+    send(wakeSocket, &signal, 1, 0);
+}
+
+bool WorkerPool::run() {
+    if (wakeSocket == INVALID_SOCKET) {
+        return false;
+    }
+    
+    if (!setSocketNonBlocking(listenSocket)) {
+        std::cerr << "Error al poner el socket de escucha en modo no bloqueante: " << WSAGetLastError() << std::endl;
+        return false;
+    }
+    
+    for (size_t i = 0; i < numWorkers; i++) {
+        workers.push_back(std::thread(&WorkerPool::workerLoop, this));
+    }
+    
+    pollLoop();
+    
+    // Despertar a los hilos que esperan trabajo y desbloquear a los que
+    // están enviando una respuesta a un cliente lento
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        for (auto& entry : connections) {
+            shutdown(entry.first, SD_BOTH);
+        }
+    }
+    queueCondition.notify_all();
+    
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers.clear();
+    
+    closeAll();
+    return true;
+}
+
+void WorkerPool::requestStop() {
+    stopping = true;
+    if (wakeSocket != INVALID_SOCKET) {
+        wake();
+    }
+}
+
+size_t WorkerPool::pendingCount() {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return readySockets.size();
+}
+
+size_t WorkerPool::size() const {
+    return numWorkers;
+}
+
+void WorkerPool::pollLoop() {
+    std::vector<pollfd> fds;
+    char drain[64];
+    
+    while (!stopping) {
+        // Vigilar el aviso, el socket de escucha y las conexiones inactivas.
+        // Las que cerró un hilo trabajador se cierran aquí, donde se vigilan
+        fds.clear();
+        
+        pollfd entry;
+        entry.events = POLLIN;
+        entry.revents = 0;
+        entry.fd = wakeSocket;
+        fds.push_back(entry);
+        entry.fd = listenSocket;
+        fds.push_back(entry);
+        
+        std::vector<int> closed;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            for (auto& pair : connections) {
+                if (pair.second.closing) {
+                    closed.push_back(pair.first);
+                } else if (!pair.second.busy) {
+                    entry.fd = pair.first;
+                    fds.push_back(entry);
+                }
+            }
+        }
+        
+        for (int socket : closed) {
+            closeConnection(socket);
+        }
+        if (!closed.empty()) {
+            continue;
+        }
+        
+        int ready = poll(fds.data(), fds.size(), -1);
+        if (ready == SOCKET_ERROR) {
+            if (WSAGetLastError() == EINTR) {
+                continue;
+            }
+            std::cerr << "Error en poll: " << WSAGetLastError() << std::endl;
+            break;
+        }
+        
+        if (fds[0].revents != 0) {
+            while (recv(wakeSocket, drain, sizeof(drain), 0) > 0) {
+            }
+        }
+        
+        if (fds[1].revents != 0) {
+            acceptConnections();
+        }
+        
+        // Pasar a los hilos las conexiones con datos o cerradas por el cliente
+        size_t queued = 0;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            for (size_t i = 2; i < fds.size(); i++) {
+                if (fds[i].revents == 0) {
+                    continue;
+                }
+                connections[fds[i].fd].busy = true;
+                readySockets.push(fds[i].fd);
+                queued++;
+            }
+        }
+        
+        for (size_t i = 0; i < queued; i++) {
+            queueCondition.notify_one();
+        }
+    }
+}
+
+void WorkerPool::acceptConnections() {
+    while (true) {
+        sockaddr_in clientAddr;
+        socklen_t clientAddrSize = sizeof(clientAddr);
+        int clientSocket = accept(listenSocket, (sockaddr*)&clientAddr, &clientAddrSize);
+        
+        if (clientSocket == INVALID_SOCKET) {
+            if (WSAGetLastError() == EINTR) {
+                continue;
+            }
+            if (!socketWouldBlock()) {
+                std::cerr << "Error al aceptar conexión: " << WSAGetLastError() << std::endl;
+            }
+            return;
+        }
+        
+        // Los hilos trabajadores envían las respuestas con send() bloqueante
+        setSocketBlocking(clientSocket);
+        
+        std::lock_guard<std::mutex> lock(queueMutex);
+        connections[clientSocket].socket = clientSocket;
+    }
+}
+
+void WorkerPool::workerLoop() {
+    while (true) {
+        // La conexión está marcada como ocupada: el nodo del mapa no se borra
+        // ni lo usa otro hilo hasta que se devuelva
+        Connection* conn;
+        
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait(lock, [this] { return stopping || !readySockets.empty(); });
+            
+            if (stopping) {
+                return;
+            }
+            
+            conn = &connections[readySockets.front()];
+            readySockets.pop();
+        }
+        
+        bool alive = serveConnection(*conn);
+        
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            conn->busy = false;
+            conn->closing = !alive;
+        }
+        wake();
+    }
+}
+
+bool WorkerPool::serveConnection(Connection& conn) {
+    // poll indicó que hay datos, así que recv no se bloquea. Se lee una vez
+    // y, si queda más, el bucle de espera la vuelve a entregar
+    char buffer[RECEIVE_CHUNK_SIZE];
+    int bytesReceived = recv(conn.socket, buffer, sizeof(buffer), 0);
+    if (bytesReceived <= 0) {
+        return false;
+    }
+    conn.input.append(buffer, bytesReceived);
+    
+    // Atender todas las tramas completas y enviar las respuestas juntas
+    std::string output;
+    Message request(OP_ERROR);
+    FrameStatus status;
+    
+    while ((status = conn.input.nextFrame(conn.format, request)) == FRAME_READY) {
+        if (request.getOpCode() == OP_NEGOTIATE) {
+            // La respuesta sale en el formato anterior; las tramas
+            // siguientes ya se interpretan con el formato acordado
+            output += negotiateWireFormat(request, &conn.format).serialize();
+            continue;
+        }
+        
+        output += *onRequest(request, conn.socket);
+    }
+    
+    if (!output.empty() && !sendFrame(conn.socket, output)) {
+        return false;
+    }
+    
+    // Cabecera binaria inválida: no se puede resincronizar la trama
+    return status != FRAME_INVALID;
+}
+
+void WorkerPool::closeConnection(int socket) {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        connections.erase(socket);
+    }
+    
+    if (onClose) {
+        onClose(socket);
+    }
+    closesocket(socket);
+}
+
+void WorkerPool::closeAll() {
+    std::vector<int> sockets;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        for (auto& pair : connections) {
+            sockets.push_back(pair.first);
+        }
+        while (!readySockets.empty()) {
+            readySockets.pop();
+        }
+    }
+    
+    for (int socket : sockets) {
+        closeConnection(socket);
+    }
+}
\ No newline at end of file
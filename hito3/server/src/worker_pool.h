@@ -0,0 +1,85 @@
+// worker_pool.h
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+#include <vector>
+#include <map>
+#include <atomic>
+#include <functional>
+#include "../common/protocol.h"
+
+// Backend de red portable (NET_BACKEND=threads, el único disponible en
+// Windows). Un bucle de espera vigila con poll/WSAPoll el socket de escucha
+// y todas las conexiones inactivas; cuando una conexión tiene datos se pasa
+// a un pool de hilos de tamaño fijo, que atiende las peticiones ya recibidas
+// y la devuelve al bucle. Así un hilo nunca queda ocupado por un cliente que
+// mantiene la conexión abierta sin enviar nada.
+class WorkerPool {
+public:
+    typedef std::function<std::shared_ptr<const std::string>(Message&, int)> RequestHandler;
+    typedef std::function<void(int)> CloseHandler;
+    
+    WorkerPool(int listenSocket, size_t numWorkers,
+               const RequestHandler& onRequest, const CloseHandler& onClose);
+    ~WorkerPool();
+    
+    // Arrancar los hilos trabajadores y ejecutar el bucle de espera hasta
+    // que se pida la parada. Al volver, todas las conexiones están cerradas
+    bool run();
+    
+    // Pedir la parada (no bloquea). Solo escribe en un socket, así que se
+    // puede llamar desde un manejador de señales
+    void requestStop();
+    
+    // Número de conexiones con datos esperando un hilo libre
+    size_t pendingCount();
+    
+    size_t size() const;
+
+private:
+    // Estado de una conexión de cliente
+    struct Connection {
+        int socket;
+        ReceiveBuffer input;        // Bytes recibidos pendientes de formar una trama
+        WireFormat format;          // Formato de trama acordado con el cliente
+        bool busy;                  // La está atendiendo un hilo trabajador
+        bool closing;               // El hilo que la atendía la ha dado por cerrada
+        
+        Connection() : socket(-1), format(WIRE_TEXT), busy(false), closing(false) {}
+    };
+    
+    int listenSocket;
+    size_t numWorkers;
+    RequestHandler onRequest;
+    CloseHandler onClose;
+    std::vector<std::thread> workers;
+    std::atomic<bool> stopping;
+    
+    // Socket UDP conectado a sí mismo que despierta al bucle de espera
+    int wakeSocket;
+    
+    // Conexiones abiertas y conexiones listas para un hilo. El bucle de
+    // espera solo vigila las que no están ocupadas; mientras un hilo atiende
+    // una conexión nadie más la toca, así que se usa sin el mutex
+    std::map<int, Connection> connections;
+    std::queue<int> readySockets;
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    
+    bool openWakeSocket();
+    void wake();
+    void pollLoop();
+    void acceptConnections();
+    void workerLoop();
+    bool serveConnection(Connection& conn);
+    void closeConnection(int socket);
+    void closeAll();
+};
+
+#endif // WORKER_POOL_H
\ No newline at end of file